@@ -2,6 +2,12 @@
 #define BGL_H
 
 #include "BGLCommon.h"
+#include "BGLHash.h"
+#include "BGLArena.h"
+#include "BGLShared.h"
+#include "BGLParallel.h"
+#include "BGLCancel.h"
+#include "BGLCpu.h"
 #include "BGLAffine.h"
 #include "BGLBounds.h"
 
@@ -10,11 +16,16 @@
 #include "BGLPath.h"
 #include "BGLSimpleRegion.h"
 #include "BGLCompoundRegion.h"
+#include "BGLSimplifier.h"
+#include "BGLSerialize.h"
+#include "BGLCompact.h"
 
 #include "BGLIntersection.h"
 
 #include "BGLPoint3d.h"
 #include "BGLTriangle3d.h"
+#include "BGLAffine3d.h"
+#include "BGLSliceKernel.h"
 #include "BGLMesh3d.h"
 
 #endif
@@ -37,6 +37,9 @@ public:
     Affine& rotateAroundPoint(double radang, double x, double y);
 
     void transformPoint(double& x, double &y) const;
+    bool isIdentity() const {
+        return (a == 1.0 && b == 0.0 && c == 0.0 && d == 1.0 && tx == 0.0 && ty == 0.0);
+    }
 };
 
 
@@ -0,0 +1,132 @@
+//
+//  BGLAffine3d.cc
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/27/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+
+#include "BGLAffine3d.h"
+
+namespace BGL {
+
+Affine3d Affine3d::translationAffine(double dx, double dy, double dz)
+{
+    return Affine3d(1.0, 0.0, 0.0, dx,
+                    0.0, 1.0, 0.0, dy,
+                    0.0, 0.0, 1.0, dz);
+}
+
+
+
+Affine3d Affine3d::scalingAffine(double sx, double sy, double sz)
+{
+    return Affine3d(sx,  0.0, 0.0, 0.0,
+                    0.0, sy,  0.0, 0.0,
+                    0.0, 0.0, sz,  0.0);
+}
+
+
+
+Affine3d Affine3d::rotationXAffine(double radang)
+{
+    double cosv = cos(radang);
+    double sinv = sin(radang);
+    return Affine3d(1.0, 0.0,   0.0,  0.0,
+                    0.0, cosv, -sinv, 0.0,
+                    0.0, sinv,  cosv, 0.0);
+}
+
+
+
+Affine3d Affine3d::rotationYAffine(double radang)
+{
+    double cosv = cos(radang);
+    double sinv = sin(radang);
+    return Affine3d( cosv, 0.0, sinv, 0.0,
+                     0.0,  1.0, 0.0,  0.0,
+                    -sinv, 0.0, cosv, 0.0);
+}
+
+
+
+Affine3d Affine3d::rotationZAffine(double radang)
+{
+    double cosv = cos(radang);
+    double sinv = sin(radang);
+    return Affine3d(cosv, -sinv, 0.0, 0.0,
+                    sinv,  cosv, 0.0, 0.0,
+                    0.0,   0.0,  1.0, 0.0);
+}
+
+
+
+// Follows this transform with aff.
+Affine3d& Affine3d::transform(const Affine3d& aff)
+{
+    Affine3d old(*this);
+    xx = aff.xx * old.xx  +  aff.xy * old.yx  +  aff.xz * old.zx;
+    xy = aff.xx * old.xy  +  aff.xy * old.yy  +  aff.xz * old.zy;
+    xz = aff.xx * old.xz  +  aff.xy * old.yz  +  aff.xz * old.zz;
+    tx = aff.xx * old.tx  +  aff.xy * old.ty  +  aff.xz * old.tz  +  aff.tx;
+
+    yx = aff.yx * old.xx  +  aff.yy * old.yx  +  aff.yz * old.zx;
+    yy = aff.yx * old.xy  +  aff.yy * old.yy  +  aff.yz * old.zy;
+    yz = aff.yx * old.xz  +  aff.yy * old.yz  +  aff.yz * old.zz;
+    ty = aff.yx * old.tx  +  aff.yy * old.ty  +  aff.yz * old.tz  +  aff.ty;
+
+    zx = aff.zx * old.xx  +  aff.zy * old.yx  +  aff.zz * old.zx;
+    zy = aff.zx * old.xy  +  aff.zy * old.yy  +  aff.zz * old.zy;
+    zz = aff.zx * old.xz  +  aff.zy * old.yz  +  aff.zz * old.zz;
+    tz = aff.zx * old.tx  +  aff.zy * old.ty  +  aff.zz * old.tz  +  aff.tz;
+    return *this;
+}
+
+
+
+Affine3d& Affine3d::translate(double dx, double dy, double dz)
+{
+    return transform(translationAffine(dx,dy,dz));
+}
+
+
+
+Affine3d& Affine3d::scale(double sx, double sy, double sz)
+{
+    return transform(scalingAffine(sx,sy,sz));
+}
+
+
+
+Affine3d& Affine3d::rotateX(double radang)
+{
+    return transform(rotationXAffine(radang));
+}
+
+
+
+Affine3d& Affine3d::rotateY(double radang)
+{
+    return transform(rotationYAffine(radang));
+}
+
+
+
+Affine3d& Affine3d::rotateZ(double radang)
+{
+    return transform(rotationZAffine(radang));
+}
+
+
+
+Affine3d& Affine3d::rotateZAroundPoint(double radang, const Point3d& center)
+{
+    translate(-center.x, -center.y, -center.z);
+    rotateZ(radang);
+    translate(center.x, center.y, center.z);
+    return *this;
+}
+
+}
+
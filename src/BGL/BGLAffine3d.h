@@ -0,0 +1,93 @@
+//
+//  BGLAffine3d.h
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/27/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+
+#ifndef BGL_AFFINE3D_H
+#define BGL_AFFINE3D_H
+
+#include <math.h>
+#include "config.h"
+#include "BGLAffine.h"
+#include "BGLPoint3d.h"
+#include "BGLTriangle3d.h"
+
+namespace BGL {
+
+
+// A 3D affine transform, as a 3x4 matrix.  A point becomes
+//    x' = xx*x + xy*y + xz*z + tx
+//  and likewise for y' and z'.  Each of translate(), scale(), and the
+//  rotations adds a step after those already in it, so a transform
+//  can be built up in the order the steps are to be done, and then
+//  done all at once.
+class Affine3d {
+public:
+    double xx, xy, xz, tx;
+    double yx, yy, yz, ty;
+    double zx, zy, zz, tz;
+
+    // Constructors
+    Affine3d()
+        : xx(1.0), xy(0.0), xz(0.0), tx(0.0),
+          yx(0.0), yy(1.0), yz(0.0), ty(0.0),
+          zx(0.0), zy(0.0), zz(1.0), tz(0.0)
+    {}
+    Affine3d(double XX, double XY, double XZ, double TX,
+             double YX, double YY, double YZ, double TY,
+             double ZX, double ZY, double ZZ, double TZ)
+        : xx(XX), xy(XY), xz(XZ), tx(TX),
+          yx(YX), yy(YY), yz(YZ), ty(TY),
+          zx(ZX), zy(ZY), zz(ZZ), tz(TZ)
+    {}
+    // A 2D transform, done in the XY plane, leaving Z alone.
+    Affine3d(const Affine& aff)
+        : xx(aff.a), xy(aff.b), xz(0.0), tx(aff.tx),
+          yx(aff.c), yy(aff.d), yz(0.0), ty(aff.ty),
+          zx(0.0), zy(0.0), zz(1.0), tz(0.0)
+    {}
+
+    static Affine3d translationAffine(double dx, double dy, double dz);
+    static Affine3d scalingAffine(double sx, double sy, double sz);
+    static Affine3d rotationXAffine(double radang);
+    static Affine3d rotationYAffine(double radang);
+    static Affine3d rotationZAffine(double radang);
+
+    Affine3d& transform(const Affine3d& aff);
+    Affine3d& translate(double dx, double dy, double dz);
+    Affine3d& scale(double sx, double sy, double sz);
+    Affine3d& rotateX(double radang);
+    Affine3d& rotateY(double radang);
+    Affine3d& rotateZ(double radang);
+    Affine3d& rotateZAroundPoint(double radang, const Point3d& center);
+
+    void transformPoint(Point3d& pt) const {
+        double nx = xx * pt.x + xy * pt.y + xz * pt.z + tx;
+        double ny = yx * pt.x + yy * pt.y + yz * pt.z + ty;
+        double nz = zx * pt.x + zy * pt.y + zz * pt.z + tz;
+        pt.x = nx;
+        pt.y = ny;
+        pt.z = nz;
+    }
+    void transformTriangle(Triangle3d& tri) const {
+        transformPoint(tri.vertex1);
+        transformPoint(tri.vertex2);
+        transformPoint(tri.vertex3);
+    }
+    bool isIdentity() const {
+        return (xx == 1.0 && xy == 0.0 && xz == 0.0 && tx == 0.0 &&
+                yx == 0.0 && yy == 1.0 && yz == 0.0 && ty == 0.0 &&
+                zx == 0.0 && zy == 0.0 && zz == 1.0 && tz == 0.0);
+    }
+};
+
+
+
+}
+
+#endif
+
@@ -0,0 +1,202 @@
+//
+//  BGLArena.cc
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/14/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <mutex>
+#include <atomic>
+#include "BGLArena.h"
+
+namespace BGL {
+
+
+const size_t Arena::DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+// Every arena allocation is rounded up to keep doubles aligned.
+static const size_t ARENA_ALIGN = sizeof(double);
+
+// Tag stored in front of every block handed out by the ArenaAllocator.
+//  A NULL owner means the block came from the heap.
+union ArenaTag {
+    Arena* owner;
+    double align;
+};
+
+static __thread Arena* currentArena = NULL;
+
+// Spare default sized chunks, linked through their headers.  The
+//  counts are atomic so they can be checked without taking the lock.
+static std::mutex spareMutex;
+static void* spareChunks = NULL;
+static std::atomic<size_t> spareCount(0);
+static std::atomic<size_t> spareLimit(0);
+
+
+
+Arena::Arena(size_t chunkSz)
+    : chunks(NULL), cursor(NULL), limit(NULL), chunkSize(chunkSz), bytesUsed(0)
+{
+}
+
+
+
+Arena::~Arena()
+{
+    release();
+}
+
+
+
+std::shared_ptr<Arena> Arena::create(size_t chunkSz)
+{
+    std::shared_ptr<Arena> arena(new Arena(chunkSz));
+    arena->self = arena;
+    return arena;
+}
+
+
+
+void* Arena::allocate(size_t bytes)
+{
+    bytes = (bytes + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if (cursor == NULL || (size_t)(limit - cursor) < bytes) {
+        // Oversized requests get a chunk of their own, so that they
+        //  don't waste the remainder of the current chunk.
+        size_t size = chunkSize;
+        if (bytes > chunkSize / 4) {
+            size = bytes;
+        }
+        size_t hdrsize = (sizeof(Chunk) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+        Chunk* chunk = NULL;
+        if (size == DEFAULT_CHUNK_SIZE && spareCount > 0) {
+            std::lock_guard<std::mutex> lock(spareMutex);
+            if (spareChunks) {
+                chunk = (Chunk*)spareChunks;
+                spareChunks = chunk->next;
+                spareCount--;
+            }
+        }
+        if (chunk == NULL) {
+            chunk = (Chunk*)malloc(hdrsize + size);
+        }
+        if (chunk == NULL) {
+            throw std::bad_alloc();
+        }
+        chunk->size = size;
+        char* data = (char*)chunk + hdrsize;
+        if (size == chunkSize || cursor == NULL) {
+            chunk->next = chunks;
+            chunks = chunk;
+            cursor = data;
+            limit = data + size;
+        } else {
+            // Keep bumping through the current chunk afterwards.
+            chunk->next = chunks->next;
+            chunks->next = chunk;
+            bytesUsed += bytes;
+            return data;
+        }
+    }
+    void* ptr = cursor;
+    cursor += bytes;
+    bytesUsed += bytes;
+    return ptr;
+}
+
+
+
+void Arena::release()
+{
+    while (chunks) {
+        Chunk* next = chunks->next;
+        if (chunks->size == DEFAULT_CHUNK_SIZE && spareCount < spareLimit) {
+            std::lock_guard<std::mutex> lock(spareMutex);
+            if (spareCount < spareLimit) {
+                chunks->next = (Chunk*)spareChunks;
+                spareChunks = chunks;
+                spareCount++;
+                chunks = next;
+                continue;
+            }
+        }
+        free(chunks);
+        chunks = next;
+    }
+    cursor = limit = NULL;
+    bytesUsed = 0;
+}
+
+
+
+void Arena::setSpareChunkLimit(size_t count)
+{
+    std::lock_guard<std::mutex> lock(spareMutex);
+    spareLimit = count;
+    while (spareCount > spareLimit) {
+        Chunk* chunk = (Chunk*)spareChunks;
+        spareChunks = chunk->next;
+        free(chunk);
+        spareCount--;
+    }
+}
+
+
+
+size_t Arena::spareChunkCount()
+{
+    std::lock_guard<std::mutex> lock(spareMutex);
+    return spareCount;
+}
+
+
+
+Arena* Arena::current()
+{
+    return currentArena;
+}
+
+
+
+Arena* Arena::setCurrent(Arena* arena)
+{
+    Arena* prev = currentArena;
+    currentArena = arena;
+    return prev;
+}
+
+
+
+void* Arena::allocateTagged(size_t bytes)
+{
+    Arena* arena = currentArena;
+    ArenaTag* tag;
+    if (arena) {
+        tag = (ArenaTag*)arena->allocate(sizeof(ArenaTag) + bytes);
+    } else {
+        tag = (ArenaTag*)::operator new(sizeof(ArenaTag) + bytes);
+    }
+    tag->owner = arena;
+    return tag + 1;
+}
+
+
+
+void Arena::deallocateTagged(void* ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    ArenaTag* tag = ((ArenaTag*)ptr) - 1;
+    if (tag->owner == NULL) {
+        ::operator delete(tag);
+    }
+    // Arena blocks are reclaimed when their arena is released.
+}
+
+
+}
+
@@ -0,0 +1,149 @@
+//
+//  BGLArena.h
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/14/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#ifndef BGL_ARENA_H
+#define BGL_ARENA_H
+
+#include <stddef.h>
+#include <new>
+#include <memory>
+#include <utility>
+#include "config.h"
+
+namespace BGL {
+
+
+// A bump allocator for short-lived geometry.  Memory handed out by an
+//  Arena is never returned piecemeal; it is all freed in one shot when
+//  the arena is released or destroyed.  An Arena is not thread-safe, so
+//  only one thread at a time may allocate from it.
+class Arena {
+private:
+    struct Chunk {
+        Chunk* next;
+        size_t size;
+    };
+
+    Chunk* chunks;
+    char* cursor;
+    char* limit;
+    size_t chunkSize;
+    size_t bytesUsed;
+    std::weak_ptr<Arena> self;
+
+    // Arenas own their memory, and can't be copied.
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+
+public:
+    static const size_t DEFAULT_CHUNK_SIZE;
+
+    Arena(size_t chunkSz = DEFAULT_CHUNK_SIZE);
+    ~Arena();
+
+    // Arenas made by create() are reference counted, so that geometry
+    //  shared out of them can keep them alive.  handle() is empty for
+    //  arenas that were made any other way.
+    static std::shared_ptr<Arena> create(size_t chunkSz = DEFAULT_CHUNK_SIZE);
+    std::shared_ptr<Arena> handle() const { return self.lock(); }
+
+    void* allocate(size_t bytes);
+    void release();
+    size_t bytesAllocated() const { return bytesUsed; }
+
+    // Released chunks of the default size can be kept on a process-wide
+    //  spare list, up to this many, and handed to the next arena that
+    //  needs one, instead of going back to malloc.  Off (0) by default.
+    static void setSpareChunkLimit(size_t count);
+    static size_t spareChunkCount();
+
+    // The current arena is per-thread.  When none is set, the
+    //  ArenaAllocator falls back to the global heap.
+    static Arena* current();
+    static Arena* setCurrent(Arena* arena);
+
+    static void* allocateTagged(size_t bytes);
+    static void deallocateTagged(void* ptr);
+};
+
+
+
+// Makes the given arena current for this thread for the life of the scope.
+class ArenaScope {
+private:
+    Arena* previous;
+
+    ArenaScope(const ArenaScope&);
+    ArenaScope& operator=(const ArenaScope&);
+
+public:
+    ArenaScope(Arena* arena) : previous(Arena::setCurrent(arena)) {}
+    ~ArenaScope() { Arena::setCurrent(previous); }
+};
+
+
+
+// STL allocator that takes memory from the calling thread's current Arena,
+//  or from the heap if there isn't one.  Each block remembers where it came
+//  from, so all instances compare equal, and containers can freely mix and
+//  exchange nodes regardless of which arena was current when they were made.
+template <class T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <class U> struct rebind {
+        typedef ArenaAllocator<U> other;
+    };
+
+    ArenaAllocator() {}
+    ArenaAllocator(const ArenaAllocator&) {}
+    template <class U> ArenaAllocator(const ArenaAllocator<U>&) {}
+
+    pointer address(reference x) const { return &x; }
+    const_pointer address(const_reference x) const { return &x; }
+
+    pointer allocate(size_type n, const void* hint = 0) {
+        return static_cast<pointer>(Arena::allocateTagged(n * sizeof(T)));
+    }
+    void deallocate(pointer p, size_type n) {
+        Arena::deallocateTagged(p);
+    }
+    size_type max_size() const {
+        return ((size_type)-1) / sizeof(T);
+    }
+
+    template <class U, class... Args>
+    void construct(U* p, Args&&... args) { ::new((void*)p) U(std::forward<Args>(args)...); }
+    template <class U>
+    void destroy(U* p) { p->~U(); }
+};
+
+template <class T, class U>
+inline bool operator==(const ArenaAllocator<T>&, const ArenaAllocator<U>&)
+{
+    return true;
+}
+
+template <class T, class U>
+inline bool operator!=(const ArenaAllocator<T>&, const ArenaAllocator<U>&)
+{
+    return false;
+}
+
+
+}
+
+#endif
+
@@ -0,0 +1,93 @@
+//
+//  BGLCancel.cc
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/28/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#include <chrono>
+#include "BGLCancel.h"
+
+namespace BGL {
+
+
+static __thread const CancelScope* currentScope = NULL;
+
+
+
+static int64_t nanosecondsNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+
+void Cancellation::setDeadline(double seconds)
+{
+    deadline.store(seconds > 0.0 ? nanosecondsNow() + (int64_t)(seconds * 1e9) : 0, std::memory_order_relaxed);
+}
+
+
+
+// A passed deadline is remembered as cancelled, so the clock is only
+//  read until then.
+bool Cancellation::isCancelled() const
+{
+    if (cancelled.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    int64_t when = deadline.load(std::memory_order_relaxed);
+    if (when != 0 && nanosecondsNow() >= when) {
+        cancelled.store(true, std::memory_order_relaxed);
+        return true;
+    }
+    return parent && parent->isCancelled();
+}
+
+
+
+CancelScope::CancelScope(const Cancellation *c)
+    : cancellation(c), outer(currentScope), previous(currentScope)
+{
+    currentScope = this;
+}
+
+
+
+CancelScope::CancelScope(const Cancellation *c, const CancelScope *from)
+    : cancellation(c), outer(from), previous(currentScope)
+{
+    currentScope = this;
+}
+
+
+
+CancelScope::~CancelScope()
+{
+    currentScope = previous;
+}
+
+
+
+bool CancelScope::isCancelled() const
+{
+    for (const CancelScope *scope = this; scope; scope = scope->outer) {
+        if (scope->cancellation && scope->cancellation->isCancelled()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+
+const CancelScope* CancelScope::current()
+{
+    return currentScope;
+}
+
+
+}
+
@@ -0,0 +1,88 @@
+//
+//  BGLCancel.h
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/28/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#ifndef BGL_CANCEL_H
+#define BGL_CANCEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "config.h"
+
+namespace BGL {
+
+
+// Asks for some work to stop early, either right away with cancel(),
+//  or once a deadline passes.  Cancelling a parent cancels everything
+//  under it too, so a job can be cancelled along with all of its
+//  layers.  Any thread may cancel, or ask, at any time.  A copy starts
+//  out fresh, with no parent, and not cancelled.
+class Cancellation {
+private:
+    mutable std::atomic<bool> cancelled;
+    std::atomic<int64_t> deadline;
+    const Cancellation *parent;
+
+public:
+    Cancellation() : cancelled(false), deadline(0), parent(NULL) {}
+    Cancellation(const Cancellation&) : cancelled(false), deadline(0), parent(NULL) {}
+    Cancellation& operator=(const Cancellation&) { return *this; }
+
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+    // Cancels once this many seconds from now have gone by.  Zero or
+    //  less clears the deadline.
+    void setDeadline(double seconds);
+    // The parent must outlive this.
+    void setParent(const Cancellation *p) { parent = p; }
+
+    bool isCancelled() const;
+};
+
+
+
+// Makes a cancellation one that BGL checks on this thread, for the life
+//  of the scope.  Scopes nest, and work is cancelled if any of them
+//  are.  A scope may instead carry on from another thread's, as when a
+//  helper does part of a loop for it, and is then cancelled with it.
+class CancelScope {
+private:
+    const Cancellation *cancellation;
+    const CancelScope *outer;
+    const CancelScope *previous;
+
+    CancelScope(const CancelScope&);
+    CancelScope& operator=(const CancelScope&);
+
+public:
+    CancelScope(const Cancellation *c);
+    CancelScope(const Cancellation *c, const CancelScope *from);
+    ~CancelScope();
+
+    bool isCancelled() const;
+
+    // The innermost scope on this thread, or NULL if there's none.
+    static const CancelScope* current();
+};
+
+
+
+// Whether the work this thread is doing has been cancelled.  Long
+//  loops in BGL check this every so often, and give up early if so,
+//  leaving a partial result that's only good for throwing away.  Cheap
+//  enough to call often; when nothing's cancellable, it's next to free.
+inline bool cancelRequested()
+{
+    const CancelScope *scope = CancelScope::current();
+    return scope && scope->isCancelled();
+}
+
+
+}
+
+#endif
+
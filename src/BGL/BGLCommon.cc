@@ -1,20 +0,0 @@
-//
-//  BGLCommon.m
-//  Part of the Belfry Geometry Library
-//
-//  Created by GM on 10/13/10.
-//  Copyright 2010 Belfry Software. All rights reserved.
-//
-
-#include "BGLCommon.h"
-
-
-namespace BGL {
-
-
-float EPSILON = 1e-14;
-float CLOSEENOUGH = 1e-9;
-
-
-}
-
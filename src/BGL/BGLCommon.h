@@ -9,13 +9,53 @@
 #ifndef BGL_COMMON_H
 #define BGL_COMMON_H
 
+#include <math.h>
+#include <stdint.h>
 #include "config.h"
 
 namespace BGL {
 
 
-extern float EPSILON;
-extern float CLOSEENOUGH;
+// Coordinate traits.  Points, Lines and Triangle3ds are templated on
+//  one of these, which gives the type each coordinate is stored in, how
+//  to turn it to and from a double for calculations, and how close two
+//  coordinates must be to count as the same.
+
+// Plain doubles, as BGL has always used.  The tolerances are the float
+//  values BGL has always had, so results don't move.
+struct DoubleCoord {
+    typedef double value_type;
+    static constexpr double epsilon() { return 1e-14f; }
+    static constexpr double closeEnough() { return 1e-9f; }
+    static double toDouble(double v) { return v; }
+    static double fromDouble(double v) { return v; }
+};
+
+// Floats, for half the memory on big meshes.  A float only has about
+//  seven digits, so the tolerances are scaled to suit.
+struct FloatCoord {
+    typedef float value_type;
+    static constexpr double epsilon() { return 1e-6; }
+    static constexpr double closeEnough() { return 1e-4; }
+    static double toDouble(float v) { return v; }
+    static float fromDouble(double v) { return (float)v; }
+};
+
+// Fixed point, in whole nanometers, for exact sums and comparisons.
+//  Values are converted to and from millimeters as doubles, and only
+//  equal values count as the same.
+struct FixedCoord {
+    typedef int64_t value_type;
+    static constexpr double unit() { return 1e-6; }
+    static constexpr double epsilon() { return 0.5e-6; }
+    static constexpr double closeEnough() { return 0.5e-6; }
+    static double toDouble(int64_t v) { return v * unit(); }
+    static int64_t fromDouble(double v) { return llround(v / unit()); }
+};
+
+// The tolerances for the default, double, coordinates.
+constexpr double EPSILON = DoubleCoord::epsilon();
+constexpr double CLOSEENOUGH = DoubleCoord::closeEnough();
 
 typedef enum {
     USED = 0,
@@ -0,0 +1,280 @@
+//
+//  BGLCompact.cc
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/24/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#include <math.h>
+#include <string.h>
+#include "BGLCompact.h"
+
+namespace BGL {
+
+
+// Every segment takes at least one byte for each coordinate.
+static const size_t MIN_SEGMENT_BYTES = 2;
+
+
+
+void CompactWriter::writeVarint(uint64_t val)
+{
+    while (val >= 0x80) {
+        buf.push_back((char)(val | 0x80));
+        val >>= 7;
+    }
+    buf.push_back((char)val);
+}
+
+
+
+// Doubles are written whole, low byte first.
+void CompactWriter::writeDouble(double val)
+{
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    for (int i = 0; i < 8; i++) {
+        buf.push_back((char)(bits >> (8 * i)));
+    }
+}
+
+
+
+void CompactWriter::writePoint(const Point &pt)
+{
+    int64_t x = llround(pt.x / quantum);
+    int64_t y = llround(pt.y / quantum);
+    writeSigned(x - lastX);
+    writeSigned(y - lastY);
+    lastX = x;
+    lastY = y;
+}
+
+
+
+void CompactWriter::write(const Path &path)
+{
+    uint32_t encoding = COMPACT_PATH_CHAINED;
+    Lines::const_iterator it;
+    Lines::const_iterator prev = path.segments.end();
+    for (it = path.segments.begin(); it != path.segments.end(); prev = it++) {
+        if (prev != path.segments.end() &&
+            (llround(prev->endPt.x / quantum) != llround(it->startPt.x / quantum) ||
+             llround(prev->endPt.y / quantum) != llround(it->startPt.y / quantum))) {
+            encoding &= ~COMPACT_PATH_CHAINED;
+        }
+        if (it->flags != 0 || it->temperature != 0.0 || it->extrusionWidth != 0.0) {
+            encoding |= COMPACT_PATH_ATTRIBUTES;
+        }
+    }
+
+    writeVarint(path.flags);
+    writeVarint(path.segments.size());
+    writeVarint(encoding);
+    for (it = path.segments.begin(); it != path.segments.end(); it++) {
+        if (it == path.segments.begin() || !(encoding & COMPACT_PATH_CHAINED)) {
+            writePoint(it->startPt);
+        }
+        writePoint(it->endPt);
+    }
+    if (encoding & COMPACT_PATH_ATTRIBUTES) {
+        for (it = path.segments.begin(); it != path.segments.end(); it++) {
+            writeSigned(it->flags);
+            writeDouble(it->temperature);
+            writeDouble(it->extrusionWidth);
+        }
+    }
+}
+
+
+
+void CompactWriter::write(const Paths &paths)
+{
+    writeVarint(paths.size());
+    Paths::const_iterator it;
+    for (it = paths.begin(); it != paths.end(); it++) {
+        write(*it);
+    }
+}
+
+
+
+void CompactWriter::write(const SimpleRegion &reg)
+{
+    writeDouble(reg.zLevel);
+    write(reg.outerPath);
+    write(reg.subpaths);
+}
+
+
+
+void CompactWriter::write(const CompoundRegion &reg)
+{
+    writeDouble(reg.zLevel);
+    writeVarint(reg.subregions.size());
+    SimpleRegions::const_iterator it;
+    for (it = reg.subregions.begin(); it != reg.subregions.end(); it++) {
+        write(*it);
+    }
+}
+
+
+
+bool CompactReader::readVarint(uint64_t &val)
+{
+    val = 0;
+    for (int shift = 0; good && shift < 64; shift += 7) {
+        if (pos == end) {
+            break;
+        }
+        uint8_t byte = *pos++;
+        val |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    good = false;
+    return false;
+}
+
+
+
+bool CompactReader::readSigned(int64_t &val)
+{
+    uint64_t zz;
+    if (!readVarint(zz)) {
+        return false;
+    }
+    val = (int64_t)(zz >> 1) ^ -(int64_t)(zz & 1);
+    return true;
+}
+
+
+
+bool CompactReader::readDouble(double &val)
+{
+    if (!good || end - pos < 8) {
+        good = false;
+        return false;
+    }
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; i++) {
+        bits |= (uint64_t)*pos++ << (8 * i);
+    }
+    memcpy(&val, &bits, sizeof(val));
+    return true;
+}
+
+
+
+bool CompactReader::readPoint(Point &pt)
+{
+    int64_t dx = 0, dy = 0;
+    if (!readSigned(dx) || !readSigned(dy)) {
+        return false;
+    }
+    lastX += dx;
+    lastY += dy;
+    pt.x = lastX * quantum;
+    pt.y = lastY * quantum;
+    return true;
+}
+
+
+
+// Reads an item count, and checks that there's at least enough data
+//  left for that many items, as BinaryReader does.
+bool CompactReader::readCount(uint64_t &cnt, size_t minItemSize)
+{
+    if (!readVarint(cnt)) {
+        return false;
+    }
+    if ((uint64_t)(end - pos) / minItemSize < cnt) {
+        good = false;
+    }
+    return good;
+}
+
+
+
+bool CompactReader::read(Path &path)
+{
+    uint64_t flags = 0, cnt = 0, encoding = 0;
+    if (!readVarint(flags) || !readCount(cnt, MIN_SEGMENT_BYTES) || !readVarint(encoding)) {
+        return false;
+    }
+    path.flags = flags;
+    path.segments.clear();
+    Line ln;
+    for (uint64_t i = 0; i < cnt && good; i++) {
+        if (i == 0 || !(encoding & COMPACT_PATH_CHAINED)) {
+            readPoint(ln.startPt);
+        } else {
+            ln.startPt = ln.endPt;
+        }
+        if (readPoint(ln.endPt)) {
+            path.segments.push_back(ln);
+        }
+    }
+    if (encoding & COMPACT_PATH_ATTRIBUTES) {
+        Lines::iterator it;
+        for (it = path.segments.begin(); good && it != path.segments.end(); it++) {
+            int64_t segFlags = 0;
+            if (!readSigned(segFlags)) {
+                break;
+            }
+            it->flags = segFlags;
+            readDouble(it->temperature);
+            readDouble(it->extrusionWidth);
+        }
+    }
+    return good;
+}
+
+
+
+bool CompactReader::read(Paths &paths)
+{
+    uint64_t cnt;
+    if (!readCount(cnt, 3)) {
+        return false;
+    }
+    paths.clear();
+    while (cnt-- > 0 && good) {
+        paths.push_back(Path());
+        read(paths.back());
+    }
+    return good;
+}
+
+
+
+bool CompactReader::read(SimpleRegion &reg)
+{
+    readDouble(reg.zLevel);
+    read(reg.outerPath);
+    return read(reg.subpaths);
+}
+
+
+
+bool CompactReader::read(CompoundRegion &reg)
+{
+    uint64_t cnt;
+    readDouble(reg.zLevel);
+    if (!readCount(cnt, sizeof(double) + 4)) {
+        return false;
+    }
+    reg.subregions.clear();
+    while (cnt-- > 0 && good) {
+        reg.subregions.push_back(SimpleRegion());
+        read(reg.subregions.back());
+    }
+    return good;
+}
+
+
+}
+
+
@@ -0,0 +1,95 @@
+//
+//  BGLCompact.h
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/24/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#ifndef BGL_COMPACT_H
+#define BGL_COMPACT_H
+
+#include <string>
+#include "config.h"
+#include "BGLPoint.h"
+#include "BGLLine.h"
+#include "BGLPath.h"
+#include "BGLSimpleRegion.h"
+#include "BGLCompoundRegion.h"
+
+namespace BGL {
+
+
+// Path encodings.  A chained path has each segment start where the
+//  last one ended, and is written as just its vertices.  Paths whose
+//  segments carry flags or attributes have them written after.
+const uint32_t COMPACT_PATH_CHAINED    = 0x1;
+const uint32_t COMPACT_PATH_ATTRIBUTES = 0x2;
+
+
+
+// Writes geometry out small.  Coordinates are rounded to a multiple of
+//  the quantum, and each is written as its difference from the point
+//  before it, in as few bytes as that takes.  Outlines made of short
+//  segments come out at a few bytes a vertex.  Everything is written a
+//  byte at a time, so the data reads back the same on any machine.
+class CompactWriter {
+private:
+    std::string buf;
+    double quantum;
+    int64_t lastX, lastY;
+
+    void writePoint(const Point &pt);
+
+public:
+    CompactWriter(double q) : buf(), quantum(q), lastX(0), lastY(0) {}
+
+    void writeVarint(uint64_t val);
+    void writeSigned(int64_t val) { writeVarint(((uint64_t)val << 1) ^ (uint64_t)(val >> 63)); }
+    void writeDouble(double val);
+    void write(const Path &path);
+    void write(const Paths &paths);
+    void write(const SimpleRegion &reg);
+    void write(const CompoundRegion &reg);
+
+    const std::string& data() const { return buf; }
+};
+
+
+
+// Reads back what a CompactWriter wrote, in the same order, with the
+//  same quantum.  Like BinaryReader, bad data makes ok() false for good,
+//  and every later read a no-op.  Geometry is built in whichever Arena
+//  is current.
+class CompactReader {
+private:
+    const uint8_t *pos;
+    const uint8_t *end;
+    double quantum;
+    int64_t lastX, lastY;
+    bool good;
+
+    bool readPoint(Point &pt);
+    bool readCount(uint64_t &cnt, size_t minItemSize);
+
+public:
+    CompactReader(const char *data, size_t len, double q)
+        : pos((const uint8_t*)data), end((const uint8_t*)data + len), quantum(q), lastX(0), lastY(0), good(true) {}
+
+    bool ok() const { return good; }
+    bool atEnd() const { return pos == end; }
+
+    bool readVarint(uint64_t &val);
+    bool readSigned(int64_t &val);
+    bool readDouble(double &val);
+    bool read(Path &path);
+    bool read(Paths &paths);
+    bool read(SimpleRegion &reg);
+    bool read(CompoundRegion &reg);
+};
+
+
+}
+
+#endif
+
@@ -11,6 +11,8 @@
 #include "BGLCommon.h"
 #include "BGLPoint.h"
 #include "BGLCompoundRegion.h"
+#include "BGLSimplifier.h"
+#include "BGLCancel.h"
 
 
 
@@ -78,6 +80,16 @@ CompoundRegion& CompoundRegion::operator/=(const Point &rhs) {
 
 
 
+CompoundRegion& CompoundRegion::transform(const Affine &aff) {
+    SimpleRegions::iterator it;
+    for (it = subregions.begin(); it != subregions.end(); it++) {
+	it->transform(aff);
+    }
+    return *this;
+}
+
+
+
 
 
 int32_t CompoundRegion::size() const
@@ -87,6 +99,18 @@ int32_t CompoundRegion::size() const
 
 
 
+int32_t CompoundRegion::segmentCount() const
+{
+    int32_t count = 0;
+    SimpleRegions::const_iterator it;
+    for (it = subregions.begin(); it != subregions.end(); it++) {
+        count += it->segmentCount();
+    }
+    return count;
+}
+
+
+
 bool CompoundRegion::contains(const Point &pt) const
 {
     SimpleRegions::const_iterator it;
@@ -110,6 +134,24 @@ void CompoundRegion::simplify(double minErr)
 
 
 
+// Decimates all subregions together, so that no path in any of them
+//  ends up crossing any other.
+int CompoundRegion::decimate(double tolerance)
+{
+    Simplifier simplifier;
+    SimpleRegions::iterator it;
+    for (it = subregions.begin(); it != subregions.end(); it++) {
+	simplifier.addPath(it->outerPath);
+	Paths::iterator pit;
+	for (pit = it->subpaths.begin(); pit != it->subpaths.end(); pit++) {
+	    simplifier.addPath(*pit);
+	}
+    }
+    return simplifier.simplify(tolerance);
+}
+
+
+
 CompoundRegion &CompoundRegion::assembleCompoundRegionFrom(Paths &paths, CompoundRegion &outReg)
 {
     SimpleRegion::assembleSimpleRegionsFrom(paths, outReg.subregions);
@@ -118,10 +160,18 @@ CompoundRegion &CompoundRegion::assembleCompoundRegionFrom(Paths &paths, Compoun
 
 
 
-string CompoundRegion::svgPathWithOffset(double dx, double dy)
+CompoundRegion &CompoundRegion::assembleCompoundRegionFrom(Paths &&paths, CompoundRegion &outReg)
+{
+    SimpleRegion::assembleSimpleRegionsFrom(std::move(paths), outReg.subregions);
+    return outReg;
+}
+
+
+
+string CompoundRegion::svgPathWithOffset(double dx, double dy) const
 {
     string out;
-    SimpleRegions::iterator rit;
+    SimpleRegions::const_iterator rit;
     for (rit = subregions.begin(); rit != subregions.end(); rit++) {
         out.append(rit->svgPathWithOffset(dx, dy));
     }
@@ -159,13 +209,13 @@ CompoundRegion &CompoundRegion::unionWith(SimpleRegion &reg)
         if (currReg.intersects(*rit)) {
 	    SimpleRegions tempRegs;
 	    SimpleRegion::unionOf(currReg, *rit, tempRegs);
-	    currReg = tempRegs.front();
+	    currReg = std::move(tempRegs.front());
 	    rit = subregions.erase(rit);
 	} else {
 	    rit++;
 	}
     }
-    subregions.push_back(currReg);
+    subregions.push_back(std::move(currReg));
     return *this;
 }
 
@@ -174,15 +224,14 @@ CompoundRegion &CompoundRegion::unionWith(SimpleRegion &reg)
 CompoundRegion &CompoundRegion::differenceWith(SimpleRegion &reg)
 {
     SimpleRegions::iterator rit;
-    SimpleRegions::iterator rit2;
     for (rit = subregions.begin(); rit != subregions.end(); ) {
         if (reg.intersects(*rit)) {
 	    SimpleRegions tempRegs;
 	    SimpleRegion::differenceOf(*rit, reg, tempRegs);
 	    rit = subregions.erase(rit);
-	    for (rit2 = tempRegs.begin(); rit2 != tempRegs.end(); rit2++) {
-	        subregions.push_front(*rit2);
-	    }
+	    // Same order as pushing each onto the front, but relinks the nodes.
+	    tempRegs.reverse();
+	    subregions.splice(subregions.begin(), tempRegs);
 	} else {
 	    rit++;
 	}
@@ -200,10 +249,11 @@ CompoundRegion &CompoundRegion::intersectionWith(SimpleRegion &reg)
 
 
 
+// These give up between subregions once the work is cancelled.
 CompoundRegion &CompoundRegion::unionWith(CompoundRegion &reg)
 {
     SimpleRegions::iterator rit;
-    for (rit = reg.subregions.begin(); rit != reg.subregions.end(); rit++) {
+    for (rit = reg.subregions.begin(); rit != reg.subregions.end() && !cancelRequested(); rit++) {
         unionWith(*rit);
     }
     return *this;
@@ -214,7 +264,7 @@ CompoundRegion &CompoundRegion::unionWith(CompoundRegion &reg)
 CompoundRegion &CompoundRegion::differenceWith(CompoundRegion &reg)
 {
     SimpleRegions::iterator rit;
-    for (rit = reg.subregions.begin(); rit != reg.subregions.end(); rit++) {
+    for (rit = reg.subregions.begin(); rit != reg.subregions.end() && !cancelRequested(); rit++) {
         differenceWith(*rit);
     }
     return *this;
@@ -334,9 +384,9 @@ CompoundRegion &CompoundRegion::insetRegion(double insetBy, CompoundRegion &outR
 
 
 
-Lines &CompoundRegion::containedSegmentsOfLine(Line &line, Lines &outSegs)
+Lines &CompoundRegion::containedSegmentsOfLine(const Line &line, Lines &outSegs) const
 {
-    SimpleRegions::iterator rit;
+    SimpleRegions::const_iterator rit;
     for (rit = subregions.begin(); rit != subregions.end(); rit++) {
         rit->containedSegmentsOfLine(line, outSegs);
     }
@@ -345,9 +395,9 @@ Lines &CompoundRegion::containedSegmentsOfLine(Line &line, Lines &outSegs)
 
 
 
-Paths &CompoundRegion::containedSubpathsOfPath(Path &path, Paths &outPaths)
+Paths &CompoundRegion::containedSubpathsOfPath(const Path &path, Paths &outPaths) const
 {
-    SimpleRegions::iterator rit;
+    SimpleRegions::const_iterator rit;
     for (rit = subregions.begin(); rit != subregions.end(); rit++) {
         rit->containedSubpathsOfPath(path, outPaths);
     }
@@ -356,9 +406,9 @@ Paths &CompoundRegion::containedSubpathsOfPath(Path &path, Paths &outPaths)
 
 
 
-Paths &CompoundRegion::infillPathsForRegionWithDensity(double density, double extrusionWidth, Paths &outPaths)
+Paths &CompoundRegion::infillPathsForRegionWithDensity(double density, double extrusionWidth, Paths &outPaths) const
 {
-    SimpleRegions::iterator rit;
+    SimpleRegions::const_iterator rit;
     for (rit = subregions.begin(); rit != subregions.end(); rit++) {
         rit->infillPathsForRegionWithDensity(density, extrusionWidth, outPaths);
     }
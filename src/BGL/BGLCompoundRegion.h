@@ -11,6 +11,7 @@
 #define BGL_REGION_H
 
 #include "config.h"
+#include "BGLShared.h"
 #include "BGLSimpleRegion.h"
 #include "BGLPath.h"
 #include "BGLLine.h"
@@ -25,14 +26,32 @@ public:
 
     CompoundRegion() : subregions(), zLevel(0.0f) {}
     CompoundRegion(const SimpleRegions &x) : subregions(x), zLevel(0.0f) {}
+    CompoundRegion(SimpleRegions &&x) : subregions(std::move(x)), zLevel(0.0f) {}
     CompoundRegion(const CompoundRegion &x) : subregions(x.subregions), zLevel(x.zLevel) {}
+    CompoundRegion(CompoundRegion &&x) : subregions(std::move(x.subregions)), zLevel(x.zLevel) {}
     CompoundRegion(const Paths &x) : subregions(), zLevel(0.0f) {
         Paths::const_iterator it;
 	for (it = x.begin(); it != x.end(); it++) {
-	    subregions.push_back(SimpleRegion(*it));
+	    subregions.emplace_back(*it);
 	}
     }
 
+    // Assignment operators
+    CompoundRegion& operator=(const CompoundRegion &rhs) {
+	if (this != &rhs) {
+	    subregions = rhs.subregions;
+	    zLevel = rhs.zLevel;
+	}
+	return *this;
+    }
+    CompoundRegion& operator=(CompoundRegion &&rhs) {
+	if (this != &rhs) {
+	    subregions = std::move(rhs.subregions);
+	    zLevel = rhs.zLevel;
+	}
+	return *this;
+    }
+
     // Compound assignment operators
     CompoundRegion& operator+=(const Point &rhs);
     CompoundRegion& operator-=(const Point &rhs);
@@ -40,6 +59,7 @@ public:
     CompoundRegion& operator*=(const Point &rhs);
     CompoundRegion& operator/=(double rhs);
     CompoundRegion& operator/=(const Point &rhs);
+    CompoundRegion& transform(const Affine &aff);
 
     // Binary arithmetic operators
     const CompoundRegion operator+(const Point &rhs) const {
@@ -62,13 +82,15 @@ public:
     }
 
     int32_t size() const;
+    int32_t segmentCount() const;
     bool contains(const Point &pt) const;
 
-    string svgPathWithOffset(double dx, double dy);
+    string svgPathWithOffset(double dx, double dy) const;
     ostream &svgPathDataWithOffset(ostream& os, double dx, double dy) const;
     ostream &svgPathWithOffset(ostream& os, double dx, double dy) const;
 
     void simplify(double minErr);
+    int decimate(double tolerance);
 
     CompoundRegion &unionWith(SimpleRegion &reg);
     CompoundRegion &differenceWith(SimpleRegion &reg);
@@ -85,14 +107,18 @@ public:
     static CompoundRegion &intersectionOf(CompoundRegion &r1, CompoundRegion &r2, CompoundRegion &outReg);
 
     static CompoundRegion &assembleCompoundRegionFrom(Paths &paths, CompoundRegion &outReg);
+    static CompoundRegion &assembleCompoundRegionFrom(Paths &&paths, CompoundRegion &outReg);
 
-    Lines &containedSegmentsOfLine(Line &line, Lines &lnsref);
-    Paths &containedSubpathsOfPath(Path &path, Paths &pathsref);
+    Lines &containedSegmentsOfLine(const Line &line, Lines &lnsref) const;
+    Paths &containedSubpathsOfPath(const Path &path, Paths &pathsref) const;
 
-    Paths &infillPathsForRegionWithDensity(double density, double extrusionWidth, Paths &outPaths);
+    Paths &infillPathsForRegionWithDensity(double density, double extrusionWidth, Paths &outPaths) const;
 
 };
-typedef list<CompoundRegion> CompoundRegions;
+typedef list<CompoundRegion, ArenaAllocator<CompoundRegion> > CompoundRegions;
+
+typedef Shared<CompoundRegion> SharedRegion;
+typedef list<SharedRegion, ArenaAllocator<SharedRegion> > SharedRegions;
 
 
 }
@@ -0,0 +1,117 @@
+//
+//  BGLCpu.cc
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/28/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#include <string.h>
+#include "BGLCpu.h"
+
+namespace BGL {
+
+
+static const struct {
+    const char *name;
+    unsigned feature;
+} cpuFeatureTable[] = {
+    { "sse2",   CPU_SSE2 },
+    { "avx2",   CPU_AVX2 },
+    { "avx512", CPU_AVX512 },
+};
+static const size_t cpuFeatureCount = sizeof(cpuFeatureTable) / sizeof(cpuFeatureTable[0]);
+
+static std::atomic<unsigned> allowedFeatures(CPU_ALL);
+
+
+
+static unsigned detectCpuFeatures()
+{
+    unsigned features = 0;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        features |= CPU_SSE2;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        features |= CPU_AVX2;
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        features |= CPU_AVX512;
+    }
+#endif
+    return features;
+}
+
+
+
+unsigned detectedCpuFeatures()
+{
+    static unsigned detected = detectCpuFeatures();
+    return detected;
+}
+
+
+
+unsigned cpuFeatures()
+{
+    return detectedCpuFeatures() & allowedFeatures.load(std::memory_order_relaxed);
+}
+
+
+
+void limitCpuFeatures(unsigned features)
+{
+    allowedFeatures.store(features & CPU_ALL, std::memory_order_relaxed);
+}
+
+
+
+bool parseCpuFeatures(const char *list, unsigned &features)
+{
+    features = 0;
+    std::string names(list);
+    size_t start = 0;
+    while (start <= names.size()) {
+        size_t end = names.find(',', start);
+        if (end == std::string::npos) {
+            end = names.size();
+        }
+        std::string name = names.substr(start, end - start);
+        if (name == "all") {
+            features |= CPU_ALL;
+        } else if (name != "none") {
+            size_t i = 0;
+            while (i < cpuFeatureCount && name != cpuFeatureTable[i].name) {
+                i++;
+            }
+            if (i == cpuFeatureCount) {
+                return false;
+            }
+            features |= cpuFeatureTable[i].feature;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+
+
+std::string cpuFeatureNames(unsigned features)
+{
+    std::string names;
+    for (size_t i = 0; i < cpuFeatureCount; i++) {
+        if (features & cpuFeatureTable[i].feature) {
+            if (!names.empty()) {
+                names += ",";
+            }
+            names += cpuFeatureTable[i].name;
+        }
+    }
+    return names.empty() ? "none" : names;
+}
+
+
+}
+
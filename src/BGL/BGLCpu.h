@@ -0,0 +1,95 @@
+//
+//  BGLCpu.h
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/28/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#ifndef BGL_CPU_H
+#define BGL_CPU_H
+
+#include <stddef.h>
+#include <string>
+#include <atomic>
+#include "config.h"
+
+namespace BGL {
+
+
+// Instruction set extensions BGL has kernels for.
+enum CpuFeature {
+    CPU_SSE2   = 1 << 0,
+    CPU_AVX2   = 1 << 1,
+    CPU_AVX512 = 1 << 2,
+    CPU_ALL    = CPU_SSE2 | CPU_AVX2 | CPU_AVX512
+};
+
+// What this CPU has, found the first time it's asked.
+unsigned detectedCpuFeatures();
+
+// What kernels may use: what the CPU has, less anything left out by
+//  limitCpuFeatures().
+unsigned cpuFeatures();
+void limitCpuFeatures(unsigned features);
+
+// Parses a comma separated list of features, such as "sse2,avx2".
+//  "none" is none of them, for plain scalar code, and "all" is all of
+//  them.  Returns false on a name it doesn't know.
+bool parseCpuFeatures(const char *list, unsigned &features);
+std::string cpuFeatureNames(unsigned features);
+
+
+
+// One version of a kernel, and the features it needs.
+template <class Fn>
+struct Kernel {
+    unsigned needs;
+    const char *name;
+    Fn fn;
+};
+
+
+
+// The versions of one kernel, best first, with a plain one needing
+//  nothing last.  The first one cpuFeatures() allows is bound the first
+//  time it's asked for, and again if the features are limited later.
+//  Picking is cheap and always picks the same, so threads that race to
+//  bind one do no harm.
+template <class Fn>
+class KernelFamily {
+private:
+    const Kernel<Fn> *kernels;
+    size_t kernelCount;
+    mutable std::atomic<const Kernel<Fn>*> bound;
+    mutable std::atomic<unsigned> boundFor;
+
+public:
+    constexpr KernelFamily(const Kernel<Fn> *k, size_t n) : kernels(k), kernelCount(n), bound(NULL), boundFor(0) {}
+
+    size_t count() const { return kernelCount; }
+    const Kernel<Fn>& kernel(size_t i) const { return kernels[i]; }
+
+    const Kernel<Fn>& best() const {
+        unsigned features = cpuFeatures();
+        const Kernel<Fn> *k = bound.load(std::memory_order_acquire);
+        if (!k || boundFor.load(std::memory_order_relaxed) != features) {
+            k = &kernels[kernelCount - 1];
+            for (size_t i = 0; i < kernelCount; i++) {
+                if ((kernels[i].needs & features) == kernels[i].needs) {
+                    k = &kernels[i];
+                    break;
+                }
+            }
+            boundFor.store(features, std::memory_order_relaxed);
+            bound.store(k, std::memory_order_release);
+        }
+        return *k;
+    }
+};
+
+
+}
+
+#endif
+
@@ -0,0 +1,45 @@
+//
+//  BGLHash.h
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/23/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#ifndef BGL_HASH_H
+#define BGL_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+namespace BGL {
+
+
+// 64-bit FNV-1a.  Fast and simple, for cache keys and fingerprints,
+//  not for anything that has to stand up to deliberate collisions.
+static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+inline uint64_t fnv1a(const void *data, size_t len, uint64_t hash = FNV_OFFSET_BASIS)
+{
+    const uint8_t *bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// Folds the bytes of a plain value, like a float setting, into a hash.
+template <class T>
+inline uint64_t fnv1aValue(const T &value, uint64_t hash = FNV_OFFSET_BASIS)
+{
+    return fnv1a(&value, sizeof(value), hash);
+}
+
+
+}
+
+#endif
+
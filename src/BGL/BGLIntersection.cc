@@ -2,11 +2,16 @@
 #include "BGLLine.h"
 
 namespace BGL {
-Line Intersection::line() const
+template <class C>
+BasicLine<C> BasicIntersection<C>::line() const
 {
-    return Line(p1, p2);
+    return BasicLine<C>(p1, p2);
 }
 
+template class BasicIntersection<DoubleCoord>;
+template class BasicIntersection<FloatCoord>;
+template class BasicIntersection<FixedCoord>;
+
 }
 
 
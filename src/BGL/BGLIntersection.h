@@ -25,23 +25,27 @@ typedef enum {
 } IntersectionType;
 
 
-class Line;
+template <class C> class BasicLine;
 
-class Intersection {
+template <class C>
+class BasicIntersection {
 public:
     IntersectionType type;
-    Point p1, p2;
+    BasicPoint<C> p1, p2;
     int32_t segment;
 
-    Intersection() : type(NONE), p1(), p2(), segment(0) {}
-    Intersection(int32_t segnum) : type(LINE), p1(), p2(), segment(segnum) {}
-    Intersection(const Point& pt1, int32_t segnum) : type(POINT), p1(pt1), p2(), segment(segnum) {}
-    Intersection(const Point& pt1, const Point& pt2, int32_t segnum) : type(SEGMENT), p1(pt1), p2(pt2), segment(segnum) {}
+    BasicIntersection() : type(NONE), p1(), p2(), segment(0) {}
+    BasicIntersection(int32_t segnum) : type(LINE), p1(), p2(), segment(segnum) {}
+    BasicIntersection(const BasicPoint<C>& pt1, int32_t segnum) : type(POINT), p1(pt1), p2(), segment(segnum) {}
+    BasicIntersection(const BasicPoint<C>& pt1, const BasicPoint<C>& pt2, int32_t segnum) : type(SEGMENT), p1(pt1), p2(pt2), segment(segnum) {}
 
-    Line line() const;
+    BasicLine<C> line() const;
 };
 
-typedef list<Intersection> Intersections;
+typedef BasicIntersection<DoubleCoord> Intersection;
+typedef BasicIntersection<FloatCoord> IntersectionF;
+typedef BasicIntersection<FixedCoord> IntersectionX;
+typedef list<Intersection, ArenaAllocator<Intersection> > Intersections;
 
 
 }
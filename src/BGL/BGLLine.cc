@@ -12,32 +12,34 @@ using namespace std;
 
 namespace BGL {
 
-bool Line::isLinearWith(const Point& pt) const
+template <class C>
+bool BasicLine<C>::isLinearWith(const BasicPoint<C>& pt) const
 {
-    return (minimumExtendedLineDistanceFromPoint(pt) < CLOSEENOUGH);
+    return (minimumExtendedLineDistanceFromPoint(pt) < C::closeEnough());
 }
 
 
 
-bool Line::hasInBounds(const Point &pt) const
+template <class C>
+bool BasicLine<C>::hasInBounds(const BasicPoint<C> &pt) const
 {
-    double px = pt.x;
-    double py = pt.y;
-    double sx = startPt.x;
-    double sy = startPt.y;
-    double ex = endPt.x;
-    double ey = endPt.y;
+    double px = C::toDouble(pt.x);
+    double py = C::toDouble(pt.y);
+    double sx = C::toDouble(startPt.x);
+    double sy = C::toDouble(startPt.y);
+    double ex = C::toDouble(endPt.x);
+    double ey = C::toDouble(endPt.y);
     
-    if (px > sx+EPSILON && px > ex+EPSILON) {
+    if (px > sx+C::epsilon() && px > ex+C::epsilon()) {
         return false;
     }
-    if (px < sx-EPSILON && px < ex-EPSILON) {
+    if (px < sx-C::epsilon() && px < ex-C::epsilon()) {
         return false;
     }
-    if (py > sy+EPSILON && py > ey+EPSILON) {
+    if (py > sy+C::epsilon() && py > ey+C::epsilon()) {
         return false;
     }
-    if (py < sy-EPSILON && py < ey-EPSILON) {
+    if (py < sy-C::epsilon() && py < ey-C::epsilon()) {
         return false;
     }
     return true;
@@ -45,71 +47,76 @@ bool Line::hasInBounds(const Point &pt) const
 
 
 
-bool Line::contains(const Point &pt) const
+template <class C>
+bool BasicLine<C>::contains(const BasicPoint<C> &pt) const
 {
     if (hasInBounds(pt)) {
-	return (minimumSegmentDistanceFromPoint(pt) < CLOSEENOUGH);
+	return (minimumSegmentDistanceFromPoint(pt) < C::closeEnough());
     }
     return false;
 }
 
 
 
-Point Line::closestSegmentPointTo(const Point &pt) const
+template <class C>
+BasicPoint<C> BasicLine<C>::closestSegmentPointTo(const BasicPoint<C> &pt) const
 {
-    double x1 = startPt.x;
-    double y1 = startPt.y;
-    double x2 = endPt.x;
-    double y2 = endPt.y;
+    double x1 = C::toDouble(startPt.x);
+    double y1 = C::toDouble(startPt.y);
+    double x2 = C::toDouble(endPt.x);
+    double y2 = C::toDouble(endPt.y);
     double xd = x2 - x1;
     double yd = y2 - y1;
     double u;
 
     if (startPt == endPt) {
-        return Point(startPt);
+        return BasicPoint<C>(startPt);
     }
-    u = ((pt.x - x1) * xd + (pt.y - y1) * yd) / (xd * xd + yd * yd);
+    u = ((C::toDouble(pt.x) - x1) * xd + (C::toDouble(pt.y) - y1) * yd) / (xd * xd + yd * yd);
     if (u < 0.0) {
-        return Point(startPt);
+        return BasicPoint<C>(startPt);
     } else if (u > 1.0) {
-        return Point(endPt);
+        return BasicPoint<C>(endPt);
     }
-    return Point(x1+u*xd, y1+u*yd);
+    return BasicPoint<C>(x1+u*xd, y1+u*yd);
 }
 
 
 
-Point Line::closestExtendedLinePointTo(const Point &pt) const
+template <class C>
+BasicPoint<C> BasicLine<C>::closestExtendedLinePointTo(const BasicPoint<C> &pt) const
 {
-    double x1 = startPt.x;
-    double y1 = startPt.y;
-    double x2 = endPt.x;
-    double y2 = endPt.y;
+    double x1 = C::toDouble(startPt.x);
+    double y1 = C::toDouble(startPt.y);
+    double x2 = C::toDouble(endPt.x);
+    double y2 = C::toDouble(endPt.y);
     double xd = x2 - x1;
     double yd = y2 - y1;
     double u;
     
     if (startPt == endPt) {
-        return Point(startPt);
+        return BasicPoint<C>(startPt);
     }
-    u = ((pt.x - x1) * xd + (pt.y - y1) * yd) / (xd * xd + yd * yd);
-    return Point(x1+u*xd, y1+u*yd);
+    u = ((C::toDouble(pt.x) - x1) * xd + (C::toDouble(pt.y) - y1) * yd) / (xd * xd + yd * yd);
+    return BasicPoint<C>(x1+u*xd, y1+u*yd);
 }
 
 
 
-double Line::minimumSegmentDistanceFromPoint(const Point &pt) const
+template <class C>
+double BasicLine<C>::minimumSegmentDistanceFromPoint(const BasicPoint<C> &pt) const
 {
-    Point closePt = closestSegmentPointTo(pt);
+    BasicPoint<C> closePt = closestSegmentPointTo(pt);
     return pt.distanceFrom(closePt);
 }
 
 
 
 
-double Line::minimumExtendedLineDistanceFromPoint(const Point &pt) const
+template <class C>
+double BasicLine<C>::minimumExtendedLineDistanceFromPoint(const BasicPoint<C> &pt) const
 {
-    Point closePt = closestExtendedLinePointTo(pt);
+    BasicPoint<C> closePt = closestExtendedLinePointTo(pt);
     return pt.distanceFrom(closePt);
 }
 
@@ -118,16 +125,17 @@ double Line::minimumExtendedLineDistanceFromPoint(const Point &pt) const
 
 // Returns the intersection of two line segments.
 // If they don't intersect, the Intersection will have a type of NONE.
-Intersection Line::intersectionWithSegment(const Line &ln) const
+template <class C>
+BasicIntersection<C> BasicLine<C>::intersectionWithSegment(const BasicLine<C> &ln) const
 {
-    double x1 = startPt.x;
-    double y1 = startPt.y;
-    double x2 = endPt.x;
-    double y2 = endPt.y;
-    double x3 = ln.startPt.x;
-    double y3 = ln.startPt.y;
-    double x4 = ln.endPt.x;
-    double y4 = ln.endPt.y;
+    double x1 = C::toDouble(startPt.x);
+    double y1 = C::toDouble(startPt.y);
+    double x2 = C::toDouble(endPt.x);
+    double y2 = C::toDouble(endPt.y);
+    double x3 = C::toDouble(ln.startPt.x);
+    double y3 = C::toDouble(ln.startPt.y);
+    double x4 = C::toDouble(ln.endPt.x);
+    double y4 = C::toDouble(ln.endPt.y);
 
     double dx1 = x2 - x1;
     double dy1 = y2 - y1;
@@ -157,7 +165,7 @@ Intersection Line::intersectionWithSegment(const Line &ln) const
 	cerr << "testing isect of " << *this << " and " << ln << endl;
 	cerr << "d = " << d << " for " << *this << " and " << ln << endl;
     }
-    if (fabs(d) <= EPSILON) {
+    if (fabs(d) <= C::epsilon()) {
 	if (dodebug) {
 	    cerr << "PARALLEL" << endl;
 	}
@@ -166,19 +174,19 @@ Intersection Line::intersectionWithSegment(const Line &ln) const
 	    if (dodebug) {
 		cerr << "    exit A" << endl;
 	    }
-            return Intersection();
+            return BasicIntersection<C>();
 	} else if (ln.startPt == ln.endPt) {
             // ln is actually a zero length directionless line. (AKA a point.)
 	    if (dodebug) {
 		cerr << "    exit B" << endl;
 	    }
-            return Intersection();
+            return BasicIntersection<C>();
 	} else if (
-	    minimumExtendedLineDistanceFromPoint(ln.startPt) < EPSILON &&
-	    minimumExtendedLineDistanceFromPoint(ln.endPt) < EPSILON
+	    minimumExtendedLineDistanceFromPoint(ln.startPt) < C::epsilon() &&
+	    minimumExtendedLineDistanceFromPoint(ln.endPt) < C::epsilon()
 	) {
             // Lines are coincident (or very close to).  Check for overlap.
-	    Points isects;
+	    list<BasicPoint<C>, ArenaAllocator<BasicPoint<C> > > isects;
 	    if (ln.contains(startPt)) {
 		isects.push_back(startPt);
 	    }
@@ -200,23 +208,23 @@ Intersection Line::intersectionWithSegment(const Line &ln) const
 		if (dodebug) {
 		    cerr << "    exit C" << endl;
 		}
-		return Intersection();
+		return BasicIntersection<C>();
 	    } else if (icnt == 1) {
 		if (dodebug) {
 		    cerr << "    exit D" << endl;
 		}
-                return Intersection(isects.front(),0);
+                return BasicIntersection<C>(isects.front(),0);
 	    } else  {
 		if (dodebug) {
 		    cerr << "    exit E" << endl;
 		}
-                return Intersection(isects.front(),isects.back(),0);
+                return BasicIntersection<C>(isects.front(),isects.back(),0);
             }
         }
 	if (dodebug) {
 	    cerr << "    exit F" << endl;
 	}
-	return Intersection();
+	return BasicIntersection<C>();
     }
     
     double ua = na / d;
@@ -229,17 +237,17 @@ Intersection Line::intersectionWithSegment(const Line &ln) const
 	cerr << "    ua=" << ua << ", ub=" << ub << endl;
 	cerr << "    isect at " << xi << ", " << yi << endl;
     }
-    if (ua < -EPSILON || ua > 1.0+EPSILON) {
+    if (ua < -C::epsilon() || ua > 1.0+C::epsilon()) {
         // Intersection wouldn't be inside first segment
-	return Intersection();
+	return BasicIntersection<C>();
     }
     
-    if (ub < -EPSILON || ub > 1.0+EPSILON) {
+    if (ub < -C::epsilon() || ub > 1.0+C::epsilon()) {
         // Intersection wouldn't be inside second segment
-	return Intersection();
+	return BasicIntersection<C>();
     }
     
-    return Intersection(Point(xi,yi),0);
+    return BasicIntersection<C>(BasicPoint<C>(xi,yi),0);
 }
 
 
@@ -247,36 +255,37 @@ Intersection Line::intersectionWithSegment(const Line &ln) const
 // Returns the intersection of two extended lines.
 // If they don't intersect, the Intersection will have a type of NONE.
 // If they are coincident, the Intersection will have a type of COINCIDENT.
-Intersection Line::intersectionWithExtendedLine(const Line &ln) const
+template <class C>
+BasicIntersection<C> BasicLine<C>::intersectionWithExtendedLine(const BasicLine<C> &ln) const
 {
-    double x1 = startPt.x;
-    double y1 = startPt.y;
-    double x2 = endPt.x;
-    double y2 = endPt.y;
+    double x1 = C::toDouble(startPt.x);
+    double y1 = C::toDouble(startPt.y);
+    double x2 = C::toDouble(endPt.x);
+    double y2 = C::toDouble(endPt.y);
     
     double dx1 = x2 - x1;
     double dy1 = y2 - y1;
     
-    double dx2 = ln.endPt.x - ln.startPt.x;
-    double dy2 = ln.endPt.y - ln.startPt.y;
+    double dx2 = C::toDouble(ln.endPt.x) - C::toDouble(ln.startPt.x);
+    double dy2 = C::toDouble(ln.endPt.y) - C::toDouble(ln.startPt.y);
     
-    double dx3 = x1 - ln.startPt.x;
-    double dy3 = y1 - ln.startPt.y;
+    double dx3 = x1 - C::toDouble(ln.startPt.x);
+    double dy3 = y1 - C::toDouble(ln.startPt.y);
     
     double d  = dy2 * dx1 - dx2 * dy1;
     double na = dx2 * dy3 - dy2 * dx3;
     //double nb = dx1 * dy3 - dy1 * dx3;
     
-    if (fabs(d) <= EPSILON) {
+    if (fabs(d) <= C::epsilon()) {
         if (
-	    minimumExtendedLineDistanceFromPoint(ln.startPt) < CLOSEENOUGH &&
-	    minimumExtendedLineDistanceFromPoint(ln.endPt) < CLOSEENOUGH
+	    minimumExtendedLineDistanceFromPoint(ln.startPt) < C::closeEnough() &&
+	    minimumExtendedLineDistanceFromPoint(ln.endPt) < C::closeEnough()
 	) {
 	    // Lines are coincident.
-	    return Intersection(0);
+	    return BasicIntersection<C>(0);
         } else {
 	    // No intersection; lines are parallel
-	    return Intersection();
+	    return BasicIntersection<C>();
 	}
     }
     
@@ -284,16 +293,17 @@ Intersection Line::intersectionWithExtendedLine(const Line &ln) const
     //double ub = nb / d;
     double xi = x1 + ua * dx1;
     double yi = y1 + ua * dy1;
-    return Intersection(Point(xi,yi),0);
+    return BasicIntersection<C>(BasicPoint<C>(xi,yi),0);
 }
 
 
 
-Line& Line::leftOffset(double offsetby)
+template <class C>
+BasicLine<C>& BasicLine<C>::leftOffset(double offsetby)
 {
     double ang = angle();
     double pang = ang + M_PI_2;  /* 90 degs ccw */
-    Point offPt;
+    BasicPoint<C> offPt;
     offPt.polarOffset(pang, offsetby);
     startPt += offPt;
     endPt += offPt;
@@ -302,12 +312,24 @@ Line& Line::leftOffset(double offsetby)
 
 
 
-ostream& operator <<(ostream &os, const Line &ln)
+template <class C>
+ostream& operator <<(ostream &os, const BasicLine<C> &ln)
 {
     os << "[" << ln.startPt << " - " << ln.endPt << "]";
     return os;
 }
 
 
+
+// One for each kind of coordinate.  The sums are done in doubles,
+//  whatever the coordinates are stored as.
+template class BasicLine<DoubleCoord>;
+template class BasicLine<FloatCoord>;
+template class BasicLine<FixedCoord>;
+template ostream& operator <<(ostream &os, const BasicLine<DoubleCoord> &ln);
+template ostream& operator <<(ostream &os, const BasicLine<FloatCoord> &ln);
+template ostream& operator <<(ostream &os, const BasicLine<FixedCoord> &ln);
+
+
 }
 
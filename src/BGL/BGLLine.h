@@ -24,17 +24,18 @@ using namespace std;
 namespace BGL {
 
 
-class Line {
+template <class C>
+class BasicLine {
 public:
     // Member variables
-    Point startPt;
-    Point endPt;
+    BasicPoint<C> startPt;
+    BasicPoint<C> endPt;
     int16_t flags;
     double temperature;
     double extrusionWidth;
 
     // Constructors
-    Line() :
+    BasicLine() :
         startPt(),
         endPt(),
         flags(0),
@@ -43,7 +44,7 @@ public:
     {
     }
 
-    Line(const Point& p1, const Point& p2) :
+    BasicLine(const BasicPoint<C>& p1, const BasicPoint<C>& p2) :
         startPt(p1),
         endPt(p2),
         flags(0),
@@ -52,113 +53,99 @@ public:
     {
     }
 
-    Line(const Line& ln) :
-        startPt(ln.startPt),
-        endPt(ln.endPt),
-        flags(ln.flags),
-        temperature(ln.temperature),
-        extrusionWidth(ln.extrusionWidth)
-    {
-    }
-
-    // Assignment operator
-    Line& operator=(const Line &rhs) {
-        if (this != &rhs) {
-            startPt = rhs.startPt;
-            endPt = rhs.endPt;
-            flags = rhs.flags;
-            temperature = rhs.temperature;
-            extrusionWidth = rhs.extrusionWidth;
-        }
-        return *this;
-    }
+    // Copies and moves are left to the compiler, so Lines stay trivially copyable.
 
     // Compound assignment operators
-    Line& operator+=(const Point &rhs) {
+    BasicLine& operator+=(const BasicPoint<C> &rhs) {
         this->startPt += rhs;
         this->endPt += rhs;
         return *this;
     }
-    Line& operator-=(const Point &rhs) {
+    BasicLine& operator-=(const BasicPoint<C> &rhs) {
         this->startPt -= rhs;
         this->endPt -= rhs;
         return *this;
     }
-    Line& operator*=(double rhs) {
+    BasicLine& operator*=(double rhs) {
         this->startPt *= rhs;
         this->endPt *= rhs;
         return *this;
     }
-    Line& operator*=(const Point &rhs) {
+    BasicLine& operator*=(const BasicPoint<C> &rhs) {
         this->startPt *= rhs;
         this->endPt *= rhs;
         return *this;
     }
-    Line& operator/=(double rhs) {
+    BasicLine& operator/=(double rhs) {
         this->startPt /= rhs;
         this->endPt /= rhs;
         return *this;
     }
-    Line& operator/=(const Point &rhs) {
+    BasicLine& operator/=(const BasicPoint<C> &rhs) {
         this->startPt /= rhs;
         this->endPt /= rhs;
         return *this;
     }
 
     // Binary arithmetic operators
-    const Line operator+(const Point &rhs) const {
-        return Line(*this) += rhs;
+    const BasicLine operator+(const BasicPoint<C> &rhs) const {
+        return BasicLine(*this) += rhs;
     }
-    const Line operator-(const Point &rhs) const {
-        return Line(*this) -= rhs;
+    const BasicLine operator-(const BasicPoint<C> &rhs) const {
+        return BasicLine(*this) -= rhs;
     }
-    const Line operator*(double rhs) const {
-        return Line(*this) *= rhs;
+    const BasicLine operator*(double rhs) const {
+        return BasicLine(*this) *= rhs;
     }
-    const Line operator*(const Point &rhs) const {
-        return Line(*this) *= rhs;
+    const BasicLine operator*(const BasicPoint<C> &rhs) const {
+        return BasicLine(*this) *= rhs;
     }
-    const Line operator/(double rhs) const {
-        return Line(*this) /= rhs;
+    const BasicLine operator/(double rhs) const {
+        return BasicLine(*this) /= rhs;
     }
-    const Line operator/(const Point &rhs) const {
-        return Line(*this) /= rhs;
+    const BasicLine operator/(const BasicPoint<C> &rhs) const {
+        return BasicLine(*this) /= rhs;
     }
 
     // Comparison operators
-    bool operator==(const Line &rhs) const {
+    bool operator==(const BasicLine &rhs) const {
         return ((startPt == rhs.startPt && endPt == rhs.endPt) ||
             (startPt == rhs.endPt && endPt == rhs.startPt));
     }
-    bool operator!=(const Line &rhs) const {
+    bool operator!=(const BasicLine &rhs) const {
         return !(*this == rhs);
     }
 
-    bool hasEndPoint(const Point& pt) const {
+    bool hasEndPoint(const BasicPoint<C>& pt) const {
         return (pt == startPt || pt == endPt);
     }
 
     // Transformations
-    Line& scale(double scale) {
+    BasicLine& scale(double scale) {
         *this *= scale;
         return *this;
     }
-    Line& scale(const Point& vect) {
+    BasicLine& scale(const BasicPoint<C>& vect) {
         *this *= vect;
         return *this;
     }
-    Line& scaleAroundPoint(const Point& center, double scale) {
+    BasicLine& scaleAroundPoint(const BasicPoint<C>& center, double scale) {
         *this -= center;
         *this *= scale;
         *this += center;
         return *this;
     }
-    Line& scaleAroundPoint(const Point& center, const Point& vect) {
+    BasicLine& scaleAroundPoint(const BasicPoint<C>& center, const BasicPoint<C>& vect) {
         *this -= center;
         *this *= vect;
         *this += center;
         return *this;
     }
+    BasicLine& transform(const Affine& aff) {
+        startPt.transform(aff);
+        endPt.transform(aff);
+        return *this;
+    }
 
     // Calculations
     double length() const {
@@ -167,7 +154,7 @@ public:
     double angle() const {
         return startPt.angleToPoint(endPt);
     }
-    double angleDelta(const Line& ln) const {
+    double angleDelta(const BasicLine& ln) const {
         double delta = ln.angle() - angle();
         if (delta < -M_PI) {
             delta += M_PI * 2.0f;
@@ -178,29 +165,33 @@ public:
     }
 
     // Misc
-    Line& reverse() {
-        Point tmpPt = startPt;
+    BasicLine& reverse() {
+        BasicPoint<C> tmpPt = startPt;
         startPt = endPt;
         endPt = tmpPt;
         return *this;
     }
-    bool isLinearWith(const Point& pt) const;
-    bool hasInBounds(const Point &pt) const;
-    bool contains(const Point &pt) const;
-    Point closestSegmentPointTo(const Point &pt) const;
-    Point closestExtendedLinePointTo(const Point &pt) const;
-    double minimumSegmentDistanceFromPoint(const Point &pt) const;
-    double minimumExtendedLineDistanceFromPoint(const Point &pt) const;
-    Intersection intersectionWithSegment(const Line &ln) const;
-    Intersection intersectionWithExtendedLine(const Line &ln) const;
+    bool isLinearWith(const BasicPoint<C>& pt) const;
+    bool hasInBounds(const BasicPoint<C> &pt) const;
+    bool contains(const BasicPoint<C> &pt) const;
+    BasicPoint<C> closestSegmentPointTo(const BasicPoint<C> &pt) const;
+    BasicPoint<C> closestExtendedLinePointTo(const BasicPoint<C> &pt) const;
+    double minimumSegmentDistanceFromPoint(const BasicPoint<C> &pt) const;
+    double minimumExtendedLineDistanceFromPoint(const BasicPoint<C> &pt) const;
+    BasicIntersection<C> intersectionWithSegment(const BasicLine &ln) const;
+    BasicIntersection<C> intersectionWithExtendedLine(const BasicLine &ln) const;
+
+    BasicLine& leftOffset(double offsetby);
+};
 
-    Line& leftOffset(double offsetby);
+template <class C>
+ostream& operator <<(ostream &os,const BasicLine<C> &ln);
 
-    // Friend functions
-    friend ostream& operator <<(ostream &os,const Line &pt);
-};
+typedef BasicLine<DoubleCoord> Line;
+typedef BasicLine<FloatCoord> LineF;
+typedef BasicLine<FixedCoord> LineX;
 
-typedef list<Line> Lines;
+typedef list<Line, ArenaAllocator<Line> > Lines;
 
 
 
@@ -6,12 +6,23 @@
 //  Copyright 2010 Belfry Software. All rights reserved.
 //
 
+#include <algorithm>
+#include <string>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "BGLMesh3d.h"
+#include "BGLHash.h"
 #include "BGLPoint3d.h"
 #include "BGLLine.h"
 #include "BGLPath.h"
 #include "BGLCompoundRegion.h"
 #include "BGLTriangle3d.h"
+#include "BGLParallel.h"
+#include "BGLSliceKernel.h"
+#include "BGLCancel.h"
 
 namespace BGL {
 
@@ -49,36 +60,67 @@ Point3d Mesh3d::centerPoint() const
 
 
 
+// The bounds of a run of triangles, for putting together side by side.
+struct MeshBounds {
+    double minX, maxX;
+    double minY, maxY;
+    double minZ, maxZ;
+};
+
+
+
+static inline void growBounds(MeshBounds &b, const Point3d &pt)
+{
+    if (pt.x < b.minX) b.minX = pt.x;
+    if (pt.y < b.minY) b.minY = pt.y;
+    if (pt.z < b.minZ) b.minZ = pt.z;
+    if (pt.x > b.maxX) b.maxX = pt.x;
+    if (pt.y > b.maxY) b.maxY = pt.y;
+    if (pt.z > b.maxZ) b.maxZ = pt.z;
+}
+
+
+
+static MeshBounds joinBounds(const MeshBounds &a, const MeshBounds &b)
+{
+    MeshBounds j = {
+        std::min(a.minX, b.minX), std::max(a.maxX, b.maxX),
+        std::min(a.minY, b.minY), std::max(a.maxY, b.maxY),
+        std::min(a.minZ, b.minZ), std::max(a.maxZ, b.maxZ)
+    };
+    return j;
+}
+
+
+
+// Finds the bounds of runs of triangles side by side, then puts them
+//  together.
 void Mesh3d::recalculateBounds()
 {
-    Triangles3d::iterator it = triangles.begin();
-    minX = minY = minZ = 9e9;
-    maxX = maxY = maxZ = -9e9;
-    for ( ; it != triangles.end(); it++) {
-	Point3d &pt1 = it->vertex1;
-	Point3d &pt2 = it->vertex2;
-	Point3d &pt3 = it->vertex3;
-
-	if (pt1.x < minX) minX = pt1.x;
-	if (pt1.y < minY) minY = pt1.y;
-	if (pt1.z < minZ) minZ = pt1.z;
-	if (pt2.x < minX) minX = pt2.x;
-	if (pt2.y < minY) minY = pt2.y;
-	if (pt2.z < minZ) minZ = pt2.z;
-	if (pt3.x < minX) minX = pt3.x;
-	if (pt3.y < minY) minY = pt3.y;
-	if (pt3.z < minZ) minZ = pt3.z;
-
-	if (pt1.x > maxX) maxX = pt1.x;
-	if (pt1.y > maxY) maxY = pt1.y;
-	if (pt1.z > maxZ) maxZ = pt1.z;
-	if (pt2.x > maxX) maxX = pt2.x;
-	if (pt2.y > maxY) maxY = pt2.y;
-	if (pt2.z > maxZ) maxZ = pt2.z;
-	if (pt3.x > maxX) maxX = pt3.x;
-	if (pt3.y > maxY) maxY = pt3.y;
-	if (pt3.z > maxZ) maxZ = pt3.z;
-    }
+    MeshBounds none = { 9e9, -9e9, 9e9, -9e9, 9e9, -9e9 };
+    MeshBounds all = parallelReduce(Executor::current(), 0, triangles.size(), MESH_PASS_GRAIN, none,
+        [this](size_t first, size_t last, const MeshBounds &init) {
+            MeshBounds b = init;
+            for (size_t i = first; i < last; i++) {
+                growBounds(b, triangles[i].vertex1);
+                growBounds(b, triangles[i].vertex2);
+                growBounds(b, triangles[i].vertex3);
+            }
+            return b;
+        },
+        joinBounds);
+    setBounds(all);
+}
+
+
+
+// Takes on bounds found by a pass.  A mesh with nothing in it is all
+//  zeros.
+void Mesh3d::setBounds(const MeshBounds &b)
+{
+    minX = b.minX; maxX = b.maxX;
+    minY = b.minY; maxY = b.maxY;
+    minZ = b.minZ; maxZ = b.maxZ;
     if (minX == 9e9 || minY == 9e9 || minZ == 9e9) {
         minX = minY = minZ = maxX = maxY = maxZ = 0;
     }
@@ -86,12 +128,44 @@ void Mesh3d::recalculateBounds()
 
 
 
+// Grows the bounds to take in a triangle, without adding it.  Lets
+//  the bounds of a model be found without holding all of it at once.
+void Mesh3d::includeInBounds(const Triangle3d &tri)
+{
+    const Point3d &pt1 = tri.vertex1;
+    const Point3d &pt2 = tri.vertex2;
+    const Point3d &pt3 = tri.vertex3;
+
+    if (pt1.x < minX) minX = pt1.x;
+    if (pt1.y < minY) minY = pt1.y;
+    if (pt1.z < minZ) minZ = pt1.z;
+    if (pt2.x < minX) minX = pt2.x;
+    if (pt2.y < minY) minY = pt2.y;
+    if (pt2.z < minZ) minZ = pt2.z;
+    if (pt3.x < minX) minX = pt3.x;
+    if (pt3.y < minY) minY = pt3.y;
+    if (pt3.z < minZ) minZ = pt3.z;
+
+    if (pt1.x > maxX) maxX = pt1.x;
+    if (pt1.y > maxY) maxY = pt1.y;
+    if (pt1.z > maxZ) maxZ = pt1.z;
+    if (pt2.x > maxX) maxX = pt2.x;
+    if (pt2.y > maxY) maxY = pt2.y;
+    if (pt2.z > maxZ) maxZ = pt2.z;
+    if (pt3.x > maxX) maxX = pt3.x;
+    if (pt3.y > maxY) maxY = pt3.y;
+    if (pt3.z > maxZ) maxZ = pt3.z;
+}
+
+
+
 void Mesh3d::translate(double dx, double dy, double dz)
 {
-    Triangles3d::iterator it = triangles.begin();
-    for ( ; it != triangles.end(); it++) {
-        it->translate(dx,dy,dz);
-    }
+    parallelFor(Executor::current(), 0, triangles.size(), MESH_PASS_GRAIN, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            triangles[i].translate(dx,dy,dz);
+        }
+    });
     minX += dx;
     minY += dy;
     minZ += dz;
@@ -114,10 +188,12 @@ void Mesh3d::translateToCenterOfPlatform()
 
 void Mesh3d::scale(double sx, double sy, double sz)
 {
-    Triangles3d::iterator it = triangles.begin();
-    for ( ; it != triangles.end(); it++) {
-        it->scale(Point3d(sx,sy,sz));
-    }
+    Point3d vect(sx,sy,sz);
+    parallelFor(Executor::current(), 0, triangles.size(), MESH_PASS_GRAIN, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            triangles[i].scale(vect);
+        }
+    });
     minX *= sx;
     minY *= sy;
     minZ *= sz;
@@ -137,11 +213,12 @@ void Mesh3d::scale(double sf)
 
 void Mesh3d::rotateX(double rad)
 {
-    Triangles3d::iterator it = triangles.begin();
-    for ( ; it != triangles.end(); it++) {
-        it->rotateX(centerPoint(), rad);
-    }
-    recalculateBounds();
+    Point3d center = centerPoint();
+    Affine3d aff;
+    aff.translate(-center.x, -center.y, -center.z);
+    aff.rotateX(rad);
+    aff.translate(center.x, center.y, center.z);
+    transform(aff);
 }
 
 
@@ -149,11 +226,12 @@ void Mesh3d::rotateX(double rad)
 
 void Mesh3d::rotateY(double rad)
 {
-    Triangles3d::iterator it = triangles.begin();
-    for ( ; it != triangles.end(); it++) {
-        it->rotateY(centerPoint(), rad);
-    }
-    recalculateBounds();
+    Point3d center = centerPoint();
+    Affine3d aff;
+    aff.translate(-center.x, -center.y, -center.z);
+    aff.rotateY(rad);
+    aff.translate(center.x, center.y, center.z);
+    transform(aff);
 }
 
 
@@ -161,11 +239,92 @@ void Mesh3d::rotateY(double rad)
 
 void Mesh3d::rotateZ(double rad)
 {
-    Triangles3d::iterator it = triangles.begin();
-    for ( ; it != triangles.end(); it++) {
-        it->rotateZ(centerPoint(), rad);
+    Point3d center = centerPoint();
+    Affine3d aff;
+    aff.translate(-center.x, -center.y, -center.z);
+    aff.rotateZ(rad);
+    aff.translate(center.x, center.y, center.z);
+    transform(aff);
+}
+
+
+
+
+// Transforms every triangle, finding the new bounds as it goes, all in
+//  the one pass.
+void Mesh3d::transform(const Affine3d &aff)
+{
+    MeshBounds none = { 9e9, -9e9, 9e9, -9e9, 9e9, -9e9 };
+    MeshBounds all = parallelReduce(Executor::current(), 0, triangles.size(), MESH_PASS_GRAIN, none,
+        [&](size_t first, size_t last, const MeshBounds &init) {
+            MeshBounds b = init;
+            for (size_t i = first; i < last; i++) {
+                Triangle3d &tri = triangles[i];
+                aff.transformTriangle(tri);
+                growBounds(b, tri.vertex1);
+                growBounds(b, tri.vertex2);
+                growBounds(b, tri.vertex3);
+            }
+            return b;
+        },
+        joinBounds);
+    setBounds(all);
+}
+
+
+
+// The bounds the mesh would have if it were transformed, found without
+//  changing it.  The mesh returned holds just those bounds.
+Mesh3d Mesh3d::boundsAfter(const Affine3d &aff) const
+{
+    MeshBounds none = { 9e9, -9e9, 9e9, -9e9, 9e9, -9e9 };
+    MeshBounds all = parallelReduce(Executor::current(), 0, triangles.size(), MESH_PASS_GRAIN, none,
+        [&](size_t first, size_t last, const MeshBounds &init) {
+            MeshBounds b = init;
+            for (size_t i = first; i < last; i++) {
+                Triangle3d tri = triangles[i];
+                aff.transformTriangle(tri);
+                growBounds(b, tri.vertex1);
+                growBounds(b, tri.vertex2);
+                growBounds(b, tri.vertex3);
+            }
+            return b;
+        },
+        joinBounds);
+    Mesh3d bounds;
+    bounds.setBounds(all);
+    return bounds;
+}
+
+
+
+// Scales the mesh, rotates it around Z about its middle, and centers
+//  it on the platform, as scale(), rotateZ(), and
+//  translateToCenterOfPlatform() would one after another.  Those are
+//  put together into one transform first, so the triangles are only
+//  rewritten once.  Only a rotated mesh that's centered needs a look
+//  through first, to find where the rotation leaves it.
+void Mesh3d::place(double scaling, double rad, bool center)
+{
+    Affine3d aff;
+    Mesh3d placed;
+    placed.copyBoundsFrom(*this);
+    if (scaling != 1.0) {
+        aff.scale(scaling, scaling, scaling);
+        placed.scale(scaling);
+    }
+    if (rad != 0.0) {
+        aff.rotateZAroundPoint(rad, placed.centerPoint());
+        if (center) {
+            placed = boundsAfter(aff);
+        }
+    }
+    if (center) {
+        aff.translate(-(placed.maxX + placed.minX) / 2.0, -(placed.maxY + placed.minY) / 2.0, -placed.minZ);
+    }
+    if (!aff.isIdentity()) {
+        transform(aff);
     }
-    recalculateBounds();
 }
 
 
@@ -199,38 +358,70 @@ static inline void convertFromLittleEndian16(uint8_t* bytes)
 
 int32_t Mesh3d::loadFromSTLFile(const char *fileName)
 {
-    struct vertexes_t {
-        double nx, ny, nz;
-        double x1, y1, z1;
-        double x2, y2, z2;
-        double x3, y3, z3;
-        uint16_t attrBytes;
-    };
-    union {
-        struct vertexes_t vertexes;
-        uint8_t bytes[sizeof(vertexes_t)];
-    } tridata;
-    
+    FILE *f = fopen(fileName, "rb");
+    if (!f) {
+	fprintf(stderr, "STL read failed to open\n");
+	return 0;
+    }
+    int32_t facecount = loadFromSTLStream(f);
+    fclose(f);
+    return facecount;
+}
+
+
+
+// Reads an ASCII or binary STL from an open stream, which is left
+//  open for the caller to close.
+int32_t Mesh3d::loadFromSTLStream(FILE *f)
+{
+    STLReader reader(f);
+    if (!reader.ok()) {
+        return 0;
+    }
+    uint32_t facecount = 0;
+    if (reader.binary()) {
+        // Binary triangles are all the same size, so they can be read in
+        //  one go, and turned into triangles side by side.
+        std::string records;
+        facecount = reader.readRecords(records);
+        size_t first = triangles.size();
+        triangles.resize(first + facecount);
+        const uint8_t *bytes = (const uint8_t*)records.data();
+        parallelFor(Executor::current(), 0, facecount, MESH_PASS_GRAIN, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                STLReader::decodeRecord(bytes + i * STLReader::RECORD_SIZE, triangles[first + i]);
+            }
+        });
+        recalculateBounds();
+        return facecount;
+    }
+    Triangle3d tri;
+    while (reader.next(tri)) {
+        triangles.push_back(tri);
+        facecount++;
+    }
+    recalculateBounds();
+    return facecount;
+}
+
+
+
+// Reads the header of an ASCII or binary STL, leaving the stream at
+//  the first triangle.
+STLReader::STLReader(FILE *stream)
+    : f(stream), isBinary(true), remaining(0), good(false)
+{
     union {
         uint32_t intval;
         uint16_t shortval;
         uint8_t bytes[4];
     } intdata;
 
-    uint32_t facecount = 0;
-    
     uint8_t buf[512];
-    FILE *f = fopen(fileName, "rb");
-    if (!f) {
-	fprintf(stderr, "STL read failed to open\n");
-	return 0;
-    }
-    
     if (fread(buf, 1, 5, f) < 5) {
 	fprintf(stderr, "STL read failed read\n");
-	return 0;
+	return;
     }
-    bool isBinary = true;
     if (!strncasecmp((const char*)buf, "solid", 5)) {
         isBinary = false;
     }
@@ -239,85 +430,434 @@ int32_t Mesh3d::loadFromSTLFile(const char *fileName)
 	// Skip remainder of 80 character comment field
 	if (fread(buf, 1, 75, f) < 75) {
 	    fprintf(stderr, "STL read failed header read\n");
-	    return 0;
+	    return;
 	}
 	// Read in triangle count
 	if (fread(intdata.bytes, 1, 4, f) < 4) {
 	    fprintf(stderr, "STL read failed face count read\n");
-	    return 0;
+	    return;
 	}
 	convertFromLittleEndian32(intdata.bytes);
-	uint32_t tricount = intdata.intval;
-	while (!feof(f) && tricount-->0) {
-	    if (fread(tridata.bytes, 1, 3*4*4+2, f) < 3*4*4+2) {
-		break;
-	    }
-            for (int i = 0; i < 3*4; i++) {
-		convertFromLittleEndian32(tridata.bytes+i*4);
-            }
-	    convertFromLittleEndian16((uint8_t*)&tridata.vertexes.attrBytes);
-
-	    vertexes_t &v = tridata.vertexes;
-            Point3d pt1(v.x1, v.y1, v.z1);
-            Point3d pt2(v.x2, v.y2, v.z2);
-            Point3d pt3(v.x3, v.y3, v.z3);
-            triangles.push_back(Triangle3d(pt1, pt2, pt3));
-	    facecount++;
-        }
-	fclose(f);
+	remaining = intdata.intval;
     } else {
         // ASCII STL file
 	// Gobble remainder of solid name line.
 	fgets((char*)buf, sizeof(buf), f);
-	while (!feof(f)) {
-	    fscanf(f, "%80s", buf);
-	    if (!strcasecmp((char*)buf, "endsolid")) {
-	        break;
-	    }
-	    vertexes_t &v = tridata.vertexes;
-	    fscanf(f, "%*s %lf %lf %lf", &v.nx, &v.ny, &v.nz);
-	    fscanf(f, "%*s %*s");
-	    fscanf(f, "%*s %lf %lf %lf", &v.x1, &v.y1, &v.z1);
-	    fscanf(f, "%*s %lf %lf %lf", &v.x2, &v.y2, &v.z2);
-	    fscanf(f, "%*s %lf %lf %lf", &v.x3, &v.y3, &v.z3);
-	    fscanf(f, "%*s");
-	    fscanf(f, "%*s");
-
-            Point3d pt1(v.x1, v.y1, v.z1);
-            Point3d pt2(v.x2, v.y2, v.z2);
-            Point3d pt3(v.x3, v.y3, v.z3);
-            triangles.push_back(Triangle3d(pt1, pt2, pt3));
-	    facecount++;
+    }
+    good = true;
+}
+
+
+
+static inline float floatFromLittleEndian(const uint8_t* bytes)
+{
+    union {
+        float floatval;
+        uint8_t bytes[4];
+    } data;
+    memcpy(data.bytes, bytes, 4);
+    convertFromLittleEndian32(data.bytes);
+    return data.floatval;
+}
+
+
+
+// Turns one binary STL record into a triangle.  A record is a normal
+//  and three vertices, each three little-endian floats, then two bytes
+//  of attributes.  The normal and attributes aren't used.
+void STLReader::decodeRecord(const uint8_t *record, Triangle3d &tri)
+{
+    const uint8_t *v = record + 3*4;
+    tri = Triangle3d(
+        Point3d(floatFromLittleEndian(v+0), floatFromLittleEndian(v+4), floatFromLittleEndian(v+8)),
+        Point3d(floatFromLittleEndian(v+12), floatFromLittleEndian(v+16), floatFromLittleEndian(v+20)),
+        Point3d(floatFromLittleEndian(v+24), floatFromLittleEndian(v+28), floatFromLittleEndian(v+32))
+    );
+}
+
+
+
+// Reads the rest of a binary STL's records, undecoded, into out.  Reads
+//  a piece at a time, so a bad triangle count in the header can't ask
+//  for more memory than the file has data.  Returns how many whole
+//  records were read.
+uint32_t STLReader::readRecords(std::string &out)
+{
+    out.clear();
+    if (!good || !isBinary) {
+        return 0;
+    }
+    const size_t piece = 4096 * RECORD_SIZE;
+    size_t wanted = (size_t)remaining * RECORD_SIZE;
+    while (out.size() < wanted) {
+        size_t have = out.size();
+        size_t want = std::min(piece, wanted - have);
+        out.resize(have + want);
+        size_t cnt = fread(&out[have], 1, want, f);
+        if (cnt < want) {
+            out.resize(have + cnt);
+            good = false;
+            break;
+        }
+    }
+    uint32_t records = out.size() / RECORD_SIZE;
+    out.resize((size_t)records * RECORD_SIZE);
+    remaining -= records;
+    return records;
+}
+
+
+
+// Reads the next triangle.  Returns false at the end of the model.
+bool STLReader::next(Triangle3d &tri)
+{
+    if (!good || feof(f)) {
+        return false;
+    }
+    if (isBinary) {
+	if (remaining == 0) {
+	    return false;
+	}
+	remaining--;
+	uint8_t record[RECORD_SIZE];
+	if (fread(record, 1, RECORD_SIZE, f) < RECORD_SIZE) {
+	    good = false;
+	    return false;
 	}
-	fclose(f);
+	decodeRecord(record, tri);
+	return true;
     }
-    recalculateBounds();
-    return facecount;
+
+    double nx, ny, nz;
+    double x1, y1, z1;
+    double x2, y2, z2;
+    double x3, y3, z3;
+    char buf[512];
+    if (fscanf(f, "%80s", buf) != 1 || !strcasecmp(buf, "endsolid")) {
+	good = false;
+	return false;
+    }
+    fscanf(f, "%*s %lf %lf %lf", &nx, &ny, &nz);
+    fscanf(f, "%*s %*s");
+    fscanf(f, "%*s %lf %lf %lf", &x1, &y1, &z1);
+    fscanf(f, "%*s %lf %lf %lf", &x2, &y2, &z2);
+    fscanf(f, "%*s %lf %lf %lf", &x3, &y3, &z3);
+    fscanf(f, "%*s");
+    fscanf(f, "%*s");
+    tri = Triangle3d(Point3d(x1, y1, z1), Point3d(x2, y2, z2), Point3d(x3, y3, z3));
+    return true;
+}
+
+
+
+// A hash of every triangle exactly as it is, so that any change to the
+//  mesh, or how it's been placed, gives a different fingerprint.
+uint64_t Mesh3d::fingerprint() const
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    Triangles3d::const_iterator it;
+    for (it = triangles.begin(); it != triangles.end(); it++) {
+        hash = fnv1a(&*it, sizeof(Triangle3d), hash);
+    }
+    return hash;
+}
+
+
+
+// Header of a mesh cache file.  It's followed directly by the
+//  triangles, as laid out in memory, so it's a multiple of 8 bytes
+//  long to keep them aligned when the file is mapped.  Files written
+//  by a different version, or on a machine with a different byte order
+//  or Triangle3d layout, are refused rather than converted.
+struct MeshCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t triangleSize;
+    uint64_t byteOrder;
+    uint64_t triangleCount;
+    double bounds[6];
+};
+
+static const char MESH_CACHE_MAGIC[8] = { 'B', 'G', 'L', 'M', 'E', 'S', 'H', '\0' };
+static const uint32_t MESH_CACHE_VERSION = 1;
+static const uint64_t MESH_CACHE_BYTE_ORDER = 0x0102030405060708ULL;
+
+
+
+// Saves the mesh, as it is now, in a form that loadFromCacheFile() can
+//  map straight back in.  The file is written under a temporary name,
+//  then renamed, so readers never see a partial file.
+bool Mesh3d::saveToCacheFile(const char *fileName) const
+{
+    MeshCacheHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, MESH_CACHE_MAGIC, sizeof(hdr.magic));
+    hdr.version = MESH_CACHE_VERSION;
+    hdr.triangleSize = sizeof(Triangle3d);
+    hdr.byteOrder = MESH_CACHE_BYTE_ORDER;
+    hdr.triangleCount = triangles.size();
+    hdr.bounds[0] = minX;  hdr.bounds[1] = maxX;
+    hdr.bounds[2] = minY;  hdr.bounds[3] = maxY;
+    hdr.bounds[4] = minZ;  hdr.bounds[5] = maxZ;
+
+    std::string tmpName = std::string(fileName) + ".XXXXXX";
+    int fd = mkstemp(&tmpName[0]);
+    if (fd < 0) {
+        return false;
+    }
+    fchmod(fd, 0644);
+    FILE *f = fdopen(fd, "wb");
+    if (!f) {
+        close(fd);
+        unlink(tmpName.c_str());
+        return false;
+    }
+    bool ok = (fwrite(&hdr, sizeof(hdr), 1, f) == 1);
+    Triangles3d::const_iterator it;
+    for (it = triangles.begin(); ok && it != triangles.end(); it++) {
+        ok = (fwrite(&*it, sizeof(Triangle3d), 1, f) == 1);
+    }
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmpName.c_str(), fileName) != 0) {
+        unlink(tmpName.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+
+// Replaces this mesh with one saved by saveToCacheFile().  The file is
+//  mapped, and its triangles copied out as is, with no parsing.
+//  Returns false, leaving the mesh alone, if the file is missing, short,
+//  or not in this build's format.
+bool Mesh3d::loadFromCacheFile(const char *fileName)
+{
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(MeshCacheHeader)) {
+        close(fd);
+        return false;
+    }
+    size_t len = st.st_size;
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    // The count is checked against what fits before it's multiplied,
+    //  so a corrupt one can't wrap around and pass.
+    const MeshCacheHeader *hdr = (const MeshCacheHeader*)map;
+    size_t dataLen = len - sizeof(MeshCacheHeader);
+    bool ok = !memcmp(hdr->magic, MESH_CACHE_MAGIC, sizeof(hdr->magic)) &&
+              hdr->version == MESH_CACHE_VERSION &&
+              hdr->triangleSize == sizeof(Triangle3d) &&
+              hdr->byteOrder == MESH_CACHE_BYTE_ORDER &&
+              hdr->triangleCount <= dataLen / sizeof(Triangle3d) &&
+              dataLen == hdr->triangleCount * sizeof(Triangle3d);
+    if (ok) {
+        const Triangle3d *tris = (const Triangle3d*)(hdr + 1);
+        triangles.assign(tris, tris + hdr->triangleCount);
+        minX = hdr->bounds[0];  maxX = hdr->bounds[1];
+        minY = hdr->bounds[2];  maxY = hdr->bounds[3];
+        minZ = hdr->bounds[4];  maxZ = hdr->bounds[5];
+    }
+    munmap(map, len);
+    return ok;
 }
 
 
 
 CompoundRegion& Mesh3d::regionForSliceAtZ(double Z, CompoundRegion &outReg) const
 {
+    // Most triangles don't reach a given Z, so they're weeded out a
+    //  block at a time first, and only those left are sliced.  Work
+    //  that's been cancelled leaves the region as it was.
     Lines lines;
-    Triangles3d::const_iterator trit;
-    for (trit = triangles.begin(); trit != triangles.end(); trit++) {
-	Line ln;
-	if (trit->sliceAtZ(Z, ln)) {
-	    lines.push_back(ln);
+    uint32_t hits[SLICE_KERNEL_BLOCK];
+    for (size_t first = 0; first < triangles.size(); first += SLICE_KERNEL_BLOCK) {
+        if (cancelRequested()) {
+            outReg.zLevel = Z;
+            return outReg;
+        }
+        size_t count = std::min(SLICE_KERNEL_BLOCK, triangles.size() - first);
+        size_t found = trianglesReachingZ(&triangles[first], count, Z, hits);
+        for (size_t k = 0; k < found; k++) {
+            Line ln;
+            if (triangles[first + hits[k]].sliceAtZ(Z, ln)) {
+                lines.push_back(ln);
+            }
         }
     }
 
     Paths paths;
-    Path::assemblePathsFromSegments(lines, paths);
+    Path::assemblePathsFromSegments(std::move(lines), paths);
     Paths repairedPaths;
-    Path::repairUnclosedPaths(paths, repairedPaths);
-    CompoundRegion::assembleCompoundRegionFrom(repairedPaths, outReg);
+    Path::repairUnclosedPaths(std::move(paths), repairedPaths);
+    CompoundRegion::assembleCompoundRegionFrom(std::move(repairedPaths), outReg);
     outReg.zLevel = Z;
     return outReg;
 }
 
 
+
+// Finds slices that would come out the same as the slice below them.
+//  That is the case when both cut exactly the same set of triangles,
+//  and all of those are vertical, with no vertex on either plane.  The
+//  outline of a wall can then only differ by where collinear points
+//  fall along it.  Rather than compare triangle sets, each slice keeps
+//  an FNV-1a hash of the IDs of the triangles it cuts.
+//
+// STL files are single precision, so walls that are meant to be
+//  vertical rarely are exactly.  A triangle whose footprint on the XY
+//  plane is thinner than tolerance counts as vertical, and a repeated
+//  slice may then be off from its own true outline by up to that much.
+//
+// The zs must be in ascending order.  On return, sameAs[k] is the
+//  index of the lowest slice that slice k repeats, or k if none.
+//  Returns the number of slices that repeat a lower one.
+int32_t Mesh3d::findRepeatedSlices(const std::vector<double> &zs, double tolerance, std::vector<int32_t> &sameAs) const
+{
+    size_t count = zs.size();
+    std::vector<uint64_t> fingerprint(count, FNV_OFFSET_BASIS);
+    std::vector<int32_t> crossings(count, 0);
+    std::vector<bool> prismatic(count, true);
+
+    uint32_t id = 0;
+    Triangles3d::const_iterator trit;
+    for (trit = triangles.begin(); trit != triangles.end(); trit++, id++) {
+        const Point3d &v1 = trit->vertex1;
+        const Point3d &v2 = trit->vertex2;
+        const Point3d &v3 = trit->vertex3;
+        double lo = std::min(v1.z, std::min(v2.z, v3.z));
+        double hi = std::max(v1.z, std::max(v2.z, v3.z));
+        // Twice the footprint's area, over its longest side, is its width.
+        double cz = (v2.x-v1.x)*(v3.y-v1.y) - (v2.y-v1.y)*(v3.x-v1.x);
+        double longest = std::max(Point(v1).distanceFrom(Point(v2)),
+                         std::max(Point(v2).distanceFrom(Point(v3)), Point(v3).distanceFrom(Point(v1))));
+        bool vertical = fabs(cz) <= tolerance * longest + CLOSEENOUGH;
+
+        size_t k = std::lower_bound(zs.begin(), zs.end(), lo - CLOSEENOUGH) - zs.begin();
+        for ( ; k < count && zs[k] <= hi + CLOSEENOUGH; k++) {
+            if (!prismatic[k]) {
+                continue;
+            }
+            double Z = zs[k];
+            if (!vertical || v1 == Z || v2 == Z || v3 == Z) {
+                prismatic[k] = false;
+                continue;
+            }
+            for (int i = 0; i < 4; i++) {
+                fingerprint[k] ^= (id >> (i*8)) & 0xff;
+                fingerprint[k] *= FNV_PRIME;
+            }
+            crossings[k]++;
+        }
+    }
+
+    int32_t repeats = 0;
+    sameAs.resize(count);
+    for (size_t k = 0; k < count; k++) {
+        sameAs[k] = k;
+        if (k > 0 && prismatic[k] && prismatic[k-1] && crossings[k] > 0 &&
+            crossings[k] == crossings[k-1] && fingerprint[k] == fingerprint[k-1]
+        ) {
+            sameAs[k] = sameAs[k-1];
+            repeats++;
+        }
+    }
+    return repeats;
+}
+
+
+
+static void snapToGrid(Point3d &pt, double cellSize)
+{
+    pt.x = floor(pt.x / cellSize + 0.5) * cellSize;
+    pt.y = floor(pt.y / cellSize + 0.5) * cellSize;
+    pt.z = floor(pt.z / cellSize + 0.5) * cellSize;
+}
+
+
+
+static bool sameVertex(const Point3d &a, const Point3d &b)
+{
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+
+
+// Counts how many triangles reach each Z, as a guide to how long each
+//  layer will take to carve.  The triangles' lowest and highest Zs are
+//  sorted, so each count is just the difference of two searches.
+void Mesh3d::countCrossings(const std::vector<double> &zs, std::vector<uint32_t> &counts) const
+{
+    size_t count = triangles.size();
+    std::vector<double> lows(count), highs(count);
+    parallelFor(Executor::current(), 0, count, MESH_PASS_GRAIN, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            const Triangle3d &tri = triangles[i];
+            lows[i] = std::min(tri.vertex1.z, std::min(tri.vertex2.z, tri.vertex3.z));
+            highs[i] = std::max(tri.vertex1.z, std::max(tri.vertex2.z, tri.vertex3.z));
+            if (!(lows[i] <= highs[i])) {
+                // A NaN, which would upset the sort.  Such a triangle
+                //  never slices, so it's put out of reach.
+                lows[i] = highs[i] = HUGE_VAL;
+            }
+        }
+    });
+    std::sort(lows.begin(), lows.end());
+    std::sort(highs.begin(), highs.end());
+
+    counts.resize(zs.size());
+    for (size_t k = 0; k < zs.size(); k++) {
+        size_t started = std::upper_bound(lows.begin(), lows.end(), zs[k]) - lows.begin();
+        size_t ended = std::lower_bound(highs.begin(), highs.end(), zs[k]) - highs.begin();
+        counts[k] = started - ended;
+    }
+}
+
+
+
+// Coarsens the mesh by snapping every vertex to a grid of cubes
+//  cellSize on a side.  Vertices that fall in the same cube become
+//  one, and triangles left with two corners the same are dropped.
+//  Edges shared before are still shared after, so a closed mesh still
+//  slices into closed outlines, each within a cell of the original.
+//  Returns the number of triangles dropped.
+int32_t Mesh3d::decimate(double cellSize)
+{
+    if (cellSize <= 0.0) {
+        return 0;
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < triangles.size(); i++) {
+        Triangle3d &tri = triangles[i];
+        snapToGrid(tri.vertex1, cellSize);
+        snapToGrid(tri.vertex2, cellSize);
+        snapToGrid(tri.vertex3, cellSize);
+        if (sameVertex(tri.vertex1, tri.vertex2) ||
+            sameVertex(tri.vertex2, tri.vertex3) ||
+            sameVertex(tri.vertex3, tri.vertex1)
+        ) {
+            continue;
+        }
+        if (kept != i) {
+            triangles[kept] = tri;
+        }
+        kept++;
+    }
+    int32_t dropped = triangles.size() - kept;
+    triangles.resize(kept);
+    recalculateBounds();
+    return dropped;
+}
+
+
 }
 
 
@@ -10,13 +10,44 @@
 #ifndef BGL_MESH3D_H
 #define BGL_MESH3D_H
 
+#include <stdio.h>
+#include <string>
+#include <utility>
+#include <vector>
 #include "config.h"
 #include "BGLPoint3d.h"
 #include "BGLTriangle3d.h"
+#include "BGLAffine3d.h"
 
 namespace BGL {
 
 class CompoundRegion;
+struct MeshBounds;
+
+
+// Reads the triangles of an ASCII or binary STL one at a time, so a
+//  model can be gone through without ever being held all at once.
+class STLReader {
+private:
+    FILE *f;
+    bool isBinary;
+    uint32_t remaining;
+    bool good;
+
+public:
+    // Bytes in one binary STL triangle.
+    static const size_t RECORD_SIZE = 50;
+
+    STLReader(FILE *stream);
+
+    bool ok() const { return good; }
+    bool binary() const { return isBinary; }
+    bool next(Triangle3d &tri);
+    uint32_t readRecords(std::string &out);
+    static void decodeRecord(const uint8_t *record, Triangle3d &tri);
+};
+
+
 
 class Mesh3d {
 public:
@@ -27,10 +58,28 @@ public:
 
     Mesh3d() : triangles(), minX(9e9), maxX(-9e9), minY(9e9), maxY(-9e9), minZ(9e9), maxZ(-9e9) {}
     Mesh3d(const Mesh3d& x) : triangles(x.triangles), minX(x.minX), maxX(x.maxX), minY(x.minY), maxY(x.maxY), minZ(x.minZ), maxZ(x.maxZ) {}
+    Mesh3d(Mesh3d&& x) : triangles(std::move(x.triangles)), minX(x.minX), maxX(x.maxX), minY(x.minY), maxY(x.maxY), minZ(x.minZ), maxZ(x.maxZ) {}
+
+    // Assignment operators
+    Mesh3d& operator=(const Mesh3d &rhs) {
+	if (this != &rhs) {
+	    triangles = rhs.triangles;
+	    copyBoundsFrom(rhs);
+	}
+	return *this;
+    }
+    Mesh3d& operator=(Mesh3d &&rhs) {
+	if (this != &rhs) {
+	    triangles = std::move(rhs.triangles);
+	    copyBoundsFrom(rhs);
+	}
+	return *this;
+    }
 
     int32_t size();
     Point3d centerPoint() const;
     void recalculateBounds();
+    void includeInBounds(const Triangle3d &tri);
 
     void translateToCenterOfPlatform();
     void translate(double dx, double dy, double dz);
@@ -39,9 +88,27 @@ public:
     void rotateX(double rad);
     void rotateY(double rad);
     void rotateZ(double rad);
+    void transform(const Affine3d &aff);
+    Mesh3d boundsAfter(const Affine3d &aff) const;
+    void place(double scaling, double rad, bool center);
 
     int32_t loadFromSTLFile(const char *fileName);
+    int32_t loadFromSTLStream(FILE *f);
+    bool saveToCacheFile(const char *fileName) const;
+    bool loadFromCacheFile(const char *fileName);
+    uint64_t fingerprint() const;
     CompoundRegion& regionForSliceAtZ(double Z, CompoundRegion &outReg) const;
+    int32_t findRepeatedSlices(const std::vector<double> &zs, double tolerance, std::vector<int32_t> &sameAs) const;
+    void countCrossings(const std::vector<double> &zs, std::vector<uint32_t> &counts) const;
+    int32_t decimate(double cellSize);
+
+private:
+    void setBounds(const MeshBounds &b);
+    void copyBoundsFrom(const Mesh3d& x) {
+        minX = x.minX; maxX = x.maxX;
+        minY = x.minY; maxY = x.maxY;
+        minZ = x.minZ; maxZ = x.maxZ;
+    }
 };
 
 }
@@ -0,0 +1,29 @@
+//
+//  BGLParallel.cc
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/27/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#include "BGLParallel.h"
+
+namespace BGL {
+
+
+Executor* Executor::theCurrent = NULL;
+
+
+
+// Returns the executor that was current before.
+Executor* Executor::setCurrent(Executor* executor)
+{
+    Executor* previous = theCurrent;
+    theCurrent = executor;
+    return previous;
+}
+
+
+}
+
+
@@ -0,0 +1,101 @@
+//
+//  BGLParallel.h
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/27/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#ifndef BGL_PARALLEL_H
+#define BGL_PARALLEL_H
+
+#include <stddef.h>
+#include <vector>
+#include <functional>
+#include "config.h"
+
+namespace BGL {
+
+
+// Triangles each chunk of a whole-mesh pass takes on.  Big enough that
+//  handing out a chunk costs next to nothing beside doing it.
+const size_t MESH_PASS_GRAIN = 16384;
+
+
+
+// Something that can run the pieces of a loop side by side, such as a
+//  thread pool.  BGL has no threads of its own; whoever has some hands
+//  them to the library with setCurrent().  With none set, loops just
+//  run on the calling thread.
+class Executor {
+private:
+    static Executor* theCurrent;
+
+public:
+    virtual ~Executor() {}
+
+    // Calls body(first, last) for consecutive subranges that together
+    //  cover [begin, end), each no more than grain long, and returns once
+    //  they're all done.  Subranges may run in any order, on any thread,
+    //  so body must only touch what its own subrange owns.  An executor
+    //  with just the one thread may do the whole range in one call.
+    virtual void parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)> &body) = 0;
+
+    // The executor whole-mesh passes run on, for the whole process.
+    static Executor* current() { return theCurrent; }
+    static Executor* setCurrent(Executor* executor);
+};
+
+
+
+// Runs a loop on the given executor, or right here, in one call, with
+//  none, or when it's no bigger than grain.
+inline void parallelFor(Executor* executor, size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)> &body)
+{
+    if (begin >= end) {
+        return;
+    }
+    if (executor && end - begin > grain) {
+        executor->parallelFor(begin, end, grain, body);
+    } else {
+        body(begin, end);
+    }
+}
+
+
+
+// Splits [begin, end) into runs of grain, reduces each run to one value
+//  with body(first, last, identity), side by side, then joins those in
+//  order, left to right.  The runs don't depend on how many threads
+//  there are, so neither does the result, even when join isn't exact,
+//  as with adding up doubles.
+template <class T, class Body, class Join>
+T parallelReduce(Executor* executor, size_t begin, size_t end, size_t grain, const T &identity, Body body, Join join)
+{
+    if (begin >= end) {
+        return identity;
+    }
+    if (grain < 1) {
+        grain = 1;
+    }
+    size_t runs = (end - begin + grain - 1) / grain;
+    std::vector<T> partial(runs, identity);
+    parallelFor(executor, 0, runs, 1, [&](size_t first, size_t last) {
+        for (size_t r = first; r < last; r++) {
+            size_t lo = begin + r * grain;
+            size_t hi = (end - lo > grain) ? lo + grain : end;
+            partial[r] = body(lo, hi, identity);
+        }
+    });
+    T result = partial[0];
+    for (size_t r = 1; r < runs; r++) {
+        result = join(result, partial[r]);
+    }
+    return result;
+}
+
+
+}
+
+#endif
+
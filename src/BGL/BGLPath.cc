@@ -10,6 +10,8 @@
 #include <iomanip>
 
 #include "BGLPath.h"
+#include "BGLSimplifier.h"
+#include "BGLCancel.h"
 
 using namespace std;
 using namespace BGL;
@@ -110,6 +112,16 @@ Path& Path::operator/=(const Point &rhs) {
 
 
 
+Path& Path::transform(const Affine &aff) {
+    Lines::iterator it;
+    for (it = segments.begin(); it != segments.end(); it++) {
+        it->transform(aff);
+    }
+    return *this;
+}
+
+
+
 double Path::length() const
 {
     double totlen = 0.0f;
@@ -247,6 +259,47 @@ bool Path::attach(const Path& path)
 
 
 
+// Like attach(const Path&), but splices the segments over instead of
+//  copying them when the given path continues on from our end.
+bool Path::attach(Path&& path)
+{
+    if (size() <= 0 || (path.size() > 0 && endPoint() == path.startPoint())) {
+        segments.splice(segments.end(), path.segments);
+        return true;
+    }
+    return attach(static_cast<const Path&>(path));
+}
+
+
+
+// Moves the given segment out of lines, and attaches it to this path.
+//  The list node is relinked rather than copied.  If the segment doesn't
+//  connect to either end of this path, it is left where it was.
+bool Path::attach(Lines& lines, Lines::iterator seg)
+{
+    if (size() <= 0 || endPoint() == seg->startPt) {
+        segments.splice(segments.end(), lines, seg);
+        return true;
+    }
+    if (startPoint() == seg->endPt) {
+        segments.splice(segments.begin(), lines, seg);
+        return true;
+    }
+    if (endPoint() == seg->endPt) {
+        seg->reverse();
+        segments.splice(segments.end(), lines, seg);
+        return true;
+    }
+    if (startPoint() == seg->startPt) {
+        seg->reverse();
+        segments.splice(segments.begin(), lines, seg);
+        return true;
+    }
+    return false;
+}
+
+
+
 string Path::svgPathWithOffset(double dx, double dy) const
 {
     char buf[80];
@@ -481,29 +534,46 @@ void Path::simplify(double minErr)
 
 
 
+// Removes as many vertices as it can without moving the path more
+//  than tolerance, or letting it cross itself.  Returns the number of
+//  vertices removed.
+int Path::decimate(double tolerance)
+{
+    Simplifier simplifier;
+    simplifier.addPath(*this);
+    return simplifier.simplify(tolerance);
+}
+
+
+
 Paths &Path::assemblePathsFromSegments(const Lines &segs, Paths &outPaths)
 {
-    Lines unhandled(segs);
+    return assemblePathsFromSegments(Lines(segs), outPaths);
+}
+
+
+
+// Consumes segs.  Segments are spliced into the assembled paths, so
+//  no Line is copied along the way.
+Paths &Path::assemblePathsFromSegments(Lines &&segs, Paths &outPaths)
+{
+    Lines unhandled(std::move(segs));
     Path currPath;
     bool foundLink = false;
     while (unhandled.size() > 0) {
         if (currPath.size() == 0) {
-            Line ln = unhandled.front();
-            currPath.attach(ln);
-            unhandled.pop_front();
+            currPath.attach(unhandled, unhandled.begin());
         }
         foundLink = false;
         Lines::iterator itera = unhandled.begin();
         while (itera != unhandled.end()) {
-            if (currPath.attach(*itera)) {
-                itera = unhandled.erase(itera);
+            Lines::iterator seg = itera++;
+            if (currPath.attach(unhandled, seg)) {
                 foundLink = true;
-            } else {
-                itera++;
             }
         }
         if (!foundLink || unhandled.size() == 0) {
-            outPaths.push_back(currPath);
+            outPaths.push_back(std::move(currPath));
             currPath = Path();
         }
     }
@@ -514,22 +584,28 @@ Paths &Path::assemblePathsFromSegments(const Lines &segs, Paths &outPaths)
 
 Paths &Path::repairUnclosedPaths(const Paths &paths, Paths &outPaths)
 {
-    Paths unhandled(paths);
+    return repairUnclosedPaths(Paths(paths), outPaths);
+}
+
+
+
+// Consumes paths.  Closed paths are spliced straight into outPaths.
+Paths &Path::repairUnclosedPaths(Paths &&paths, Paths &outPaths)
+{
+    Paths unhandled(std::move(paths));
     
     // filter out all completed paths.
     Paths::iterator itera = unhandled.begin();
     while (itera != unhandled.end()) {
-        if (itera->isClosed()) {
-            outPaths.push_back(*itera);
-            itera = unhandled.erase(itera);
-        } else {
-            itera++;
+        Paths::iterator curr = itera++;
+        if (curr->isClosed()) {
+            outPaths.splice(outPaths.end(), unhandled, curr);
         }
     }
     
     // Now we just have incomplete paths left.
     while (unhandled.size() > 0) {
-        Path path = unhandled.front();
+        Path path(std::move(unhandled.front()));
         unhandled.pop_front();
         for (;;) {
             // Find closest remaining incomplete path
@@ -553,7 +629,7 @@ Paths &Path::repairUnclosedPaths(const Paths &paths, Paths &outPaths)
             if (closestDist < closingDist) {
                 Path &path2 = *closestIter;
                 path.attach(Line(path.endPoint(),path2.startPoint()));
-                path.attach(path2);
+                path.attach(std::move(path2));
                 closestIter = unhandled.erase(closestIter);
             } else {
                 // Closest found match is if we just close the path.
@@ -565,7 +641,7 @@ Paths &Path::repairUnclosedPaths(const Paths &paths, Paths &outPaths)
             }
             if (path.isClosed()) {
                 // Path has been closed.  On to the next path!
-                outPaths.push_back(path);
+                outPaths.push_back(std::move(path));
                 break;
             }
         }
@@ -902,22 +978,19 @@ Paths &Path::unionOf(Paths &paths, Paths &outPaths)
 {
     Paths::iterator it1;
     Paths::iterator it2;
-    Paths::iterator it3;
 
     for (it1 = paths.begin(); it1 != paths.end(); it1++) {
         outPaths.push_back(*it1);
     }
     
-    for (it1 = outPaths.begin(); it1 != outPaths.end(); ) {
+    for (it1 = outPaths.begin(); it1 != outPaths.end() && !cancelRequested(); ) {
         bool found = false;
         for (it2 = it1; it2 != outPaths.end(); it2++) {
             if (it1 != it2) {
                 Paths tempPaths;
                 Path::unionOf(*it1, *it2, tempPaths);
                 if (tempPaths.size() < 2) {
-                    for (it3 = tempPaths.begin(); it3 != tempPaths.end(); it3++) {
-                        outPaths.push_back(*it3);
-                    }
+                    outPaths.splice(outPaths.end(), tempPaths);
                     it2 = outPaths.erase(it2);
                     it1 = outPaths.erase(it1);
                     found = true;
@@ -940,12 +1013,12 @@ Paths &Path::differenceOf  (Paths &paths1, Paths &paths2, Paths &outPaths)
     Paths::iterator it2;
 
     outPaths = paths1;
-    for (it2 = paths2.begin(); it2 != paths2.end(); it2++) {
+    for (it2 = paths2.begin(); it2 != paths2.end() && !cancelRequested(); it2++) {
         Paths tempPaths;
         for (it1 = outPaths.begin(); it1 != outPaths.end(); it1++) {
             Path::differenceOf(*it1, *it2, tempPaths);
         }
-        outPaths = tempPaths;
+        outPaths = std::move(tempPaths);
     }
     return outPaths;
 }
@@ -10,6 +10,7 @@
 #define BGL_PATH_H
 
 #include <list>
+#include <utility>
 #include "config.h"
 #include "BGLCommon.h"
 #include "BGLAffine.h"
@@ -17,13 +18,14 @@
 #include "BGLIntersection.h"
 #include "BGLPoint.h"
 #include "BGLLine.h"
+#include "BGLShared.h"
 
 using namespace std;
 
 namespace BGL {
 
 class Path;
-typedef list<Path> Paths;
+typedef list<Path, ArenaAllocator<Path> > Paths;
 
 class Path {
 public:
@@ -34,9 +36,11 @@ public:
     Path() : flags(0), segments() {}
     Path(int cnt, const Point* pts);
     Path(const Lines& x) : flags(0), segments(x) {}
+    Path(Lines&& x) : flags(0), segments(std::move(x)) {}
     Path(const Path& x) : flags(x.flags), segments(x.segments) {}
+    Path(Path&& x) : flags(x.flags), segments(std::move(x.segments)) {}
 
-    // Assignment operator
+    // Assignment operators
     Path& operator=(const Path &rhs) {
         if (this != &rhs) {
             flags = rhs.flags;
@@ -44,6 +48,13 @@ public:
         }
         return *this;
     }
+    Path& operator=(Path &&rhs) {
+        if (this != &rhs) {
+            flags = rhs.flags;
+            segments = std::move(rhs.segments);
+        }
+        return *this;
+    }
 
     // Comparison operators
     bool operator==(const Path &rhs) const;
@@ -58,6 +69,7 @@ public:
     Path& operator*=(const Point &rhs);
     Path& operator/=(double rhs);
     Path& operator/=(const Point &rhs);
+    Path& transform(const Affine &aff);
 
     // Binary arithmetic operators
     const Path operator+(const Point &rhs) const {
@@ -107,6 +119,8 @@ public:
     bool couldAttach(const Path& path) const;
     bool attach(const Line& ln);
     bool attach(const Path& path);
+    bool attach(Path&& path);
+    bool attach(Lines& lines, Lines::iterator seg);
 
     string svgPathWithOffset(double dx, double dy) const;
     ostream &svgPathDataWithOffset(ostream& os, double dx, double dy) const;
@@ -135,6 +149,7 @@ public:
     // Strips out segments that are shorter than the given length.
     void stripSegmentsShorterThan(double minlen);
     void simplify(double minErr);
+    int decimate(double tolerance);
     void splitSegmentsAtIntersectionsWithPath(const Path &path);
     Paths &separateSelfIntersectingSubpaths(Paths &outPaths);
     void reorderByPoint(const Point &pt);
@@ -143,7 +158,9 @@ public:
     void tagSegmentsRelativeToClosedPath(const Path &path);
 
     static Paths &assemblePathsFromSegments(const Lines &segs, Paths &outPaths);
+    static Paths &assemblePathsFromSegments(Lines &&segs, Paths &outPaths);
     static Paths &repairUnclosedPaths(const Paths &paths, Paths &outPaths);
+    static Paths &repairUnclosedPaths(Paths &&paths, Paths &outPaths);
     static Paths &assembleTaggedPaths(Path &path1, uint32_t flags1, Path &path2, uint32_t flags2, Paths &outPaths);
 
     static Paths &differenceOf  (Path &path1, Path &path2, Paths &outPaths);
@@ -163,6 +180,7 @@ public:
     friend ostream& operator <<(ostream &os,const Path &pt);
 
 };
+typedef Shared<Path> SharedPath;
 
 
 
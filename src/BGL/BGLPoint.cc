@@ -2,14 +2,19 @@
 
 namespace BGL {
 
-ostream& operator <<(ostream &os,const Point &pt)
+template <class C>
+ostream& operator <<(ostream &os,const BasicPoint<C> &pt)
 {
     os.precision(3);
     os.setf(ios::fixed);
-    os << "(" << pt.x << ", " << pt.y << ")";
+    os << "(" << C::toDouble(pt.x) << ", " << C::toDouble(pt.y) << ")";
     return os;
 }
 
+template ostream& operator <<(ostream &os,const BasicPoint<DoubleCoord> &pt);
+template ostream& operator <<(ostream &os,const BasicPoint<FloatCoord> &pt);
+template ostream& operator <<(ostream &os,const BasicPoint<FixedCoord> &pt);
+
 }
 
 
@@ -14,6 +14,7 @@
 #include <list>
 #include "config.h"
 #include "BGLCommon.h"
+#include "BGLArena.h"
 #include "BGLAffine.h"
 #include "BGLPoint3d.h"
 
@@ -22,83 +23,80 @@ using namespace std;
 namespace BGL {
 
 
-class Point {
+template <class C>
+class BasicPoint {
 public:
+    typedef typename C::value_type Coord;
+
     // Member variables
-    double x, y;
+    Coord x, y;
 
     // Constructors
-    Point() : x(0.0), y(0.0) {}
-    Point(double nux, double nuy) : x(nux), y(nuy) {}
-    Point(const Point &pt) : x(pt.x), y(pt.y) {}
-    Point(const Point3d &pt) : x(pt.x), y(pt.y) {}
-
-    // Assignment operator
-    Point& operator=(const Point &rhs) {
-	if (this != &rhs) {
-	    this->x = rhs.x;
-	    this->y = rhs.y;
-	}
-	return *this;
-    }
+    BasicPoint() : x(0), y(0) {}
+    BasicPoint(double nux, double nuy) : x(C::fromDouble(nux)), y(C::fromDouble(nuy)) {}
+    BasicPoint(const BasicPoint3d<C> &pt) : x(pt.x), y(pt.y) {}
+    template <class D>
+    explicit BasicPoint(const BasicPoint<D> &pt) : x(C::fromDouble(D::toDouble(pt.x))), y(C::fromDouble(D::toDouble(pt.y))) {}
+
+    // Copies and moves are left to the compiler, so Points stay trivially copyable.
 
     // Compound assignment operators
-    Point& operator+=(const Point &rhs) {
+    BasicPoint& operator+=(const BasicPoint &rhs) {
         this->x += rhs.x;
         this->y += rhs.y;
 	return *this;
     }
-    Point& operator-=(const Point &rhs) {
+    BasicPoint& operator-=(const BasicPoint &rhs) {
         this->x -= rhs.x;
         this->y -= rhs.y;
 	return *this;
     }
-    Point& operator*=(double rhs) {
-        this->x *= rhs;
-        this->y *= rhs;
+    BasicPoint& operator*=(double rhs) {
+        this->x = C::fromDouble(C::toDouble(this->x) * rhs);
+        this->y = C::fromDouble(C::toDouble(this->y) * rhs);
 	return *this;
     }
-    Point& operator*=(const Point &rhs) {
-        this->x *= rhs.x;
-        this->y *= rhs.y;
+    BasicPoint& operator*=(const BasicPoint &rhs) {
+        this->x = C::fromDouble(C::toDouble(this->x) * C::toDouble(rhs.x));
+        this->y = C::fromDouble(C::toDouble(this->y) * C::toDouble(rhs.y));
 	return *this;
     }
-    Point& operator/=(double rhs) {
-        this->x /= rhs;
-        this->y /= rhs;
+    BasicPoint& operator/=(double rhs) {
+        this->x = C::fromDouble(C::toDouble(this->x) / rhs);
+        this->y = C::fromDouble(C::toDouble(this->y) / rhs);
 	return *this;
     }
-    Point& operator/=(const Point &rhs) {
-        this->x /= rhs.x;
-        this->y /= rhs.y;
+    BasicPoint& operator/=(const BasicPoint &rhs) {
+        this->x = C::fromDouble(C::toDouble(this->x) / C::toDouble(rhs.x));
+        this->y = C::fromDouble(C::toDouble(this->y) / C::toDouble(rhs.y));
 	return *this;
     }
 
     // Binary arithmetic operators
-    const Point operator+(const Point &rhs) const {
-	return Point(*this) += rhs;
+    const BasicPoint operator+(const BasicPoint &rhs) const {
+	return BasicPoint(*this) += rhs;
     }
-    const Point operator-(const Point &rhs) const {
-	return Point(*this) -= rhs;
+    const BasicPoint operator-(const BasicPoint &rhs) const {
+	return BasicPoint(*this) -= rhs;
     }
-    const Point operator*(double rhs) const {
-	return Point(*this) *= rhs;
+    const BasicPoint operator*(double rhs) const {
+	return BasicPoint(*this) *= rhs;
     }
-    const Point operator*(const Point &rhs) const {
-	return Point(*this) *= rhs;
+    const BasicPoint operator*(const BasicPoint &rhs) const {
+	return BasicPoint(*this) *= rhs;
     }
-    const Point operator/(double rhs) const {
-	return Point(*this) /= rhs;
+    const BasicPoint operator/(double rhs) const {
+	return BasicPoint(*this) /= rhs;
     }
-    const Point operator/(const Point &rhs) const {
-	return Point(*this) /= rhs;
+    const BasicPoint operator/(const BasicPoint &rhs) const {
+	return BasicPoint(*this) /= rhs;
     }
 
     // Comparison operators
-    bool operator==(const Point &rhs) const {
-        return (fabs(x-rhs.x) < CLOSEENOUGH &&  fabs(y-rhs.y) < CLOSEENOUGH);
+    bool operator==(const BasicPoint &rhs) const {
+        return (fabs(C::toDouble(x-rhs.x)) < C::closeEnough() &&  fabs(C::toDouble(y-rhs.y)) < C::closeEnough());
     }
-    bool operator>=(const Point &rhs) const {
+    bool operator>=(const BasicPoint &rhs) const {
 	if (x < rhs.x) {
 	    return false;
 	}
@@ -107,7 +105,7 @@ public:
 	}
 	return true;
     }
-    bool operator<=(const Point &rhs) const {
+    bool operator<=(const BasicPoint &rhs) const {
 	if (x > rhs.x) {
 	    return false;
 	}
@@ -116,59 +114,71 @@ public:
 	}
 	return true;
     }
-    bool operator>(const Point &rhs) const {
+    bool operator>(const BasicPoint &rhs) const {
         return !(*this <= rhs);
     }
-    bool operator<(const Point &rhs) const {
+    bool operator<(const BasicPoint &rhs) const {
         return !(*this >= rhs);
     }
-    bool operator!=(const Point &rhs) const {
+    bool operator!=(const BasicPoint &rhs) const {
         return !(*this == rhs);
     }
 
     // Transformations
-    Point& scale(double scale) {
+    BasicPoint& scale(double scale) {
 	*this *= scale;
 	return *this;
     }
-    Point& scale(const Point& vect) {
+    BasicPoint& scale(const BasicPoint& vect) {
 	*this *= vect;
 	return *this;
     }
-    Point& scaleAroundPoint(const Point& center, double scale) {
+    BasicPoint& scaleAroundPoint(const BasicPoint& center, double scale) {
 	*this -= center;
 	*this *= scale;
 	*this += center;
 	return *this;
     }
-    Point& scaleAroundPoint(const Point& center, const Point& vect) {
+    BasicPoint& scaleAroundPoint(const BasicPoint& center, const BasicPoint& vect) {
 	*this -= center;
 	*this *= vect;
 	*this += center;
 	return *this;
     }
+    BasicPoint& transform(const Affine& aff) {
+	double px = C::toDouble(x);
+	double py = C::toDouble(y);
+	aff.transformPoint(px, py);
+	x = C::fromDouble(px);
+	y = C::fromDouble(py);
+	return *this;
+    }
 
     // Calculations
-    double distanceFrom(const Point& pt) const {
-        Point delta = *this - pt;
-	return hypot(delta.y,delta.x);
+    double distanceFrom(const BasicPoint& pt) const {
+        BasicPoint delta = *this - pt;
+	return hypot(C::toDouble(delta.y),C::toDouble(delta.x));
     }
-    double angleToPoint(const Point& pt) const {
-        Point delta = *this - pt;
-	return atan2(delta.y,delta.x);
+    double angleToPoint(const BasicPoint& pt) const {
+        BasicPoint delta = *this - pt;
+	return atan2(C::toDouble(delta.y),C::toDouble(delta.x));
     }
 
-    Point &polarOffset(double ang, double rad) {
-        x += rad*cos(ang);
-	y += rad*sin(ang);
+    BasicPoint &polarOffset(double ang, double rad) {
+        x = C::fromDouble(C::toDouble(x) + rad*cos(ang));
+	y = C::fromDouble(C::toDouble(y) + rad*sin(ang));
 	return *this;
     }
-
-    // Friend functions
-    friend ostream& operator <<(ostream &os,const Point &pt);
 };
 
-typedef list<Point> Points;
+template <class C>
+ostream& operator <<(ostream &os,const BasicPoint<C> &pt);
+
+typedef BasicPoint<DoubleCoord> Point;
+typedef BasicPoint<FloatCoord> PointF;
+typedef BasicPoint<FixedCoord> PointX;
+
+typedef list<Point, ArenaAllocator<Point> > Points;
 
 
 
@@ -2,14 +2,19 @@
 
 namespace BGL {
 
-ostream& operator <<(ostream &os,const Point3d &pt)
+template <class C>
+ostream& operator <<(ostream &os,const BasicPoint3d<C> &pt)
 {
     os.precision(2);
     os.setf(ios::fixed);
-    os << "(" << pt.x << ", " << pt.y << ", " << pt.z << ")";
+    os << "(" << C::toDouble(pt.x) << ", " << C::toDouble(pt.y) << ", " << C::toDouble(pt.z) << ")";
     return os;
 }
 
+template ostream& operator <<(ostream &os,const BasicPoint3d<DoubleCoord> &pt);
+template ostream& operator <<(ostream &os,const BasicPoint3d<FloatCoord> &pt);
+template ostream& operator <<(ostream &os,const BasicPoint3d<FixedCoord> &pt);
+
 
 }
 
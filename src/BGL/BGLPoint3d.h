@@ -18,101 +18,98 @@ using namespace std;
 
 namespace BGL {
 
-class Point3d {
+template <class C>
+class BasicPoint3d {
 public:
+    typedef typename C::value_type Coord;
+
     // Member variables
-    double x, y, z;
+    Coord x, y, z;
 
     // Constructors
-    Point3d() : x(0.0), y(0.0), z(0.0) {}
-    Point3d(double nux, double nuy, double nuz) : x(nux), y(nuy), z(nuz) {}
-    Point3d(const Point3d &pt) : x(pt.x), y(pt.y), z(pt.z) {}
-
-    // Assignment operator
-    Point3d& operator=(const Point3d &rhs) {
-	if (this != &rhs) {
-	    this->x = rhs.x;
-	    this->y = rhs.y;
-	    this->z = rhs.z;
-	}
-	return *this;
-    }
+    BasicPoint3d() : x(0), y(0), z(0) {}
+    BasicPoint3d(double nux, double nuy, double nuz) : x(C::fromDouble(nux)), y(C::fromDouble(nuy)), z(C::fromDouble(nuz)) {}
+    template <class D>
+    explicit BasicPoint3d(const BasicPoint3d<D> &pt) :
+        x(C::fromDouble(D::toDouble(pt.x))), y(C::fromDouble(D::toDouble(pt.y))), z(C::fromDouble(D::toDouble(pt.z))) {}
+
+    // Copies and moves are left to the compiler, so Point3ds stay trivially copyable.
 
     // Compound assignment operators
-    Point3d& operator+=(const Point3d &rhs) {
+    BasicPoint3d& operator+=(const BasicPoint3d &rhs) {
         this->x += rhs.x;
         this->y += rhs.y;
         this->z += rhs.z;
 	return *this;
     }
-    Point3d& operator-=(const Point3d &rhs) {
+    BasicPoint3d& operator-=(const BasicPoint3d &rhs) {
         this->x -= rhs.x;
         this->y -= rhs.y;
         this->z -= rhs.z;
 	return *this;
     }
-    Point3d& operator*=(double rhs) {
-        this->x *= rhs;
-        this->y *= rhs;
-        this->z *= rhs;
+    BasicPoint3d& operator*=(double rhs) {
+        this->x = C::fromDouble(C::toDouble(this->x) * rhs);
+        this->y = C::fromDouble(C::toDouble(this->y) * rhs);
+        this->z = C::fromDouble(C::toDouble(this->z) * rhs);
 	return *this;
     }
-    Point3d& operator*=(const Point3d &rhs) {
-        this->x *= rhs.x;
-        this->y *= rhs.y;
-        this->z *= rhs.z;
+    BasicPoint3d& operator*=(const BasicPoint3d &rhs) {
+        this->x = C::fromDouble(C::toDouble(this->x) * C::toDouble(rhs.x));
+        this->y = C::fromDouble(C::toDouble(this->y) * C::toDouble(rhs.y));
+        this->z = C::fromDouble(C::toDouble(this->z) * C::toDouble(rhs.z));
 	return *this;
     }
-    Point3d& operator/=(double rhs) {
-        this->x /= rhs;
-        this->y /= rhs;
-        this->z /= rhs;
+    BasicPoint3d& operator/=(double rhs) {
+        this->x = C::fromDouble(C::toDouble(this->x) / rhs);
+        this->y = C::fromDouble(C::toDouble(this->y) / rhs);
+        this->z = C::fromDouble(C::toDouble(this->z) / rhs);
 	return *this;
     }
-    Point3d& operator/=(const Point3d &rhs) {
-        this->x /= rhs.x;
-        this->y /= rhs.y;
-        this->z /= rhs.z;
+    BasicPoint3d& operator/=(const BasicPoint3d &rhs) {
+        this->x = C::fromDouble(C::toDouble(this->x) / C::toDouble(rhs.x));
+        this->y = C::fromDouble(C::toDouble(this->y) / C::toDouble(rhs.y));
+        this->z = C::fromDouble(C::toDouble(this->z) / C::toDouble(rhs.z));
 	return *this;
     }
 
     // Binary arithmetic operators
-    const Point3d operator+(const Point3d &rhs) const {
-	return Point3d(*this) += rhs;
+    const BasicPoint3d operator+(const BasicPoint3d &rhs) const {
+	return BasicPoint3d(*this) += rhs;
     }
-    const Point3d operator-(const Point3d &rhs) const {
-	return Point3d(*this) -= rhs;
+    const BasicPoint3d operator-(const BasicPoint3d &rhs) const {
+	return BasicPoint3d(*this) -= rhs;
     }
-    const Point3d operator*(double rhs) const {
-	return Point3d(*this) *= rhs;
+    const BasicPoint3d operator*(double rhs) const {
+	return BasicPoint3d(*this) *= rhs;
     }
-    const Point3d operator*(const Point3d &rhs) const {
-	return Point3d(*this) *= rhs;
+    const BasicPoint3d operator*(const BasicPoint3d &rhs) const {
+	return BasicPoint3d(*this) *= rhs;
     }
-    const Point3d operator/(double rhs) const {
-	return Point3d(*this) /= rhs;
+    const BasicPoint3d operator/(double rhs) const {
+	return BasicPoint3d(*this) /= rhs;
     }
-    const Point3d operator/(const Point3d &rhs) const {
-	return Point3d(*this) /= rhs;
+    const BasicPoint3d operator/(const BasicPoint3d &rhs) const {
+	return BasicPoint3d(*this) /= rhs;
     }
 
     // Comparison operators
-    bool operator==(const Point3d &rhs) const {
-        return (fabs(this->x-rhs.x) + fabs(this->y+rhs.y) + fabs(this->z+rhs.z) < CLOSEENOUGH);
+    bool operator==(const BasicPoint3d &rhs) const {
+        return (fabs(C::toDouble(this->x-rhs.x)) + fabs(C::toDouble(this->y+rhs.y)) + fabs(C::toDouble(this->z+rhs.z)) < C::closeEnough());
     }
-    bool operator!=(const Point3d &rhs) const {
+    bool operator!=(const BasicPoint3d &rhs) const {
         return !(*this == rhs);
     }
 
     // Comparators for z height double.
     bool operator== (double zcoord) const {
-        return (fabs(z-zcoord) < CLOSEENOUGH);
+        return (fabs(C::toDouble(z)-zcoord) < C::closeEnough());
     }
     bool operator< (double zcoord) const {
-        return (z < zcoord);
+        return (C::toDouble(z) < zcoord);
     }
     bool operator> (double zcoord) const {
-        return (z > zcoord);
+        return (C::toDouble(z) > zcoord);
     }
     bool operator<= (double zcoord) const {
         return !(*this > zcoord);
@@ -123,21 +120,21 @@ public:
 
 
     // Transformations
-    Point3d& scale(double scale) {
+    BasicPoint3d& scale(double scale) {
 	*this *= scale;
 	return *this;
     }
-    Point3d& scale(const Point3d& vect) {
+    BasicPoint3d& scale(const BasicPoint3d& vect) {
 	*this *= vect;
 	return *this;
     }
-    Point3d& scaleAroundPoint3d(const Point3d& center, double scale) {
+    BasicPoint3d& scaleAroundPoint3d(const BasicPoint3d& center, double scale) {
 	*this -= center;
 	*this *= scale;
 	*this += center;
 	return *this;
     }
-    Point3d& scaleAroundPoint3d(const Point3d& center, const Point3d& vect) {
+    BasicPoint3d& scaleAroundPoint3d(const BasicPoint3d& center, const BasicPoint3d& vect) {
 	*this -= center;
 	*this *= vect;
 	*this += center;
@@ -145,17 +142,23 @@ public:
     }
 
     // Calculations
-    double distanceFrom(const Point3d& pt) const {
-        Point3d vect(*this);
+    double distanceFrom(const BasicPoint3d& pt) const {
+        BasicPoint3d vect(*this);
 	vect -= pt;
-	vect *= vect;
-	return sqrt(vect.x+vect.y+vect.z);
+	double dx = C::toDouble(vect.x);
+	double dy = C::toDouble(vect.y);
+	double dz = C::toDouble(vect.z);
+	return sqrt(dx*dx+dy*dy+dz*dz);
     }
-
-    // Friend functions
-    friend ostream& operator <<(ostream &os,const Point3d &pt);
 };
 
+template <class C>
+ostream& operator <<(ostream &os,const BasicPoint3d<C> &pt);
+
+typedef BasicPoint3d<DoubleCoord> Point3d;
+typedef BasicPoint3d<FloatCoord> Point3dF;
+typedef BasicPoint3d<FixedCoord> Point3dX;
+
 
 }
 
@@ -0,0 +1,192 @@
+//
+//  BGLSerialize.cc
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/23/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#include <string.h>
+#include "BGLSerialize.h"
+
+namespace BGL {
+
+
+// Every line is written as its two points, its flags and its two
+//  doubles of attributes.
+static const size_t LINE_BYTES = 4 * sizeof(double) + sizeof(int16_t) + 2 * sizeof(double);
+
+
+
+void BinaryWriter::write(const Point &pt)
+{
+    writeDouble(pt.x);
+    writeDouble(pt.y);
+}
+
+
+
+void BinaryWriter::write(const Line &ln)
+{
+    write(ln.startPt);
+    write(ln.endPt);
+    writeBytes(&ln.flags, sizeof(ln.flags));
+    writeDouble(ln.temperature);
+    writeDouble(ln.extrusionWidth);
+}
+
+
+
+void BinaryWriter::write(const Path &path)
+{
+    writeU32(path.flags);
+    writeU32(path.segments.size());
+    Lines::const_iterator it;
+    for (it = path.segments.begin(); it != path.segments.end(); it++) {
+        write(*it);
+    }
+}
+
+
+
+void BinaryWriter::write(const Paths &paths)
+{
+    writeU32(paths.size());
+    Paths::const_iterator it;
+    for (it = paths.begin(); it != paths.end(); it++) {
+        write(*it);
+    }
+}
+
+
+
+void BinaryWriter::write(const SimpleRegion &reg)
+{
+    writeDouble(reg.zLevel);
+    write(reg.outerPath);
+    write(reg.subpaths);
+}
+
+
+
+void BinaryWriter::write(const CompoundRegion &reg)
+{
+    writeDouble(reg.zLevel);
+    writeU32(reg.subregions.size());
+    SimpleRegions::const_iterator it;
+    for (it = reg.subregions.begin(); it != reg.subregions.end(); it++) {
+        write(*it);
+    }
+}
+
+
+
+bool BinaryReader::readBytes(void *data, size_t len)
+{
+    if (!good || (size_t)(end - pos) < len) {
+        good = false;
+        return false;
+    }
+    memcpy(data, pos, len);
+    pos += len;
+    return true;
+}
+
+
+
+// Reads an item count, and checks that there's at least enough data
+//  left for that many items, so bad data can't make us allocate the
+//  world before we notice.
+bool BinaryReader::readCount(uint32_t &cnt, size_t minItemSize)
+{
+    if (!readU32(cnt)) {
+        return false;
+    }
+    if ((size_t)(end - pos) / minItemSize < cnt) {
+        good = false;
+    }
+    return good;
+}
+
+
+
+bool BinaryReader::read(Point &pt)
+{
+    readDouble(pt.x);
+    return readDouble(pt.y);
+}
+
+
+
+bool BinaryReader::read(Line &ln)
+{
+    read(ln.startPt);
+    read(ln.endPt);
+    readBytes(&ln.flags, sizeof(ln.flags));
+    readDouble(ln.temperature);
+    return readDouble(ln.extrusionWidth);
+}
+
+
+
+bool BinaryReader::read(Path &path)
+{
+    uint32_t flags, cnt;
+    readU32(flags);
+    if (!readCount(cnt, LINE_BYTES)) {
+        return false;
+    }
+    path.flags = flags;
+    path.segments.clear();
+    Line ln;
+    while (cnt-- > 0 && read(ln)) {
+        path.segments.push_back(ln);
+    }
+    return good;
+}
+
+
+
+bool BinaryReader::read(Paths &paths)
+{
+    uint32_t cnt;
+    if (!readCount(cnt, 2 * sizeof(uint32_t))) {
+        return false;
+    }
+    paths.clear();
+    while (cnt-- > 0 && good) {
+        paths.push_back(Path());
+        read(paths.back());
+    }
+    return good;
+}
+
+
+
+bool BinaryReader::read(SimpleRegion &reg)
+{
+    readDouble(reg.zLevel);
+    read(reg.outerPath);
+    return read(reg.subpaths);
+}
+
+
+
+bool BinaryReader::read(CompoundRegion &reg)
+{
+    uint32_t cnt;
+    readDouble(reg.zLevel);
+    if (!readCount(cnt, sizeof(double) + 3 * sizeof(uint32_t))) {
+        return false;
+    }
+    reg.subregions.clear();
+    while (cnt-- > 0 && good) {
+        reg.subregions.push_back(SimpleRegion());
+        read(reg.subregions.back());
+    }
+    return good;
+}
+
+
+}
+
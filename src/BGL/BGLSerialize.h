@@ -0,0 +1,85 @@
+//
+//  BGLSerialize.h
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/23/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#ifndef BGL_SERIALIZE_H
+#define BGL_SERIALIZE_H
+
+#include <string>
+#include "config.h"
+#include "BGLPoint.h"
+#include "BGLLine.h"
+#include "BGLPath.h"
+#include "BGLSimpleRegion.h"
+#include "BGLCompoundRegion.h"
+
+namespace BGL {
+
+
+// Writes geometry out as a flat run of bytes, with every coordinate
+//  and attribute kept exactly.  Values are in the machine's own byte
+//  order, so the bytes are only good for reading back on the same
+//  kind of machine, as with on-disk caches.
+class BinaryWriter {
+private:
+    std::string buf;
+
+    void writeBytes(const void *data, size_t len) {
+        buf.append((const char*)data, len);
+    }
+
+public:
+    BinaryWriter() : buf() {}
+
+    void writeU32(uint32_t val) { writeBytes(&val, sizeof(val)); }
+    void writeDouble(double val) { writeBytes(&val, sizeof(val)); }
+    void write(const Point &pt);
+    void write(const Line &ln);
+    void write(const Path &path);
+    void write(const Paths &paths);
+    void write(const SimpleRegion &reg);
+    void write(const CompoundRegion &reg);
+
+    const std::string& data() const { return buf; }
+};
+
+
+
+// Reads back what a BinaryWriter wrote, in the same order.  Running
+//  off the end of the data, or finding counts that can't be right,
+//  makes ok() false for good, and every later read a no-op.  Geometry
+//  is built in whichever Arena is current.
+class BinaryReader {
+private:
+    const char *pos;
+    const char *end;
+    bool good;
+
+    bool readBytes(void *data, size_t len);
+    bool readCount(uint32_t &cnt, size_t minItemSize);
+
+public:
+    BinaryReader(const char *data, size_t len) : pos(data), end(data + len), good(true) {}
+
+    bool ok() const { return good; }
+    bool atEnd() const { return pos == end; }
+
+    bool readU32(uint32_t &val) { return readBytes(&val, sizeof(val)); }
+    bool readDouble(double &val) { return readBytes(&val, sizeof(val)); }
+    bool read(Point &pt);
+    bool read(Line &ln);
+    bool read(Path &path);
+    bool read(Paths &paths);
+    bool read(SimpleRegion &reg);
+    bool read(CompoundRegion &reg);
+};
+
+
+}
+
+#endif
+
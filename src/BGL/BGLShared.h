@@ -0,0 +1,107 @@
+//
+//  BGLShared.h
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/16/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#ifndef BGL_SHARED_H
+#define BGL_SHARED_H
+
+#include <memory>
+#include <utility>
+#include "config.h"
+#include "BGLArena.h"
+
+namespace BGL {
+
+
+// A reference counted, copy-on-write handle to a geometry value.
+//  Copying a Shared only copies a pointer.  The value is read-only
+//  through the handle; mutate() gives write access, cloning the value
+//  first if any other handle can still see it, or if it doesn't hold
+//  the current arena that anything added to it would be built out of.
+//
+// The value is built out of whichever Arena is current when it is
+//  made, and holds a reference to that arena (if it was made by
+//  Arena::create()) so that it stays valid for as long as any handle to
+//  it is alive, even after the slice that built it has let go.  Values
+//  moved in should have been built in the current arena for the same
+//  reason.
+//
+// As with the STL containers, different threads may use different
+//  handles to the same value, but a single handle isn't thread-safe.
+template <class T>
+class Shared {
+private:
+    struct Payload {
+        // Declared first, so that it outlives the value.
+        std::shared_ptr<Arena> arena;
+        T value;
+
+        Payload() : arena(currentArena()), value() {}
+        Payload(const T& x) : arena(currentArena()), value(x) {}
+        Payload(T&& x) : arena(currentArena()), value(std::move(x)) {}
+    };
+
+    // NULL means an empty value, so default handles cost nothing.
+    std::shared_ptr<Payload> payload;
+
+    static std::shared_ptr<Arena> currentArena() {
+        Arena* arena = Arena::current();
+        return arena ? arena->handle() : std::shared_ptr<Arena>();
+    }
+
+    // Whether what's added to the value now, from the current arena,
+    //  is kept alive by it.  The heap always is, and so are arenas that
+    //  can't be held, as cloning couldn't do better.
+    bool holdsCurrentArena() const {
+        Arena* arena = Arena::current();
+        return !arena || arena == payload->arena.get() || !arena->handle();
+    }
+
+    static const T& emptyValue() {
+        static const T empty;
+        return empty;
+    }
+
+public:
+    Shared() : payload() {}
+    Shared(const T& x) : payload(std::make_shared<Payload>(x)) {}
+    Shared(T&& x) : payload(std::make_shared<Payload>(std::move(x))) {}
+
+    // Copies and moves of the handle itself are left to the compiler.
+
+    Shared& operator=(const T& rhs) {
+        payload = std::make_shared<Payload>(rhs);
+        return *this;
+    }
+    Shared& operator=(T&& rhs) {
+        payload = std::make_shared<Payload>(std::move(rhs));
+        return *this;
+    }
+
+    const T& operator*() const { return payload ? payload->value : emptyValue(); }
+    const T* operator->() const { return &**this; }
+    const T& get() const { return **this; }
+
+    T& mutate() {
+        if (!payload) {
+            payload = std::make_shared<Payload>();
+        } else if (payload.use_count() > 1 || !holdsCurrentArena()) {
+            payload = std::make_shared<Payload>(payload->value);
+        }
+        return payload->value;
+    }
+
+    void reset() { payload.reset(); }
+    bool isShared() const { return payload && payload.use_count() > 1; }
+    bool sharesWith(const Shared& x) const { return payload && payload == x.payload; }
+};
+
+
+}
+
+#endif
+
@@ -6,12 +6,15 @@
 //  Copyright 2010 Belfry Software. All rights reserved.
 //
 
+#include <limits.h>
 #include "BGLCommon.h"
 #include "BGLBounds.h"
 #include "BGLPoint.h"
 #include "BGLLine.h"
 #include "BGLPath.h"
 #include "BGLSimpleRegion.h"
+#include "BGLSimplifier.h"
+#include "BGLCancel.h"
 
 
 
@@ -85,6 +88,17 @@ SimpleRegion& SimpleRegion::operator/=(const Point &rhs) {
 
 
 
+SimpleRegion& SimpleRegion::transform(const Affine &aff) {
+    Paths::iterator it;
+    for (it = subpaths.begin(); it != subpaths.end(); it++) {
+	it->transform(aff);
+    }
+    outerPath.transform(aff);
+    return *this;
+}
+
+
+
 
 int32_t SimpleRegion::size()
 {
@@ -93,6 +107,19 @@ int32_t SimpleRegion::size()
 
 
 
+// Segments in the outer path and all the holes.
+int32_t SimpleRegion::segmentCount() const
+{
+    int32_t count = outerPath.size();
+    Paths::const_iterator it;
+    for (it = subpaths.begin(); it != subpaths.end(); it++) {
+        count += it->size();
+    }
+    return count;
+}
+
+
+
 bool SimpleRegion::contains(const Point &pt) const
 {
     int count = 0;
@@ -164,11 +191,11 @@ bool SimpleRegion::intersects(const SimpleRegion &reg) const
 
 
 
-string SimpleRegion::svgPathWithOffset(double dx, double dy)
+string SimpleRegion::svgPathWithOffset(double dx, double dy) const
 {
     string out;
     out.append(outerPath.svgPathWithOffset(dx, dy));
-    Paths::iterator pit = subpaths.begin();
+    Paths::const_iterator pit = subpaths.begin();
     for ( ; pit != subpaths.end(); pit++) {
 	out.append(" ");
         out.append(pit->svgPathWithOffset(dx, dy));
@@ -213,7 +240,23 @@ void SimpleRegion::simplify(double minErr)
 
 
 
-SimpleRegions &SimpleRegion::assembleSimpleRegionsFrom(Paths &paths, SimpleRegions &outRegs)
+// Like Path::decimate(), but also keeps the outer path and its holes
+//  from crossing each other.
+int SimpleRegion::decimate(double tolerance)
+{
+    Simplifier simplifier;
+    simplifier.addPath(outerPath);
+    Paths::iterator it;
+    for (it = subpaths.begin(); it != subpaths.end(); it++) {
+	simplifier.addPath(*it);
+    }
+    return simplifier.simplify(tolerance);
+}
+
+
+
+// Sets each path's flags to the number of other paths that contain it.
+static void tagPathsWithContainmentDepth(Paths &paths)
 {
     Paths::iterator it1;
     Paths::iterator it2;
@@ -221,9 +264,8 @@ SimpleRegions &SimpleRegion::assembleSimpleRegionsFrom(Paths &paths, SimpleRegio
     for (it1 = paths.begin(); it1 != paths.end(); it1++) {
 	it1->flags = 0;
     }
-    int count1, count2;
-    for (count1 = 0, it1 = paths.begin(); it1 != paths.end(); count1++, it1++) {
-	for (count2 = 0, it2 = paths.begin(); it2 != paths.end(); count2++, it2++) {
+    for (it1 = paths.begin(); it1 != paths.end(); it1++) {
+	for (it2 = paths.begin(); it2 != paths.end(); it2++) {
 	    if (it1 != it2) {
 	        if (it2->contains(it1->startPoint())) {
 		    it1->flags++;
@@ -231,6 +273,15 @@ SimpleRegions &SimpleRegion::assembleSimpleRegionsFrom(Paths &paths, SimpleRegio
 	    }
 	}
     }
+}
+
+
+
+SimpleRegions &SimpleRegion::assembleSimpleRegionsFrom(Paths &paths, SimpleRegions &outRegs)
+{
+    Paths::iterator it1;
+
+    tagPathsWithContainmentDepth(paths);
     for (it1 = paths.begin(); it1 != paths.end(); it1++) {
         if ((it1->flags & 0x1) == 0) {
 	    // Even contained count means outerpath.
@@ -256,6 +307,46 @@ SimpleRegions &SimpleRegion::assembleSimpleRegionsFrom(Paths &paths, SimpleRegio
 
 
 
+// Consumes paths, moving them into the new regions instead of copying them.
+SimpleRegions &SimpleRegion::assembleSimpleRegionsFrom(Paths &&paths, SimpleRegions &outRegs)
+{
+    Paths::iterator it1;
+
+    tagPathsWithContainmentDepth(paths);
+    for (it1 = paths.begin(); it1 != paths.end(); it1++) {
+        if ((it1->flags & 0x1) == 0) {
+	    // Even contained count means outerpath.
+	    outRegs.emplace_back(std::move(*it1));
+	}
+    }
+    SimpleRegions::iterator rit;
+    for (it1 = paths.begin(); it1 != paths.end(); it1++) {
+	if ((it1->flags & 0x1) == 1) {
+	    // Odd contained count means innerpath.
+	    // Only the last region to claim it gets the original.
+	    SimpleRegion* owner = NULL;
+	    for (rit = outRegs.begin(); rit != outRegs.end(); rit++) {
+		if ((rit->outerPath.flags | 0x1) == (it1->flags | 0x1)) {
+		    // Same level of containedness.
+		    if (rit->outerPath.contains(it1->startPoint())) {
+		        if (owner) {
+			    owner->subpaths.push_back(*it1);
+			}
+			owner = &*rit;
+		    }
+		}
+	    }
+	    if (owner) {
+	        owner->subpaths.push_back(std::move(*it1));
+	    }
+	}
+    }
+    paths.clear();
+    return outRegs;
+}
+
+
+
 SimpleRegions &SimpleRegion::assembleSimpleRegionsFrom(const Paths &outerPaths, const Paths &innerPaths, SimpleRegions &outRegs)
 {
     Paths tempPaths(outerPaths);
@@ -264,7 +355,7 @@ SimpleRegions &SimpleRegion::assembleSimpleRegionsFrom(const Paths &outerPaths,
     for (it1 = innerPaths.begin(); it1 != innerPaths.end(); it1++) {
 	tempPaths.push_back(*it1);
     }
-    return assembleSimpleRegionsFrom(tempPaths, outRegs);
+    return assembleSimpleRegionsFrom(std::move(tempPaths), outRegs);
 }
 
 
@@ -317,14 +408,14 @@ SimpleRegions &SimpleRegion::differenceOf(SimpleRegion &r1, SimpleRegion &r2, Si
 	for (it1 = newInnerPaths.begin(); it1 != newInnerPaths.end(); it1++) {
 	    Path::differenceOf(*it1, *it2, tempPaths);
 	}
-	newInnerPaths = tempPaths;
+	newInnerPaths = std::move(tempPaths);
     }
     for (it2 = r1.subpaths.begin(); it2 != r1.subpaths.end(); it2++) {
         Paths tempPaths;
 	for (it1 = outerPaths.begin(); it1 != outerPaths.end(); it1++) {
 	    Path::differenceOf(*it1, *it2, tempPaths);
 	}
-	outerPaths = tempPaths;
+	outerPaths = std::move(tempPaths);
     }
 
     Paths innerPaths;
@@ -364,7 +455,7 @@ SimpleRegions &SimpleRegion::intersectionOf(SimpleRegion &r1, SimpleRegion &r2,
 	for (it2 = outerPaths.begin(); it2 != outerPaths.end(); it2++) {
 	    Path::differenceOf(*it2, *it1, tempPaths);
 	}
-	outerPaths = tempPaths;
+	outerPaths = std::move(tempPaths);
     }
 
     for (it1 = r2.subpaths.begin(); it1 != r2.subpaths.end(); it1++) {
@@ -372,7 +463,7 @@ SimpleRegions &SimpleRegion::intersectionOf(SimpleRegion &r1, SimpleRegion &r2,
 	for (it2 = outerPaths.begin(); it2 != outerPaths.end(); it2++) {
 	    Path::differenceOf(*it2, *it1, tempPaths);
 	}
-	outerPaths = tempPaths;
+	outerPaths = std::move(tempPaths);
     }
 
     bool found;
@@ -385,10 +476,7 @@ SimpleRegions &SimpleRegion::intersectionOf(SimpleRegion &r1, SimpleRegion &r2,
 			Paths tempPaths;
 			Path::unionOf(*it1, *it2, tempPaths);
 			if (tempPaths.size() < 2) {
-			    Paths::iterator it3;
-			    for (it3 = tempPaths.begin(); it3 != tempPaths.end(); it3++) {
-				outerPaths.push_back(*it3);
-			    }
+			    outerPaths.splice(outerPaths.end(), tempPaths);
 			    it2 = outerPaths.erase(it2);
 			    it1 = outerPaths.erase(it1);
 			    found = true;
@@ -399,20 +487,20 @@ SimpleRegions &SimpleRegion::intersectionOf(SimpleRegion &r1, SimpleRegion &r2,
 	}
     } while (found);
 
-    assembleSimpleRegionsFrom(outerPaths, outRegs);
+    assembleSimpleRegionsFrom(std::move(outerPaths), outRegs);
     return outRegs;
 }
 
 
 
 
-Lines &SimpleRegion::containedSegmentsOfLine(Line &line, Lines &outSegs)
+Lines &SimpleRegion::containedSegmentsOfLine(const Line &line, Lines &outSegs) const
 {
     Path newpath;
     newpath.segments.push_back(line);
     newpath.splitSegmentsAtIntersectionsWithPath(outerPath);
 
-    Paths::iterator it;
+    Paths::const_iterator it;
     for (it = subpaths.begin(); it != subpaths.end(); it++) {
 	newpath.splitSegmentsAtIntersectionsWithPath(*it);
     }
@@ -429,12 +517,12 @@ Lines &SimpleRegion::containedSegmentsOfLine(Line &line, Lines &outSegs)
 
 
 
-Paths &SimpleRegion::containedSubpathsOfPath(const Path &path, Paths &outPaths)
+Paths &SimpleRegion::containedSubpathsOfPath(const Path &path, Paths &outPaths) const
 {
     Path newpath(path);
     newpath.splitSegmentsAtIntersectionsWithPath(outerPath);
 
-    Paths::iterator it;
+    Paths::const_iterator it;
     for (it = subpaths.begin(); it != subpaths.end(); it++) {
 	newpath.splitSegmentsAtIntersectionsWithPath(*it);
     }
@@ -442,15 +530,16 @@ Paths &SimpleRegion::containedSubpathsOfPath(const Path &path, Paths &outPaths)
     Lines::iterator lit;
     bool wasOut = true;
     Path tempPath;
-    for (lit = newpath.segments.begin(); lit != newpath.segments.end(); lit++) {
-        if (contains((lit->startPt + lit->endPt)/2.0)) {
+    for (lit = newpath.segments.begin(); lit != newpath.segments.end(); ) {
+        Lines::iterator seg = lit++;
+        if (contains((seg->startPt + seg->endPt)/2.0)) {
 	    // Now inside
-	    tempPath.segments.push_back(*lit);
+	    tempPath.segments.splice(tempPath.segments.end(), newpath.segments, seg);
 	    wasOut = false;
 	} else {
 	    // Now outside
 	    if (!wasOut) {
-	        outPaths.push_back(tempPath);
+	        outPaths.push_back(std::move(tempPath));
 		tempPath.segments.clear();
 		tempPath.flags = INSIDE;
 	    }
@@ -458,23 +547,16 @@ Paths &SimpleRegion::containedSubpathsOfPath(const Path &path, Paths &outPaths)
 	}
     }
     if (tempPath.size() > 1) {
-	outPaths.push_back(tempPath);
+	outPaths.push_back(std::move(tempPath));
     }
     return outPaths;
 }
 
 
 
-Paths &SimpleRegion::infillPathsForRegionWithDensity(double density, double extrusionWidth, Paths &outPaths)
+// Spacing between fill columns for the given density.
+static double infillSpacing(double density, double extrusionWidth)
 {
-    Bounds bounds = outerPath.bounds();
-    if (bounds.minX == Bounds::NONE) {
-        return outPaths;
-    }
-    if (density <= 0.001f) {
-        return outPaths;
-    }
-    
     // D = WSsqrt2/SS
     // D = Wsqrt2/S
     // DS = Wsqrt2
@@ -483,11 +565,67 @@ Paths &SimpleRegion::infillPathsForRegionWithDensity(double density, double extr
     if (density >= 0.99f) {
         spacing = extrusionWidth;
     }
+    return spacing;
+}
+
+
+
+Paths &SimpleRegion::infillPathsForRegionWithDensity(double density, double extrusionWidth, Paths &outPaths) const
+{
+    return infillPathsForColumns(density, extrusionWidth, 0, INT_MAX, outPaths);
+}
+
+
+
+// How many columns of fill infillPathsForRegionWithDensity() lays down,
+//  left to right, so they can be split up and filled separately.
+int SimpleRegion::infillColumnCount(double density, double extrusionWidth) const
+{
+    Bounds bounds = outerPath.bounds();
+    if (bounds.minX == Bounds::NONE) {
+        return 0;
+    }
+    if (density <= 0.001f) {
+        return 0;
+    }
+    double spacing = infillSpacing(density, extrusionWidth);
+    int count = 0;
+    for (double fillx = floor(bounds.minX/spacing-1)*spacing; fillx < bounds.maxX+spacing; fillx += spacing) {
+        count++;
+    }
+    return count;
+}
+
+
+
+// Lays down just columnCount of the fill columns, starting with the
+//  firstColumn from the left.  Filling every column in runs, one after
+//  the other, gives exactly the paths of filling them all at once.
+Paths &SimpleRegion::infillPathsForColumns(double density, double extrusionWidth, int firstColumn, int columnCount, Paths &outPaths) const
+{
+    Bounds bounds = outerPath.bounds();
+    if (bounds.minX == Bounds::NONE) {
+        return outPaths;
+    }
+    if (density <= 0.001f) {
+        return outPaths;
+    }
+    
+    double spacing = infillSpacing(density, extrusionWidth);
     double zag = spacing;
     
+    // Columns are stepped to one at a time, even when skipping them, so
+    //  each lands on just the same X as when they're all filled at once.
     bool alternate = (((int)floor(bounds.minX/spacing-1)) & 0x1) == 0;
-    for (double fillx = floor(bounds.minX/spacing-1)*spacing; fillx < bounds.maxX+spacing; fillx += spacing) {
+    int column = 0;
+    for (double fillx = floor(bounds.minX/spacing-1)*spacing; fillx < bounds.maxX+spacing; fillx += spacing, column++) {
         alternate = !alternate;
+        if (column < firstColumn) {
+            continue;
+        }
+        if (column - firstColumn >= columnCount || cancelRequested()) {
+            break;
+        }
 	Path path;
         double zig = 0.0f;
         if (density < 0.99f) {
@@ -497,7 +635,7 @@ Paths &SimpleRegion::infillPathsForRegionWithDensity(double density, double extr
             }
         }
         for (double filly = floor(0.5*bounds.minY/zag-1)*2.0f*zag; filly < bounds.maxY+zag; filly += zag) {
-            path.segments.push_back(Line(Point(fillx+zig,filly),Point(fillx-zig,filly+zag)));
+            path.segments.emplace_back(Point(fillx+zig,filly), Point(fillx-zig,filly+zag));
             zig = -zig;
         }
         Paths infillPaths;
@@ -506,6 +644,5 @@ Paths &SimpleRegion::infillPathsForRegionWithDensity(double density, double extr
     return outPaths;
 }
 
-
 }
 
@@ -17,7 +17,7 @@
 namespace BGL {
 
 class SimpleRegion;
-typedef list<SimpleRegion> SimpleRegions;
+typedef list<SimpleRegion, ArenaAllocator<SimpleRegion> > SimpleRegions;
 
 class SimpleRegion {
 public:
@@ -27,7 +27,27 @@ public:
 
     SimpleRegion() : outerPath(), subpaths(), zLevel(0.0f) {}
     SimpleRegion(const Path &x) : outerPath(x), subpaths(), zLevel(0.0f) {}
+    SimpleRegion(Path &&x) : outerPath(std::move(x)), subpaths(), zLevel(0.0f) {}
     SimpleRegion(const SimpleRegion &x) : outerPath(x.outerPath), subpaths(x.subpaths), zLevel(x.zLevel) {}
+    SimpleRegion(SimpleRegion &&x) : outerPath(std::move(x.outerPath)), subpaths(std::move(x.subpaths)), zLevel(x.zLevel) {}
+
+    // Assignment operators
+    SimpleRegion& operator=(const SimpleRegion &rhs) {
+	if (this != &rhs) {
+	    outerPath = rhs.outerPath;
+	    subpaths = rhs.subpaths;
+	    zLevel = rhs.zLevel;
+	}
+	return *this;
+    }
+    SimpleRegion& operator=(SimpleRegion &&rhs) {
+	if (this != &rhs) {
+	    outerPath = std::move(rhs.outerPath);
+	    subpaths = std::move(rhs.subpaths);
+	    zLevel = rhs.zLevel;
+	}
+	return *this;
+    }
 
     // Compound assignment operators
     SimpleRegion& operator+=(const Point &rhs);
@@ -36,6 +56,7 @@ public:
     SimpleRegion& operator*=(const Point &rhs);
     SimpleRegion& operator/=(double rhs);
     SimpleRegion& operator/=(const Point &rhs);
+    SimpleRegion& transform(const Affine &aff);
 
     // Binary arithmetic operators
     const SimpleRegion operator+(const Point &rhs) const {
@@ -58,28 +79,33 @@ public:
     }
 
     int32_t size();
+    int32_t segmentCount() const;
     bool contains(const Point &pt) const;
 
     bool intersects(const Path& path) const;
     bool intersects(const SimpleRegion& path) const;
 
-    string svgPathWithOffset(double dx, double dy);
+    string svgPathWithOffset(double dx, double dy) const;
     ostream &svgPathDataWithOffset(ostream& os, double dx, double dy) const;
     ostream &svgPathWithOffset(ostream& os, double dx, double dy) const;
 
     void simplify(double minErr);
+    int decimate(double tolerance);
 
     static SimpleRegions &assembleSimpleRegionsFrom(Paths &paths, SimpleRegions &outRegs);
+    static SimpleRegions &assembleSimpleRegionsFrom(Paths &&paths, SimpleRegions &outRegs);
     static SimpleRegions &assembleSimpleRegionsFrom(const Paths &outerPaths, const Paths &innerPaths, SimpleRegions &outRegs);
 
     static SimpleRegions& unionOf       (SimpleRegion &r1, SimpleRegion &r2, SimpleRegions &outReg);
     static SimpleRegions& differenceOf  (SimpleRegion &r1, SimpleRegion &r2, SimpleRegions &outReg);
     static SimpleRegions& intersectionOf(SimpleRegion &r1, SimpleRegion &r2, SimpleRegions &outReg);
 
-    Lines &containedSegmentsOfLine(Line &line, Lines &lnsref);
-    Paths &containedSubpathsOfPath(const Path &path, Paths &pathsref);
+    Lines &containedSegmentsOfLine(const Line &line, Lines &lnsref) const;
+    Paths &containedSubpathsOfPath(const Path &path, Paths &pathsref) const;
 
-    Paths &infillPathsForRegionWithDensity(double density, double extrusionWidth, Paths &outPaths);
+    Paths &infillPathsForRegionWithDensity(double density, double extrusionWidth, Paths &outPaths) const;
+    int infillColumnCount(double density, double extrusionWidth) const;
+    Paths &infillPathsForColumns(double density, double extrusionWidth, int firstColumn, int columnCount, Paths &outPaths) const;
 };
 
 
@@ -0,0 +1,299 @@
+//
+//  BGLSimplifier.cc
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/18/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#include <math.h>
+#include <queue>
+#include "BGLSimplifier.h"
+
+namespace BGL {
+
+
+// Triangle corners closer than this to a line are counted as on it.
+static const double SIMPLIFY_EPSILON = 1e-12;
+
+// Candidate vertex removal.  Ordered so the priority_queue pops the
+//  cheapest first.  Stale entries are recognized by their stamp.
+struct SimplifyCandidate {
+    double cost;
+    int vert;
+    int stamp;
+
+    SimplifyCandidate(double c, int v, int s) : cost(c), vert(v), stamp(s) {}
+    bool operator<(const SimplifyCandidate& rhs) const {
+        return cost > rhs.cost;
+    }
+};
+
+
+
+static double cross(const Point& a, const Point& b, const Point& p)
+{
+    return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+}
+
+
+
+// True if pt is inside or on the edge of the triangle abc.
+static bool triangleContains(const Point& a, const Point& b, const Point& c, const Point& pt)
+{
+    double d1 = cross(a, b, pt);
+    double d2 = cross(b, c, pt);
+    double d3 = cross(c, a, pt);
+    bool hasNeg = (d1 < -SIMPLIFY_EPSILON) || (d2 < -SIMPLIFY_EPSILON) || (d3 < -SIMPLIFY_EPSILON);
+    bool hasPos = (d1 > SIMPLIFY_EPSILON) || (d2 > SIMPLIFY_EPSILON) || (d3 > SIMPLIFY_EPSILON);
+    return !(hasNeg && hasPos);
+}
+
+
+
+void Simplifier::addPath(Path &path)
+{
+    if (path.segments.size() < 2) {
+        return;
+    }
+    Ring ring;
+    ring.path = &path;
+    ring.first = verts.size();
+    ring.closed = path.isClosed();
+
+    Lines::const_iterator it;
+    for (it = path.segments.begin(); it != path.segments.end(); it++) {
+        Vertex v;
+        v.pt = it->startPt;
+        v.ring = rings.size();
+        v.stamp = 0;
+        v.alive = true;
+        verts.push_back(v);
+    }
+    if (!ring.closed) {
+        Vertex v;
+        v.pt = path.segments.back().endPt;
+        v.ring = rings.size();
+        v.stamp = 0;
+        v.alive = true;
+        verts.push_back(v);
+    }
+    ring.count = verts.size() - ring.first;
+    ring.alive = ring.count;
+
+    int last = ring.first + ring.count - 1;
+    for (int i = ring.first; i <= last; i++) {
+        verts[i].prev = (i > ring.first) ? i - 1 : (ring.closed ? last : -1);
+        verts[i].next = (i < last) ? i + 1 : (ring.closed ? ring.first : -1);
+    }
+    rings.push_back(ring);
+}
+
+
+
+// Next vertex in the original order, whether or not it's still alive.
+int Simplifier::nextInRing(int v) const
+{
+    const Ring& ring = rings[verts[v].ring];
+    if (v == ring.first + ring.count - 1) {
+        return ring.first;
+    }
+    return v + 1;
+}
+
+
+
+// How far the path would stray from its original shape if this
+//  vertex were removed.  Measured against every original vertex that
+//  the new chord would replace, not just this one, so that error
+//  can't pile up across successive removals.
+double Simplifier::removalError(int v) const
+{
+    const Vertex& vert = verts[v];
+    Line chord(verts[vert.prev].pt, verts[vert.next].pt);
+    double maxErr = 0.0;
+    for (int i = nextInRing(vert.prev); i != vert.next; i = nextInRing(i)) {
+        double err = chord.minimumSegmentDistanceFromPoint(verts[i].pt);
+        if (err > maxErr) {
+            maxErr = err;
+        }
+    }
+    return maxErr;
+}
+
+
+
+// Replacing the two edges at v with a chord can only make paths cross
+//  if some other live vertex lies in the triangle they form.
+bool Simplifier::removalIsSafe(int v) const
+{
+    const Point& a = verts[verts[v].prev].pt;
+    const Point& b = verts[v].pt;
+    const Point& c = verts[verts[v].next].pt;
+
+    double minX = fmin(a.x, fmin(b.x, c.x));
+    double maxX = fmax(a.x, fmax(b.x, c.x));
+    double minY = fmin(a.y, fmin(b.y, c.y));
+    double maxY = fmax(a.y, fmax(b.y, c.y));
+    int cx0 = (int)((minX - gridMinX) / cellSize);
+    int cx1 = (int)((maxX - gridMinX) / cellSize);
+    int cy0 = (int)((minY - gridMinY) / cellSize);
+    int cy1 = (int)((maxY - gridMinY) / cellSize);
+
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            int cell = cy * cols + cx;
+            for (int i = cellStart[cell]; i < cellStart[cell+1]; i++) {
+                int w = cellVerts[i];
+                if (w == v || w == verts[v].prev || w == verts[v].next || !verts[w].alive) {
+                    continue;
+                }
+                const Point& pt = verts[w].pt;
+                if (pt.x < minX || pt.x > maxX || pt.y < minY || pt.y > maxY) {
+                    continue;
+                }
+                if (triangleContains(a, b, c, pt)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+
+
+void Simplifier::buildGrid()
+{
+    double minX = verts[0].pt.x, maxX = minX;
+    double minY = verts[0].pt.y, maxY = minY;
+    std::vector<Vertex>::const_iterator it;
+    for (it = verts.begin(); it != verts.end(); it++) {
+        minX = fmin(minX, it->pt.x);
+        maxX = fmax(maxX, it->pt.x);
+        minY = fmin(minY, it->pt.y);
+        maxY = fmax(maxY, it->pt.y);
+    }
+
+    // About one vertex per cell.
+    double width = maxX - minX;
+    double height = maxY - minY;
+    cellSize = sqrt(fmax(width * height, width * width + height * height) / verts.size());
+    if (cellSize < CLOSEENOUGH) {
+        cellSize = CLOSEENOUGH;
+    }
+    gridMinX = minX;
+    gridMinY = minY;
+    cols = (int)(width / cellSize) + 1;
+    rows = (int)(height / cellSize) + 1;
+
+    // Counting sort of vertices into cells.
+    cellStart.assign(cols * rows + 1, 0);
+    std::vector<int> cellOf(verts.size());
+    for (size_t i = 0; i < verts.size(); i++) {
+        int cx = (int)((verts[i].pt.x - gridMinX) / cellSize);
+        int cy = (int)((verts[i].pt.y - gridMinY) / cellSize);
+        cellOf[i] = cy * cols + cx;
+        cellStart[cellOf[i] + 1]++;
+    }
+    for (int c = 0; c < cols * rows; c++) {
+        cellStart[c+1] += cellStart[c];
+    }
+    std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    cellVerts.resize(verts.size());
+    for (size_t i = 0; i < verts.size(); i++) {
+        cellVerts[fill[cellOf[i]]++] = i;
+    }
+}
+
+
+
+// Drops the segments that start at removed vertices, and stretches
+//  each surviving segment to end at the next surviving vertex.  The
+//  surviving segments keep their flags and other attributes.
+void Simplifier::writeBack(Ring& ring)
+{
+    Lines& segs = ring.path->segments;
+    Lines::iterator it = segs.begin();
+    for (int i = ring.first; it != segs.end(); i++) {
+        if (!verts[i].alive) {
+            it = segs.erase(it);
+        } else {
+            it->endPt = verts[verts[i].next].pt;
+            it++;
+        }
+    }
+}
+
+
+
+// Returns the number of vertices removed.
+int Simplifier::simplify(double tolerance)
+{
+    if (verts.empty() || tolerance <= 0.0) {
+        return 0;
+    }
+    buildGrid();
+
+    std::priority_queue<SimplifyCandidate> queue;
+    for (size_t v = 0; v < verts.size(); v++) {
+        const Ring& ring = rings[verts[v].ring];
+        if (verts[v].prev < 0 || verts[v].next < 0 || ring.count < 4) {
+            continue;
+        }
+        double cost = removalError(v);
+        if (cost <= tolerance) {
+            queue.push(SimplifyCandidate(cost, v, 0));
+        }
+    }
+
+    int removed = 0;
+    while (!queue.empty()) {
+        SimplifyCandidate cand = queue.top();
+        queue.pop();
+        Vertex& vert = verts[cand.vert];
+        Ring& ring = rings[vert.ring];
+        if (!vert.alive || cand.stamp != vert.stamp) {
+            continue;
+        }
+        if (ring.closed && ring.alive <= 3) {
+            continue;
+        }
+        if (!removalIsSafe(cand.vert)) {
+            continue;
+        }
+
+        vert.alive = false;
+        ring.alive--;
+        removed++;
+        int nbrs[2] = { vert.prev, vert.next };
+        verts[vert.prev].next = vert.next;
+        verts[vert.next].prev = vert.prev;
+
+        for (int i = 0; i < 2; i++) {
+            Vertex& nbr = verts[nbrs[i]];
+            nbr.stamp++;
+            if (nbr.prev < 0 || nbr.next < 0) {
+                continue;
+            }
+            double cost = removalError(nbrs[i]);
+            if (cost <= tolerance) {
+                queue.push(SimplifyCandidate(cost, nbrs[i], nbr.stamp));
+            }
+        }
+    }
+
+    if (removed > 0) {
+        std::vector<Ring>::iterator rit;
+        for (rit = rings.begin(); rit != rings.end(); rit++) {
+            if (rit->alive < rit->count) {
+                writeBack(*rit);
+            }
+        }
+    }
+    return removed;
+}
+
+
+}
+
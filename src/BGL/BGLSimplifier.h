@@ -0,0 +1,71 @@
+//
+//  BGLSimplifier.h
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/18/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#ifndef BGL_SIMPLIFIER_H
+#define BGL_SIMPLIFIER_H
+
+#include <vector>
+#include "config.h"
+#include "BGLPoint.h"
+#include "BGLPath.h"
+
+namespace BGL {
+
+
+// Removes vertices from a set of paths, so long as no path moves more
+//  than the given tolerance from where it was.  The cheapest vertex is
+//  always removed first.  A vertex is kept if removing it would let any
+//  of the paths cross one another or themselves, so paths that were
+//  simple and disjoint to begin with stay that way.
+//
+// Paths are edited in place when simplify() is called, and must not
+//  move or change in between being added and then.
+class Simplifier {
+private:
+    struct Vertex {
+        Point pt;
+        int prev, next;
+        int ring;
+        int stamp;
+        bool alive;
+    };
+    struct Ring {
+        Path* path;
+        int first;
+        int count;
+        int alive;
+        bool closed;
+    };
+
+    std::vector<Vertex> verts;
+    std::vector<Ring> rings;
+
+    // Vertices bucketed into a uniform grid, for topology checks.
+    double gridMinX, gridMinY, cellSize;
+    int cols, rows;
+    std::vector<int> cellStart;
+    std::vector<int> cellVerts;
+
+    int nextInRing(int v) const;
+    double removalError(int v) const;
+    bool removalIsSafe(int v) const;
+    void buildGrid();
+    void writeBack(Ring& ring);
+
+public:
+    Simplifier() : gridMinX(0.0), gridMinY(0.0), cellSize(1.0), cols(0), rows(0) {}
+
+    void addPath(Path &path);
+    int simplify(double tolerance);
+};
+
+
+}
+
+#endif
+
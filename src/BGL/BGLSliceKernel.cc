@@ -0,0 +1,170 @@
+//
+//  BGLSliceKernel.cc
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/28/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#include <stdint.h>
+#include "BGLSliceKernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define BGL_X86_KERNELS
+# include <immintrin.h>
+#endif
+
+namespace BGL {
+
+
+size_t trianglesReachingZScalar(const Triangle3d *tris, size_t count, double Z, uint32_t *hits)
+{
+    size_t found = 0;
+    for (size_t i = 0; i < count; i++) {
+        const Triangle3d &tri = tris[i];
+        bool above = tri.vertex1.z > Z && tri.vertex2.z > Z && tri.vertex3.z > Z;
+        bool below = tri.vertex1.z < Z && tri.vertex2.z < Z && tri.vertex3.z < Z;
+        hits[found] = i;
+        found += !(above || below);
+    }
+    return found;
+}
+
+
+
+#ifdef BGL_X86_KERNELS
+
+// The vector versions each take a lane per triangle, gathering the Z
+//  of each vertex across the lanes.  Comparisons are ordered, and so
+//  false for NaNs, as in the scalar version.  A mask with a bit set for
+//  each triangle that's wholly above or below is then turned into
+//  indices for the rest.  Whatever's left over at the end is done by
+//  the scalar version.
+
+__attribute__((target("sse2")))
+static size_t trianglesReachingZSSE2(const Triangle3d *tris, size_t count, double Z, uint32_t *hits)
+{
+    size_t found = 0;
+    size_t i = 0;
+    __m128d zv = _mm_set1_pd(Z);
+    for ( ; i + 2 <= count; i += 2) {
+        const Triangle3d *t = tris + i;
+        __m128d z1 = _mm_set_pd(t[1].vertex1.z, t[0].vertex1.z);
+        __m128d z2 = _mm_set_pd(t[1].vertex2.z, t[0].vertex2.z);
+        __m128d z3 = _mm_set_pd(t[1].vertex3.z, t[0].vertex3.z);
+        __m128d above = _mm_and_pd(_mm_and_pd(_mm_cmpgt_pd(z1, zv), _mm_cmpgt_pd(z2, zv)), _mm_cmpgt_pd(z3, zv));
+        __m128d below = _mm_and_pd(_mm_and_pd(_mm_cmplt_pd(z1, zv), _mm_cmplt_pd(z2, zv)), _mm_cmplt_pd(z3, zv));
+        unsigned reaching = ~_mm_movemask_pd(_mm_or_pd(above, below)) & 0x3;
+        while (reaching) {
+            hits[found++] = i + __builtin_ctz(reaching);
+            reaching &= reaching - 1;
+        }
+    }
+    uint32_t *rest = hits + found;
+    size_t more = trianglesReachingZScalar(tris + i, count - i, Z, rest);
+    for (size_t k = 0; k < more; k++) {
+        rest[k] += i;
+    }
+    return found + more;
+}
+
+
+
+__attribute__((target("avx2")))
+static size_t trianglesReachingZAVX2(const Triangle3d *tris, size_t count, double Z, uint32_t *hits)
+{
+    const long long stride = sizeof(Triangle3d);
+    size_t found = 0;
+    size_t i = 0;
+    __m256d zv = _mm256_set1_pd(Z);
+    __m256i offsets = _mm256_set_epi64x(3 * stride, 2 * stride, stride, 0);
+    for ( ; i + 4 <= count; i += 4) {
+        const Triangle3d *t = tris + i;
+        __m256d z1 = _mm256_i64gather_pd(&t->vertex1.z, offsets, 1);
+        __m256d z2 = _mm256_i64gather_pd(&t->vertex2.z, offsets, 1);
+        __m256d z3 = _mm256_i64gather_pd(&t->vertex3.z, offsets, 1);
+        __m256d above = _mm256_and_pd(_mm256_and_pd(_mm256_cmp_pd(z1, zv, _CMP_GT_OQ), _mm256_cmp_pd(z2, zv, _CMP_GT_OQ)),
+                                      _mm256_cmp_pd(z3, zv, _CMP_GT_OQ));
+        __m256d below = _mm256_and_pd(_mm256_and_pd(_mm256_cmp_pd(z1, zv, _CMP_LT_OQ), _mm256_cmp_pd(z2, zv, _CMP_LT_OQ)),
+                                      _mm256_cmp_pd(z3, zv, _CMP_LT_OQ));
+        unsigned reaching = ~_mm256_movemask_pd(_mm256_or_pd(above, below)) & 0xf;
+        while (reaching) {
+            hits[found++] = i + __builtin_ctz(reaching);
+            reaching &= reaching - 1;
+        }
+    }
+    uint32_t *rest = hits + found;
+    size_t more = trianglesReachingZScalar(tris + i, count - i, Z, rest);
+    for (size_t k = 0; k < more; k++) {
+        rest[k] += i;
+    }
+    return found + more;
+}
+
+
+
+__attribute__((target("avx512f")))
+static size_t trianglesReachingZAVX512(const Triangle3d *tris, size_t count, double Z, uint32_t *hits)
+{
+    const long long stride = sizeof(Triangle3d);
+    size_t found = 0;
+    size_t i = 0;
+    __m512d zv = _mm512_set1_pd(Z);
+    __m512i offsets = _mm512_set_epi64(7 * stride, 6 * stride, 5 * stride, 4 * stride,
+                                       3 * stride, 2 * stride, stride, 0);
+    __m512d none = _mm512_setzero_pd();
+    for ( ; i + 8 <= count; i += 8) {
+        const Triangle3d *t = tris + i;
+        __m512d z1 = _mm512_mask_i64gather_pd(none, 0xff, offsets, &t->vertex1.z, 1);
+        __m512d z2 = _mm512_mask_i64gather_pd(none, 0xff, offsets, &t->vertex2.z, 1);
+        __m512d z3 = _mm512_mask_i64gather_pd(none, 0xff, offsets, &t->vertex3.z, 1);
+        __mmask8 above = _mm512_cmp_pd_mask(z1, zv, _CMP_GT_OQ) & _mm512_cmp_pd_mask(z2, zv, _CMP_GT_OQ) &
+                         _mm512_cmp_pd_mask(z3, zv, _CMP_GT_OQ);
+        __mmask8 below = _mm512_cmp_pd_mask(z1, zv, _CMP_LT_OQ) & _mm512_cmp_pd_mask(z2, zv, _CMP_LT_OQ) &
+                         _mm512_cmp_pd_mask(z3, zv, _CMP_LT_OQ);
+        unsigned reaching = ~(unsigned)(above | below) & 0xff;
+        while (reaching) {
+            hits[found++] = i + __builtin_ctz(reaching);
+            reaching &= reaching - 1;
+        }
+    }
+    uint32_t *rest = hits + found;
+    size_t more = trianglesReachingZScalar(tris + i, count - i, Z, rest);
+    for (size_t k = 0; k < more; k++) {
+        rest[k] += i;
+    }
+    return found + more;
+}
+
+#endif
+
+
+
+static const Kernel<ReachingZKernel> reachingZKernels[] = {
+#ifdef BGL_X86_KERNELS
+    { CPU_AVX512, "avx512", trianglesReachingZAVX512 },
+    { CPU_AVX2,   "avx2",   trianglesReachingZAVX2 },
+    { CPU_SSE2,   "sse2",   trianglesReachingZSSE2 },
+#endif
+    { 0,          "scalar", trianglesReachingZScalar },
+};
+
+static const KernelFamily<ReachingZKernel> reachingZ(reachingZKernels, sizeof(reachingZKernels) / sizeof(reachingZKernels[0]));
+
+
+
+size_t trianglesReachingZ(const Triangle3d *tris, size_t count, double Z, uint32_t *hits)
+{
+    return reachingZ.best().fn(tris, count, Z, hits);
+}
+
+
+
+const KernelFamily<ReachingZKernel>& reachingZKernelFamily()
+{
+    return reachingZ;
+}
+
+
+}
+
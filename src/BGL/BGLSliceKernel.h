@@ -0,0 +1,45 @@
+//
+//  BGLSliceKernel.h
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/28/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#ifndef BGL_SLICEKERNEL_H
+#define BGL_SLICEKERNEL_H
+
+#include <stddef.h>
+#include "config.h"
+#include "BGLTriangle3d.h"
+#include "BGLCpu.h"
+
+namespace BGL {
+
+
+// Triangles looked at in one go by Mesh3d::regionForSliceAtZ().
+const size_t SLICE_KERNEL_BLOCK = 1024;
+
+
+
+// Finds which of count triangles might cross the plane at Z, that is,
+//  those that aren't wholly above or wholly below it, just as
+//  Triangle3d::sliceAtZ() first checks.  Their indices are written to
+//  hits, in order, and their number returned.  Several triangles are
+//  checked at a time with the best vector instructions cpuFeatures()
+//  allows.
+size_t trianglesReachingZ(const Triangle3d *tris, size_t count, double Z, uint32_t *hits);
+
+// The same, one triangle at a time, to check the others against.
+size_t trianglesReachingZScalar(const Triangle3d *tris, size_t count, double Z, uint32_t *hits);
+
+// Every version of trianglesReachingZ(), for choosing one by name, or
+//  trying each in turn.
+typedef size_t (*ReachingZKernel)(const Triangle3d *tris, size_t count, double Z, uint32_t *hits);
+const KernelFamily<ReachingZKernel>& reachingZKernelFamily();
+
+
+}
+
+#endif
+
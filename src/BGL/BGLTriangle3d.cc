@@ -13,14 +13,15 @@
 namespace BGL {
 
 
-Triangle3d& Triangle3d::rotateX(const Point3d& center, double rad)
+template <class C>
+BasicTriangle3d<C>& BasicTriangle3d<C>::rotateX(const BasicPoint3d<C>& center, double rad)
 {
     double cr = cos(rad);
     double sr = sin(rad);
 
     *this -= center;
 
-    Point3d pt;
+    BasicPoint3d<C> pt;
     pt.y = vertex1.y*cr - vertex1.z*sr;
     pt.z = vertex1.y*sr + vertex1.z*cr;
     pt.x = vertex1.x;
@@ -42,14 +43,15 @@ Triangle3d& Triangle3d::rotateX(const Point3d& center, double rad)
 
 
 
-Triangle3d& Triangle3d::rotateY(const Point3d& center, double rad)
+template <class C>
+BasicTriangle3d<C>& BasicTriangle3d<C>::rotateY(const BasicPoint3d<C>& center, double rad)
 {
     double cr = cos(rad);
     double sr = sin(rad);
 
     *this -= center;
 
-    Point3d pt;
+    BasicPoint3d<C> pt;
     pt.z = vertex1.z*cr - vertex1.x*sr;
     pt.x = vertex1.z*sr + vertex1.x*cr;
     pt.y = vertex1.y;
@@ -71,14 +73,15 @@ Triangle3d& Triangle3d::rotateY(const Point3d& center, double rad)
 
 
 
-Triangle3d& Triangle3d::rotateZ(const Point3d& center, double rad)
+template <class C>
+BasicTriangle3d<C>& BasicTriangle3d<C>::rotateZ(const BasicPoint3d<C>& center, double rad)
 {
     double cr = cos(rad);
     double sr = sin(rad);
 
     *this -= center;
 
-    Point3d pt;
+    BasicPoint3d<C> pt;
     pt.x = vertex1.x*cr - vertex1.y*sr;
     pt.y = vertex1.x*sr + vertex1.y*cr;
     pt.z = vertex1.z;
@@ -100,7 +103,8 @@ Triangle3d& Triangle3d::rotateZ(const Point3d& center, double rad)
 
 
 
-bool Triangle3d::sliceAtZ(double Z, Line& lnref) const
+template <class C>
+bool BasicTriangle3d<C>::sliceAtZ(double Z, BasicLine<C>& lnref) const
 {
     double u, px, py, v, qx, qy;
     if (vertex1 > Z && vertex2 > Z && vertex3 > Z) {
@@ -117,11 +121,11 @@ bool Triangle3d::sliceAtZ(double Z, Line& lnref) const
                 // flat face.  Ignore.
                 return false;
             }
-	    lnref = Line(Point(vertex1), Point(vertex2));
+	    lnref = BasicLine<C>(BasicPoint<C>(vertex1), BasicPoint<C>(vertex2));
 	    return true;
         }
 	if (vertex3 == Z) {
-	    lnref = Line(Point(vertex1), Point(vertex3));
+	    lnref = BasicLine<C>(BasicPoint<C>(vertex1), BasicPoint<C>(vertex3));
 	    return true;
         }
 	if ((vertex2 > Z && vertex3 > Z) || (vertex2 < Z && vertex3 < Z)) {
@@ -131,11 +135,11 @@ bool Triangle3d::sliceAtZ(double Z, Line& lnref) const
         u = (Z-vertex2.z)/(vertex3.z-vertex2.z);
         px =  vertex2.x+u*(vertex3.x-vertex2.x);
         py =  vertex2.y+u*(vertex3.y-vertex2.y);
-	lnref = Line(Point(vertex1), Point(px,py));
+	lnref = BasicLine<C>(BasicPoint<C>(vertex1), BasicPoint<C>(px,py));
 	return true;
     } else if (vertex2 == Z) {
 	if (vertex3 == Z) {
-	    lnref = Line(Point(vertex2), Point(vertex3));
+	    lnref = BasicLine<C>(BasicPoint<C>(vertex2), BasicPoint<C>(vertex3));
 	    return true;
         }
 	if ((vertex1 > Z && vertex3 > Z) || (vertex1 < Z && vertex3 < Z)) {
@@ -145,7 +149,7 @@ bool Triangle3d::sliceAtZ(double Z, Line& lnref) const
         u = (Z-vertex1.z)/(vertex3.z-vertex1.z);
         px =  vertex1.x+u*(vertex3.x-vertex1.x);
         py =  vertex1.y+u*(vertex3.y-vertex1.y);
-	lnref = Line(Point(vertex2), Point(px,py));
+	lnref = BasicLine<C>(BasicPoint<C>(vertex2), BasicPoint<C>(px,py));
 	return true;
     } else if (vertex3 == Z) {
 	if ((vertex1 > Z && vertex2 > Z) || (vertex1 < Z && vertex2 < Z)) {
@@ -155,7 +159,7 @@ bool Triangle3d::sliceAtZ(double Z, Line& lnref) const
         u = (Z-vertex1.z)/(vertex2.z-vertex1.z);
         px =  vertex1.x+u*(vertex2.x-vertex1.x);
         py =  vertex1.y+u*(vertex2.y-vertex1.y);
-	lnref = Line(Point(vertex3), Point(px,py));
+	lnref = BasicLine<C>(BasicPoint<C>(vertex3), BasicPoint<C>(px,py));
 	return true;
     } else if ((vertex1 > Z && vertex2 > Z) || (vertex1 < Z && vertex2 < Z)) {
         u = (Z-vertex3.z)/(vertex1.z-vertex3.z);
@@ -164,7 +168,7 @@ bool Triangle3d::sliceAtZ(double Z, Line& lnref) const
         v = (Z-vertex3.z)/(vertex2.z-vertex3.z);
         qx =  vertex3.x+v*(vertex2.x-vertex3.x);
         qy =  vertex3.y+v*(vertex2.y-vertex3.y);
-	lnref = Line(Point(px,py), Point(qx,qy));
+	lnref = BasicLine<C>(BasicPoint<C>(px,py), BasicPoint<C>(qx,qy));
 	return true;
     } else if ((vertex1 > Z && vertex3 > Z) || (vertex1 < Z && vertex3 < Z)) {
         u = (Z-vertex2.z)/(vertex1.z-vertex2.z);
@@ -173,7 +177,7 @@ bool Triangle3d::sliceAtZ(double Z, Line& lnref) const
         v = (Z-vertex2.z)/(vertex3.z-vertex2.z);
         qx =  vertex2.x+v*(vertex3.x-vertex2.x);
         qy =  vertex2.y+v*(vertex3.y-vertex2.y);
-	lnref = Line(Point(px,py), Point(qx,qy));
+	lnref = BasicLine<C>(BasicPoint<C>(px,py), BasicPoint<C>(qx,qy));
 	return true;
     } else if ((vertex2 > Z && vertex3 > Z) || (vertex2 < Z && vertex3 < Z)) {
         u = (Z-vertex1.z)/(vertex2.z-vertex1.z);
@@ -182,12 +186,16 @@ bool Triangle3d::sliceAtZ(double Z, Line& lnref) const
         v = (Z-vertex1.z)/(vertex3.z-vertex1.z);
         qx =  vertex1.x+v*(vertex3.x-vertex1.x);
         qy =  vertex1.y+v*(vertex3.y-vertex1.y);
-	lnref = Line(Point(px,py), Point(qx,qy));
+	lnref = BasicLine<C>(BasicPoint<C>(px,py), BasicPoint<C>(qx,qy));
 	return true;
     }
     return false;
 }
 
 
-}
 
+template class BasicTriangle3d<DoubleCoord>;
+template class BasicTriangle3d<FloatCoord>;
+
+
+}
@@ -10,62 +10,56 @@
 #define BGL_TRIANGLE3D_H
 
 #include <list>
+#include <vector>
 #include "config.h"
 #include "BGLPoint3d.h"
 #include "BGLLine.h"
 
 namespace BGL {
 
-class Triangle3d {
+template <class C>
+class BasicTriangle3d {
 public:
-    Point3d vertex1, vertex2, vertex3;
+    BasicPoint3d<C> vertex1, vertex2, vertex3;
 
     // Constructors
-    Triangle3d() : vertex1(), vertex2(), vertex3() {}
-    Triangle3d(const Point3d &p1, const Point3d &p2, const Point3d &p3) : vertex1(p1), vertex2(p2), vertex3(p3) {}
-
-    // Assignment operator
-    Triangle3d& operator=(const Triangle3d &rhs) {
-	if (this != &rhs) {
-	    vertex1 = rhs.vertex1;
-	    vertex2 = rhs.vertex2;
-	    vertex3 = rhs.vertex3;
-	}
-	return *this;
-    }
+    BasicTriangle3d() : vertex1(), vertex2(), vertex3() {}
+    BasicTriangle3d(const BasicPoint3d<C> &p1, const BasicPoint3d<C> &p2, const BasicPoint3d<C> &p3) : vertex1(p1), vertex2(p2), vertex3(p3) {}
+
+    // Copies and moves are left to the compiler, so Triangle3ds stay trivially copyable.
 
     // Compound assignment operators
-    Triangle3d& operator+=(const Point3d &rhs) {
+    BasicTriangle3d& operator+=(const BasicPoint3d<C> &rhs) {
 	vertex1 += rhs;
 	vertex2 += rhs;
 	vertex3 += rhs;
 	return *this;
     }
-    Triangle3d& operator-=(const Point3d &rhs) {
+    BasicTriangle3d& operator-=(const BasicPoint3d<C> &rhs) {
 	vertex1 -= rhs;
 	vertex2 -= rhs;
 	vertex3 -= rhs;
 	return *this;
     }
-    Triangle3d& operator*=(double rhs) {
+    BasicTriangle3d& operator*=(double rhs) {
 	vertex1 *= rhs;
 	vertex2 *= rhs;
 	vertex3 *= rhs;
 	return *this;
     }
-    Triangle3d& operator*=(const Point3d &rhs) {
+    BasicTriangle3d& operator*=(const BasicPoint3d<C> &rhs) {
 	vertex1 *= rhs;
 	vertex2 *= rhs;
 	vertex3 *= rhs;
 	return *this;
     }
-    Triangle3d& operator/=(double rhs) {
+    BasicTriangle3d& operator/=(double rhs) {
 	vertex1 /= rhs;
 	vertex2 /= rhs;
 	vertex3 /= rhs;
 	return *this;
     }
-    Triangle3d& operator/=(const Point3d &rhs) {
+    BasicTriangle3d& operator/=(const BasicPoint3d<C> &rhs) {
 	vertex1 /= rhs;
 	vertex2 /= rhs;
 	vertex3 /= rhs;
@@ -73,33 +67,33 @@ public:
     }
 
     // Binary arithmetic operators
-    const Triangle3d operator+(const Point3d &rhs) const {
-	return Triangle3d(*this) += rhs;
+    const BasicTriangle3d operator+(const BasicPoint3d<C> &rhs) const {
+	return BasicTriangle3d(*this) += rhs;
     }
-    const Triangle3d operator-(const Point3d &rhs) const {
-	return Triangle3d(*this) -= rhs;
+    const BasicTriangle3d operator-(const BasicPoint3d<C> &rhs) const {
+	return BasicTriangle3d(*this) -= rhs;
     }
-    const Triangle3d operator*(double rhs) const {
-	return Triangle3d(*this) *= rhs;
+    const BasicTriangle3d operator*(double rhs) const {
+	return BasicTriangle3d(*this) *= rhs;
     }
-    const Triangle3d operator*(const Point3d &rhs) const {
-	return Triangle3d(*this) *= rhs;
+    const BasicTriangle3d operator*(const BasicPoint3d<C> &rhs) const {
+	return BasicTriangle3d(*this) *= rhs;
     }
-    const Triangle3d operator/(double rhs) const {
-	return Triangle3d(*this) /= rhs;
+    const BasicTriangle3d operator/(double rhs) const {
+	return BasicTriangle3d(*this) /= rhs;
     }
-    const Triangle3d operator/(const Point3d &rhs) const {
-	return Triangle3d(*this) /= rhs;
+    const BasicTriangle3d operator/(const BasicPoint3d<C> &rhs) const {
+	return BasicTriangle3d(*this) /= rhs;
     }
 
     // Comparison operators
-    bool hasVertex(const Point& pt) const {
+    bool hasVertex(const BasicPoint<C>& pt) const {
         return (pt == vertex1 || pt == vertex2 || pt == vertex3);
     }
-    bool operator==(const Triangle3d &rhs) const {
+    bool operator==(const BasicTriangle3d &rhs) const {
 	return (hasVertex(rhs.vertex1) && hasVertex(rhs.vertex2) && hasVertex(rhs.vertex3));
     }
-    bool operator!=(const Triangle3d &rhs) const {
+    bool operator!=(const BasicTriangle3d &rhs) const {
         return !(*this == rhs);
     }
 
@@ -118,41 +112,45 @@ public:
     }
 
     // Transformations
-    Triangle3d& translate(double dx, double dy, double dz) {
-	*this += Point3d(dx,dy,dz);
+    BasicTriangle3d& translate(double dx, double dy, double dz) {
+	*this += BasicPoint3d<C>(dx,dy,dz);
 	return *this;
     }
-    Triangle3d& scale(double scale) {
+    BasicTriangle3d& scale(double scale) {
 	*this *= scale;
 	return *this;
     }
-    Triangle3d& scale(const Point3d& vect) {
+    BasicTriangle3d& scale(const BasicPoint3d<C>& vect) {
 	*this *= vect;
 	return *this;
     }
-    Triangle3d& scaleAroundPoint(const Point3d& center, double scale) {
+    BasicTriangle3d& scaleAroundPoint(const BasicPoint3d<C>& center, double scale) {
 	*this -= center;
 	*this *= scale;
 	*this += center;
 	return *this;
     }
-    Triangle3d& scaleAroundPoint(const Point3d& center, const Point3d& vect) {
+    BasicTriangle3d& scaleAroundPoint(const BasicPoint3d<C>& center, const BasicPoint3d<C>& vect) {
 	*this -= center;
 	*this *= vect;
 	*this += center;
 	return *this;
     }
-    Triangle3d& rotateX(const Point3d& center, double rad);
-    Triangle3d& rotateY(const Point3d& center, double rad);
-    Triangle3d& rotateZ(const Point3d& center, double rad);
+    BasicTriangle3d& rotateX(const BasicPoint3d<C>& center, double rad);
+    BasicTriangle3d& rotateY(const BasicPoint3d<C>& center, double rad);
+    BasicTriangle3d& rotateZ(const BasicPoint3d<C>& center, double rad);
 
 
     // Misc
-    bool sliceAtZ(double Z, Line& lnref) const;
+    bool sliceAtZ(double Z, BasicLine<C>& lnref) const;
 };
 
+// Only double and float Triangle3ds are made, as slicing interpolates
+//  between coordinates directly.
+typedef BasicTriangle3d<DoubleCoord> Triangle3d;
+typedef BasicTriangle3d<FloatCoord> Triangle3dF;
 
-typedef list<Triangle3d> Triangles3d;
+typedef vector<Triangle3d> Triangles3d;
 
 }
 
@@ -0,0 +1,40 @@
+//
+//  TestCheck.h
+//  Part of the Belfry Geometry Library
+//
+//  Created by GM on 2/28/11.
+//  Copyright 2011 Belfry Software. All rights reserved.
+//
+
+#ifndef BGL_TESTCHECK_H
+#define BGL_TESTCHECK_H
+
+#include <stdio.h>
+#include "../BGL.h"
+
+// Shared by the checking tests.  Each check prints PASS or FAIL, and
+//  main() returns failures ? 1 : 0 so a failing test stops 'make test'.
+
+static int failures = 0;
+
+static inline void check(const char* what, bool ok)
+{
+    printf("%s: %s\n", ok ? "PASS" : "FAIL", what);
+    if (!ok) {
+        failures++;
+    }
+}
+
+
+
+// A closed 30mm by 20mm square.
+const BGL::Point squareA[] =
+{
+    BGL::Point( 5.0,  5.0),
+    BGL::Point( 5.0, 25.0),
+    BGL::Point(35.0, 25.0),
+    BGL::Point(35.0,  5.0),
+    BGL::Point( 5.0,  5.0)
+};
+
+#endif
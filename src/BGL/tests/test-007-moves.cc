@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+#include <type_traits>
+#include "../BGL.h"
+#include "TestCheck.h"
+
+// Checks that moving geometry between containers relinks it, rather
+//  than copying it.  Every heap allocation is counted, so a stray deep
+//  copy shows up as a mismatch.
+
+static size_t allocCount = 0;
+
+void* operator new(size_t sz)
+{
+    allocCount++;
+    void* p = malloc(sz ? sz : 1);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+
+
+static_assert(std::is_trivially_copyable<BGL::Point>::value, "Point should be trivially copyable");
+static_assert(std::is_trivially_copyable<BGL::Point3d>::value, "Point3d should be trivially copyable");
+static_assert(std::is_trivially_copyable<BGL::Line>::value, "Line should be trivially copyable");
+
+
+
+static void check(const char* what, size_t got, size_t expected)
+{
+    check(what, got == expected);
+    if (got != expected) {
+        printf("    %lu allocations, expected %lu\n", (unsigned long)got, (unsigned long)expected);
+    }
+}
+
+
+
+BGL::Point squareB[] =
+{
+    BGL::Point(45.0,  5.0),
+    BGL::Point(45.0, 25.0),
+    BGL::Point(65.0, 25.0),
+    BGL::Point(65.0,  5.0),
+    BGL::Point(45.0,  5.0)
+};
+
+
+
+int main(int argc, char**argv)
+{
+    size_t before;
+
+    BGL::Path path1(5, squareA);
+    before = allocCount;
+    BGL::Path path2(std::move(path1));
+    check("Path move construct", allocCount - before, 0);
+
+    before = allocCount;
+    path1 = std::move(path2);
+    check("Path move assign", allocCount - before, 0);
+
+    BGL::Paths paths;
+    before = allocCount;
+    paths.push_back(std::move(path1));
+    check("Paths push_back moved Path", allocCount - before, 1);
+
+    // Split a closed square in two and join it back up again.
+    BGL::Path head, tail;
+    BGL::Lines::iterator it = paths.front().segments.begin();
+    for (int i = 0; i < 2; i++, it++) {
+        head.segments.push_back(*it);
+    }
+    for ( ; it != paths.front().segments.end(); it++) {
+        tail.segments.push_back(*it);
+    }
+    before = allocCount;
+    bool joined = head.attach(std::move(tail));
+    check("Path attach moved Path", allocCount - before, 0);
+    if (!joined || head.segments.size() != 4 || !tail.segments.empty()) {
+        printf("FAIL: Path attach moved Path joined wrongly\n");
+        failures++;
+    }
+
+    BGL::SimpleRegion reg1(BGL::Path(5, squareA));
+    before = allocCount;
+    BGL::SimpleRegion reg2(std::move(reg1));
+    check("SimpleRegion move construct", allocCount - before, 0);
+
+    BGL::SimpleRegions regs;
+    regs.push_back(reg2);
+    regs.push_back(BGL::SimpleRegion(BGL::Path(5, squareB)));
+    BGL::CompoundRegion creg1(regs);
+    before = allocCount;
+    BGL::CompoundRegion creg2(std::move(creg1));
+    check("CompoundRegion move construct", allocCount - before, 0);
+
+    before = allocCount;
+    creg1 = std::move(creg2);
+    check("CompoundRegion move assign", allocCount - before, 0);
+
+    BGL::Mesh3d mesh1;
+    mesh1.triangles.push_back(BGL::Triangle3d(BGL::Point3d(0,0,0), BGL::Point3d(1,0,0), BGL::Point3d(0,1,0)));
+    before = allocCount;
+    BGL::Mesh3d mesh2(std::move(mesh1));
+    check("Mesh3d move construct", allocCount - before, 0);
+
+    // Assembling paths from loose segments should allocate only the
+    //  output paths themselves; the segment nodes are spliced across.
+    BGL::Lines lines;
+    BGL::Path sqA(5, squareA);
+    BGL::Path sqB(5, squareB);
+    lines.insert(lines.end(), sqA.segments.begin(), sqA.segments.end());
+    lines.insert(lines.end(), sqB.segments.begin(), sqB.segments.end());
+    BGL::Paths outPaths;
+    before = allocCount;
+    BGL::Path::assemblePathsFromSegments(std::move(lines), outPaths);
+    check("assemblePathsFromSegments moved Lines", allocCount - before, outPaths.size());
+    if (outPaths.size() != 2) {
+        printf("FAIL: assemblePathsFromSegments made %lu paths, expected 2\n", (unsigned long)outPaths.size());
+        failures++;
+    }
+
+    return failures ? 1 : 0;
+}
+
+
@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include "../BGL.h"
+#include "TestCheck.h"
+
+// Checks copy-on-write sharing of regions, and that shared regions
+//  keep the arena they were built in alive.
+
+
+
+int main(int argc, char**argv)
+{
+    BGL::SharedRegion empty;
+    check("Default handle is empty", empty->size() == 0 && !empty.isShared());
+
+    std::shared_ptr<BGL::Arena> arena = BGL::Arena::create();
+    std::weak_ptr<BGL::Arena> watch(arena);
+    BGL::SharedRegion reg1;
+    {
+        BGL::ArenaScope scope(arena.get());
+        BGL::Paths paths;
+        paths.push_back(BGL::Path(5, squareA));
+        BGL::CompoundRegion::assembleCompoundRegionFrom(paths, reg1.mutate());
+    }
+    check("Region built in arena", reg1->size() == 1 && arena->bytesAllocated() > 0);
+
+    BGL::SharedRegion reg2(reg1);
+    check("Copy shares geometry", reg2.sharesWith(reg1) && reg1.isShared());
+    check("Shared geometry is the same object", &*reg2 == &*reg1);
+
+    BGL::SharedRegions regs;
+    regs.push_back(reg1);
+    check("Copy into list shares geometry", regs.front().sharesWith(reg1));
+    regs.clear();
+
+    reg2.mutate() += BGL::Point(10.0, 0.0);
+    check("Mutate unshares geometry", !reg2.sharesWith(reg1) && !reg1.isShared());
+    check("Mutate leaves original alone",
+          reg1->subregions.front().outerPath.bounds().minX == 5.0 &&
+          reg2->subregions.front().outerPath.bounds().minX == 15.0);
+
+    BGL::CompoundRegion* before = &reg2.mutate();
+    check("Mutate of unshared geometry doesn't clone", before == &*reg2);
+
+    // The slice that built reg1 lets go of its arena.  reg1 must still
+    //  be readable, and the arena must go away only when reg1 does.
+    arena.reset();
+    check("Shared region keeps arena alive", !watch.expired());
+    check("Region still readable after arena dropped", reg1->contains(BGL::Point(20.0, 15.0)));
+    reg1.reset();
+    check("Arena freed with last region", watch.expired());
+
+    // A region kept from one slice, then grown by the next, must be
+    //  moved into, and hold, the arena that it grows in.
+    std::shared_ptr<BGL::Arena> lower = BGL::Arena::create();
+    std::shared_ptr<BGL::Arena> upper = BGL::Arena::create();
+    std::weak_ptr<BGL::Arena> watchLower(lower), watchUpper(upper);
+    BGL::SharedRegion kept;
+    {
+        BGL::ArenaScope scope(lower.get());
+        BGL::Paths paths;
+        paths.push_back(BGL::Path(5, squareA));
+        BGL::CompoundRegion::assembleCompoundRegionFrom(paths, kept.mutate());
+    }
+    lower.reset();
+    const BGL::CompoundRegion* inLower = &*kept;
+    {
+        BGL::ArenaScope scope(upper.get());
+        kept.mutate().subregions.push_back(BGL::SimpleRegion(BGL::Path(5, squareA)) + BGL::Point(40.0, 0.0));
+        check("Mutate in another arena clones", &*kept != inLower);
+        BGL::CompoundRegion* inUpper = &kept.mutate();
+        check("Mutate again in the same arena doesn't clone", inUpper == &*kept);
+    }
+    check("Region let go of the arena it left", watchLower.expired());
+    upper.reset();
+    check("Region holds the arena it grew in", !watchUpper.expired());
+    check("Grown region still readable", kept->size() == 2 && kept->contains(BGL::Point(60.0, 15.0)));
+    kept.reset();
+    check("Arena freed with grown region", watchUpper.expired());
+
+    return failures ? 1 : 0;
+}
+
+
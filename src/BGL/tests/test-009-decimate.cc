@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <math.h>
+#include "../BGL.h"
+#include "TestCheck.h"
+
+// Checks tolerance driven decimation of paths and regions.
+
+
+
+static double distanceFromPath(const BGL::Path& path, const BGL::Point& pt)
+{
+    double best = 9e9;
+    BGL::Lines::const_iterator it;
+    for (it = path.segments.begin(); it != path.segments.end(); it++) {
+        best = fmin(best, it->minimumSegmentDistanceFromPoint(pt));
+    }
+    return best;
+}
+
+
+
+// A square with a shallow notch in the top edge.
+BGL::Point notched[] =
+{
+    BGL::Point( 0.0,  0.0),
+    BGL::Point(10.0,  0.0),
+    BGL::Point(10.0, 10.0),
+    BGL::Point( 5.0,  9.5),
+    BGL::Point( 0.0, 10.0),
+    BGL::Point( 0.0,  0.0)
+};
+
+// A small island sitting in the notch.
+BGL::Point island[] =
+{
+    BGL::Point( 4.9,  9.7),
+    BGL::Point( 5.1,  9.7),
+    BGL::Point( 5.1,  9.8),
+    BGL::Point( 4.9,  9.8),
+    BGL::Point( 4.9,  9.7)
+};
+
+BGL::Point zigzag[] =
+{
+    BGL::Point( 0.0,  0.0),
+    BGL::Point( 1.0,  0.001),
+    BGL::Point( 2.0, -0.001),
+    BGL::Point( 3.0,  0.001),
+    BGL::Point( 4.0,  0.0)
+};
+
+
+
+int main(int argc, char**argv)
+{
+    const int circlePts = 720;
+    const double tolerance = 0.01;
+    BGL::Point circle[circlePts+1];
+    for (int i = 0; i <= circlePts; i++) {
+        double ang = (i % circlePts) * 2.0 * M_PI / circlePts;
+        circle[i] = BGL::Point(10.0 * cos(ang), 10.0 * sin(ang));
+    }
+    BGL::Path circ(circlePts+1, circle);
+    int removed = circ.decimate(tolerance);
+    check("Circle loses most of its vertices", circ.size() < circlePts / 5 && removed == circlePts - circ.size());
+    check("Circle stays closed", circ.isClosed());
+    double worst = 0.0;
+    for (int i = 0; i < circlePts; i++) {
+        worst = fmax(worst, distanceFromPath(circ, circle[i]));
+    }
+    check("Circle stays within tolerance", worst <= tolerance);
+
+    BGL::Path alone(6, notched);
+    alone.decimate(1.0);
+    check("Notch alone is removed", alone.size() == 4);
+
+    BGL::SimpleRegions regs;
+    regs.push_back(BGL::SimpleRegion(BGL::Path(6, notched)));
+    regs.push_back(BGL::SimpleRegion(BGL::Path(5, island)));
+    BGL::CompoundRegion creg(regs);
+    creg.decimate(1.0);
+    const BGL::Path& outer = creg.subregions.front().outerPath;
+    const BGL::Path& isle = creg.subregions.back().outerPath;
+    check("Notch kept when it would swallow an island", outer.size() == 5);
+    check("Island stays outside", !outer.intersects(isle) && !outer.contains(isle.startPoint()));
+
+    BGL::Path open(5, zigzag);
+    open.decimate(tolerance);
+    check("Open path keeps its ends",
+          open.size() == 1 && open.startPoint() == zigzag[0] && open.endPoint() == zigzag[4]);
+
+    BGL::Path untouched(5, zigzag);
+    check("Zero tolerance is a no-op", untouched.decimate(0.0) == 0 && untouched.size() == 4);
+
+    return failures ? 1 : 0;
+}
+
+
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <vector>
+#include "../BGL.h"
+#include "TestCheck.h"
+
+// Checks detection of slices that repeat the slice below them.
+
+
+
+// Adds a box with its bottom at z0 and its top at z1.
+static void addBox(BGL::Mesh3d &mesh, double size, double z0, double z1)
+{
+    double s = size / 2.0;
+    BGL::Point3d b[4] = {
+        BGL::Point3d(-s, -s, z0), BGL::Point3d( s, -s, z0),
+        BGL::Point3d( s,  s, z0), BGL::Point3d(-s,  s, z0)
+    };
+    BGL::Point3d t[4] = {
+        BGL::Point3d(-s, -s, z1), BGL::Point3d( s, -s, z1),
+        BGL::Point3d( s,  s, z1), BGL::Point3d(-s,  s, z1)
+    };
+    mesh.triangles.push_back(BGL::Triangle3d(b[0], b[2], b[1]));
+    mesh.triangles.push_back(BGL::Triangle3d(b[0], b[3], b[2]));
+    mesh.triangles.push_back(BGL::Triangle3d(t[0], t[1], t[2]));
+    mesh.triangles.push_back(BGL::Triangle3d(t[0], t[2], t[3]));
+    for (int i = 0; i < 4; i++) {
+        int j = (i + 1) % 4;
+        mesh.triangles.push_back(BGL::Triangle3d(b[i], b[j], t[j]));
+        mesh.triangles.push_back(BGL::Triangle3d(b[i], t[j], t[i]));
+    }
+}
+
+
+
+int main(int argc, char**argv)
+{
+    std::vector<double> zs;
+    for (int i = 0; i < 20; i++) {
+        zs.push_back(0.25 + 0.5 * i);
+    }
+    std::vector<int32_t> sameAs;
+
+    BGL::Mesh3d box;
+    addBox(box, 10.0, 0.0, 10.0);
+    int32_t repeats = box.findRepeatedSlices(zs, 0.0001, sameAs);
+    check("Every slice of a box repeats the first", repeats == 19 && sameAs[19] == 0);
+
+    // Single precision noise leaves walls a hair off vertical.
+    BGL::Mesh3d noisy;
+    addBox(noisy, 10.0, 0.0, 10.0);
+    noisy.triangles.back().vertex3.x += 1e-6;
+    repeats = noisy.findRepeatedSlices(zs, 0.0001, sameAs);
+    check("Nearly vertical walls still repeat", repeats == 19);
+    repeats = noisy.findRepeatedSlices(zs, 0.0, sameAs);
+    check("Zero tolerance needs exactly vertical walls", repeats == 0);
+
+    // A box on a narrower box.  The step is at Z=5.
+    BGL::Mesh3d stepped;
+    addBox(stepped, 10.0, 0.0, 5.0);
+    addBox(stepped, 6.0, 5.0, 10.0);
+    repeats = stepped.findRepeatedSlices(zs, 0.0001, sameAs);
+    check("Stepped boxes repeat within each step", repeats == 18 && sameAs[9] == 0 && sameAs[10] == 10 && sameAs[19] == 10);
+
+    // Slicing right through a vertex is never treated as a repeat.
+    std::vector<double> onVertex;
+    onVertex.push_back(4.0);
+    onVertex.push_back(5.0);
+    onVertex.push_back(6.0);
+    repeats = stepped.findRepeatedSlices(onVertex, 0.0001, sameAs);
+    check("Slices through vertices don't repeat", repeats == 0);
+
+    // Sloped walls change from slice to slice.
+    BGL::Mesh3d pyramid;
+    BGL::Point3d apex(0, 0, 10);
+    BGL::Point3d base[4] = {
+        BGL::Point3d(-5, -5, 0), BGL::Point3d( 5, -5, 0),
+        BGL::Point3d( 5,  5, 0), BGL::Point3d(-5,  5, 0)
+    };
+    for (int i = 0; i < 4; i++) {
+        pyramid.triangles.push_back(BGL::Triangle3d(base[i], base[(i+1)%4], apex));
+    }
+    pyramid.triangles.push_back(BGL::Triangle3d(base[0], base[2], base[1]));
+    pyramid.triangles.push_back(BGL::Triangle3d(base[0], base[3], base[2]));
+    repeats = pyramid.findRepeatedSlices(zs, 0.0001, sameAs);
+    check("Sloped walls don't repeat", repeats == 0 && sameAs[5] == 5);
+
+    return failures ? 1 : 0;
+}
+
+
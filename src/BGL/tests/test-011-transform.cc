@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <math.h>
+#include "../BGL.h"
+#include "TestCheck.h"
+
+// Checks placing geometry with affine transforms.
+
+
+
+// A closed 10mm by 5mm rectangle at the origin.
+BGL::Point rectA[] =
+{
+    BGL::Point( 0.0,  0.0),
+    BGL::Point(10.0,  0.0),
+    BGL::Point(10.0,  5.0),
+    BGL::Point( 0.0,  5.0),
+    BGL::Point( 0.0,  0.0)
+};
+
+
+
+int main(int argc, char**argv)
+{
+    check("Default affine is identity", BGL::Affine().isIdentity());
+
+    // Rotate a quarter turn about the origin, then move to (100,50).
+    BGL::Affine place = BGL::Affine::rotationAffine(M_PI/2.0);
+    place.tx = 100.0;
+    place.ty = 50.0;
+    check("Placement isn't identity", !place.isIdentity());
+
+    BGL::Point pt(10.0, 0.0);
+    pt.transform(place);
+    check("Point placed", pt == BGL::Point(100.0, 60.0));
+
+    BGL::Path path(5, rectA);
+    double area = path.area();
+    path.transform(place);
+    BGL::Bounds b = path.bounds();
+    check("Path placed", fabs(b.minX - 95.0) < 1e-9 && fabs(b.maxX - 100.0) < 1e-9 &&
+                         fabs(b.minY - 50.0) < 1e-9 && fabs(b.maxY - 60.0) < 1e-9);
+    check("Path stays closed and the same size", path.isClosed() && fabs(path.area() - area) < 1e-9);
+
+    BGL::SimpleRegions regs;
+    regs.push_back(BGL::SimpleRegion(BGL::Path(5, rectA)));
+    BGL::CompoundRegion creg(regs);
+    creg.transform(place);
+    check("Region placed", creg.contains(BGL::Point(97.5, 55.0)) && !creg.contains(BGL::Point(5.0, 2.5)));
+
+    return failures ? 1 : 0;
+}
+
+
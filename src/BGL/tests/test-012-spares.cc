@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include "../BGL.h"
+#include "TestCheck.h"
+
+// Checks that released arena chunks are kept to be reused, and that
+//  a mesh can be read from an already open STL stream.
+
+
+
+const char* tetrahedron =
+    "solid tet\n"
+    "facet normal 0 0 -1\n outer loop\n  vertex 0 0 0\n  vertex 1 0 0\n  vertex 0 1 0\n endloop\nendfacet\n"
+    "facet normal 0 -1 0\n outer loop\n  vertex 0 0 0\n  vertex 0 0 1\n  vertex 1 0 0\n endloop\nendfacet\n"
+    "facet normal -1 0 0\n outer loop\n  vertex 0 0 0\n  vertex 0 1 0\n  vertex 0 0 1\n endloop\nendfacet\n"
+    "facet normal 1 1 1\n outer loop\n  vertex 1 0 0\n  vertex 0 0 1\n  vertex 0 1 0\n endloop\nendfacet\n"
+    "endsolid tet\n";
+
+
+
+int main(int argc, char**argv)
+{
+    const size_t chunk = BGL::Arena::DEFAULT_CHUNK_SIZE;
+
+    {
+        BGL::Arena arena;
+        arena.allocate(chunk / 2);
+        arena.allocate(chunk / 2);
+        arena.release();
+    }
+    check("Chunks are freed when there's no spare limit", BGL::Arena::spareChunkCount() == 0);
+
+    BGL::Arena::setSpareChunkLimit(2);
+    {
+        BGL::Arena arena;
+        for (size_t i = 0; i < 3 * chunk / 1024; i++) {
+            arena.allocate(1024);
+        }
+        arena.allocate(chunk / 2);    // Oversized, never kept.
+        arena.release();
+    }
+    check("Spare chunks kept up to the limit", BGL::Arena::spareChunkCount() == 2);
+
+    {
+        BGL::Arena arena;
+        arena.allocate(16);
+        check("New arena takes a spare chunk", BGL::Arena::spareChunkCount() == 1);
+    }
+    check("Destroyed arena gives its chunk back", BGL::Arena::spareChunkCount() == 2);
+
+    BGL::Arena::setSpareChunkLimit(0);
+    check("Lowering the limit frees spares", BGL::Arena::spareChunkCount() == 0);
+
+    FILE* f = tmpfile();
+    fputs(tetrahedron, f);
+    rewind(f);
+    BGL::Mesh3d mesh;
+    int32_t faces = mesh.loadFromSTLStream(f);
+    check("Mesh read from open stream", faces == 4 && mesh.maxZ == 1.0 && mesh.minX == 0.0);
+    check("Stream left open", fseek(f, 0, SEEK_SET) == 0);
+    fclose(f);
+
+    return failures ? 1 : 0;
+}
+
+
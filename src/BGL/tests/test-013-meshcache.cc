@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../BGL.h"
+#include "TestCheck.h"
+
+// Checks that a mesh saved to a cache file loads back the same, and
+//  that damaged cache files are refused.
+
+
+
+int main(int argc, char**argv)
+{
+    BGL::Mesh3d mesh;
+    BGL::Point3d a(0.0, 0.0, 0.0), b(10.0, 0.0, 0.0), c(0.0, 10.0, 0.0), d(0.0, 0.0, 10.0);
+    mesh.triangles.push_back(BGL::Triangle3d(a, c, b));
+    mesh.triangles.push_back(BGL::Triangle3d(a, b, d));
+    mesh.triangles.push_back(BGL::Triangle3d(a, d, c));
+    mesh.triangles.push_back(BGL::Triangle3d(b, c, d));
+    mesh.rotateZ(0.5);
+    mesh.translateToCenterOfPlatform();
+
+    const char* fileName = "output/test-013.bglmesh";
+    check("Mesh saved", mesh.saveToCacheFile(fileName));
+
+    BGL::Mesh3d loaded;
+    check("Mesh loaded", loaded.loadFromCacheFile(fileName));
+    bool same = loaded.size() == mesh.size();
+    BGL::Triangles3d::const_iterator it1 = mesh.triangles.begin();
+    BGL::Triangles3d::const_iterator it2 = loaded.triangles.begin();
+    for (; same && it1 != mesh.triangles.end(); it1++, it2++) {
+        same = !memcmp(&*it1, &*it2, sizeof(BGL::Triangle3d));
+    }
+    check("Triangles survive the round trip exactly", same);
+    check("Bounds survive the round trip",
+          loaded.minX == mesh.minX && loaded.maxX == mesh.maxX &&
+          loaded.minY == mesh.minY && loaded.maxY == mesh.maxY &&
+          loaded.minZ == mesh.minZ && loaded.maxZ == mesh.maxZ);
+
+    BGL::Mesh3d missing;
+    check("Missing file is refused", !missing.loadFromCacheFile("output/no-such-file.bglmesh"));
+
+    // Chop off part of the last triangle.
+    truncate(fileName, 80 + 3 * sizeof(BGL::Triangle3d) + 8);
+    BGL::Mesh3d truncated;
+    check("Truncated file is refused", !truncated.loadFromCacheFile(fileName) && truncated.size() == 0);
+
+    // A count so big that its size in bytes wraps around to the size
+    //  of the four triangles that are really there.
+    check("Mesh saved again", mesh.saveToCacheFile(fileName));
+    uint64_t lowBit = sizeof(BGL::Triangle3d) & -sizeof(BGL::Triangle3d);
+    uint64_t wrapped = 4 + ((uint64_t)1 << 63) / lowBit * 2;
+    FILE* hf = fopen(fileName, "r+b");
+    fseek(hf, 24, SEEK_SET);
+    fwrite(&wrapped, sizeof(wrapped), 1, hf);
+    fclose(hf);
+    BGL::Mesh3d overflowed;
+    check("Count that wraps around is refused", !overflowed.loadFromCacheFile(fileName) && overflowed.size() == 0);
+
+    // An STL file isn't a cache file.
+    FILE* f = fopen(fileName, "wb");
+    fprintf(f, "solid nothing\nendsolid nothing\n");
+    for (int i = 0; i < 20; i++) {
+        fprintf(f, "padding padding padding\n");
+    }
+    fclose(f);
+    BGL::Mesh3d wrong;
+    check("Other files are refused", !wrong.loadFromCacheFile(fileName));
+    unlink(fileName);
+
+    return failures ? 1 : 0;
+}
+
+
@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include "../BGL.h"
+#include "TestCheck.h"
+
+// Checks that geometry written by a BinaryWriter reads back exactly,
+//  and that short or damaged data is caught.
+
+
+
+static bool samePath(const BGL::Path& a, const BGL::Path& b)
+{
+    if (a.flags != b.flags || a.segments.size() != b.segments.size()) {
+        return false;
+    }
+    BGL::Lines::const_iterator ita = a.segments.begin();
+    BGL::Lines::const_iterator itb = b.segments.begin();
+    for (; ita != a.segments.end(); ita++, itb++) {
+        if (ita->startPt.x != itb->startPt.x || ita->startPt.y != itb->startPt.y ||
+            ita->endPt.x != itb->endPt.x || ita->endPt.y != itb->endPt.y ||
+            ita->flags != itb->flags || ita->temperature != itb->temperature ||
+            ita->extrusionWidth != itb->extrusionWidth) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+BGL::Point outer[] =
+{
+    BGL::Point( 0.0,  0.0),
+    BGL::Point(10.0,  0.0),
+    BGL::Point(10.0, 10.0),
+    BGL::Point( 0.0, 10.0),
+    BGL::Point( 0.0,  0.0)
+};
+
+BGL::Point hole[] =
+{
+    BGL::Point( 2.0,  2.0),
+    BGL::Point( 2.0,  8.0),
+    BGL::Point( 8.0 / 3.0,  8.0),
+    BGL::Point( 2.0,  2.0)
+};
+
+
+
+int main(int argc, char**argv)
+{
+    BGL::Paths paths;
+    paths.push_back(BGL::Path(5, outer));
+    paths.push_back(BGL::Path(4, hole));
+    BGL::CompoundRegion reg;
+    BGL::CompoundRegion::assembleCompoundRegionFrom(paths, reg);
+    reg.zLevel = 0.1;
+    BGL::Path open(4, outer);
+    open.flags = 3;
+    open.segments.front().flags = 7;
+    open.segments.front().temperature = 215.5;
+    open.segments.front().extrusionWidth = 0.63;
+
+    BGL::BinaryWriter out;
+    out.write(reg);
+    out.write(open);
+    out.writeU32(42);
+
+    BGL::BinaryReader in(out.data().data(), out.data().size());
+    BGL::CompoundRegion reg2;
+    BGL::Path open2;
+    uint32_t tail = 0;
+    in.read(reg2);
+    in.read(open2);
+    in.readU32(tail);
+    check("Everything read back", in.ok() && in.atEnd() && tail == 42);
+    check("Region keeps its Z", reg2.zLevel == reg.zLevel);
+    bool sameReg = reg2.subregions.size() == reg.subregions.size() &&
+        samePath(reg2.subregions.front().outerPath, reg.subregions.front().outerPath) &&
+        reg2.subregions.front().subpaths.size() == 1 &&
+        samePath(reg2.subregions.front().subpaths.front(), reg.subregions.front().subpaths.front());
+    check("Region geometry is exact", sameReg);
+    check("Path flags and line attributes kept", samePath(open2, open));
+
+    BGL::BinaryReader shortIn(out.data().data(), out.data().size() - 5);
+    BGL::CompoundRegion reg3;
+    BGL::Path open3;
+    shortIn.read(reg3);
+    shortIn.read(open3);
+    check("Short data is caught", !shortIn.ok() && !shortIn.readU32(tail));
+
+    // A huge segment count mustn't be believed.
+    BGL::BinaryWriter bad;
+    bad.writeU32(0);
+    bad.writeU32(0xffffffff);
+    BGL::BinaryReader badIn(bad.data().data(), bad.data().size());
+    BGL::Path open4;
+    check("Impossible counts are caught", !badIn.read(open4) && open4.size() == 0);
+
+    return failures ? 1 : 0;
+}
+
+
@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <math.h>
+#include "../BGL.h"
+#include "TestCheck.h"
+
+// Checks that geometry written by a CompactWriter reads back to within
+//  its quantum, that it comes out smaller than a BinaryWriter's, and
+//  that short or damaged data is caught.
+
+
+
+static bool nearPath(const BGL::Path& a, const BGL::Path& b, double tolerance)
+{
+    if (a.flags != b.flags || a.segments.size() != b.segments.size()) {
+        return false;
+    }
+    BGL::Lines::const_iterator ita = a.segments.begin();
+    BGL::Lines::const_iterator itb = b.segments.begin();
+    for (; ita != a.segments.end(); ita++, itb++) {
+        if (fabs(ita->startPt.x - itb->startPt.x) > tolerance || fabs(ita->startPt.y - itb->startPt.y) > tolerance ||
+            fabs(ita->endPt.x - itb->endPt.x) > tolerance || fabs(ita->endPt.y - itb->endPt.y) > tolerance ||
+            ita->flags != itb->flags || ita->temperature != itb->temperature ||
+            ita->extrusionWidth != itb->extrusionWidth) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+BGL::Point zigzag[] =
+{
+    BGL::Point(-5.0,  -5.0),
+    BGL::Point( 5.0,  -4.9),
+    BGL::Point(-5.0,  -4.8),
+    BGL::Point( 5.0,  -4.7)
+};
+
+
+
+int main(int argc, char**argv)
+{
+    const double quantum = 0.0001;
+    const int circlePts = 360;
+    BGL::Point circle[circlePts+1];
+    for (int i = 0; i <= circlePts; i++) {
+        double ang = (i % circlePts) * 2.0 * M_PI / circlePts;
+        circle[i] = BGL::Point(20.0 * cos(ang), 20.0 * sin(ang));
+    }
+    BGL::Paths paths;
+    paths.push_back(BGL::Path(circlePts+1, circle));
+    BGL::CompoundRegion reg;
+    BGL::CompoundRegion::assembleCompoundRegionFrom(paths, reg);
+    reg.zLevel = 0.36;
+
+    // Infill is loose segments, not a chain.
+    BGL::Path fill;
+    fill.segments.push_back(BGL::Line(zigzag[0], zigzag[1]));
+    fill.segments.push_back(BGL::Line(zigzag[2], zigzag[3]));
+    BGL::Path open(4, zigzag);
+    open.flags = 3;
+    open.segments.back().flags = -2;
+    open.segments.back().temperature = 215.5;
+    open.segments.back().extrusionWidth = 0.63;
+
+    BGL::CompactWriter out(quantum);
+    out.write(reg);
+    out.write(fill);
+    out.write(open);
+    out.writeSigned(-42);
+
+    BGL::BinaryWriter raw;
+    raw.write(reg);
+    check("Much smaller than exact", out.data().size() * 5 < raw.data().size());
+
+    BGL::CompactReader in(out.data().data(), out.data().size(), quantum);
+    BGL::CompoundRegion reg2;
+    BGL::Path fill2, open2;
+    int64_t tail = 0;
+    in.read(reg2);
+    in.read(fill2);
+    in.read(open2);
+    in.readSigned(tail);
+    check("Everything read back", in.ok() && in.atEnd() && tail == -42);
+    check("Region keeps its Z", reg2.zLevel == reg.zLevel);
+    bool nearReg = reg2.subregions.size() == 1 &&
+        nearPath(reg2.subregions.front().outerPath, reg.subregions.front().outerPath, quantum / 2);
+    check("Region geometry within quantum", nearReg);
+    check("Closed outline stays closed", reg2.subregions.front().outerPath.isClosed());
+    check("Loose segments stay loose", nearPath(fill2, fill, quantum / 2));
+    check("Path flags and line attributes kept", nearPath(open2, open, quantum / 2));
+
+    BGL::CompactReader shortIn(out.data().data(), out.data().size() - 5, quantum);
+    BGL::CompoundRegion reg3;
+    BGL::Path fill3, open3;
+    shortIn.read(reg3);
+    shortIn.read(fill3);
+    shortIn.read(open3);
+    check("Short data is caught", !shortIn.ok() && !shortIn.readSigned(tail));
+
+    // A huge segment count mustn't be believed.
+    BGL::CompactWriter bad(quantum);
+    bad.writeVarint(0);
+    bad.writeVarint(0xffffffffffULL);
+    bad.writeVarint(BGL::COMPACT_PATH_CHAINED);
+    BGL::CompactReader badIn(bad.data().data(), bad.data().size(), quantum);
+    BGL::Path open4;
+    check("Impossible counts are caught", !badIn.read(open4) && open4.size() == 0);
+
+    return failures ? 1 : 0;
+}
+
+
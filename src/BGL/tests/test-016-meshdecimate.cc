@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <math.h>
+#include "../BGL.h"
+#include "TestCheck.h"
+
+// Checks coarsening meshes by snapping vertices to a grid.
+
+
+
+// Adds a cylinder of the given radius, from Z=0 to height, made of
+//  sides facets, and capped at both ends.
+static void addCylinder(BGL::Mesh3d &mesh, double radius, double height, int sides)
+{
+    BGL::Point3d bc(0, 0, 0);
+    BGL::Point3d tc(0, 0, height);
+    for (int i = 0; i < sides; i++) {
+        double a0 = 2.0 * M_PI * i / sides;
+        double a1 = 2.0 * M_PI * (i + 1) / sides;
+        BGL::Point3d b0(radius * cos(a0), radius * sin(a0), 0);
+        BGL::Point3d b1(radius * cos(a1), radius * sin(a1), 0);
+        BGL::Point3d t0(b0.x, b0.y, height);
+        BGL::Point3d t1(b1.x, b1.y, height);
+        mesh.triangles.push_back(BGL::Triangle3d(bc, b1, b0));
+        mesh.triangles.push_back(BGL::Triangle3d(tc, t0, t1));
+        mesh.triangles.push_back(BGL::Triangle3d(b0, b1, t1));
+        mesh.triangles.push_back(BGL::Triangle3d(b0, t1, t0));
+    }
+    mesh.recalculateBounds();
+}
+
+
+
+int main(int argc, char**argv)
+{
+    BGL::Mesh3d fine;
+    addCylinder(fine, 10.0, 10.0, 400);
+    int32_t before = fine.size();
+
+    BGL::Mesh3d same(fine);
+    check("A fine grid drops nothing", same.decimate(0.001) == 0 && same.size() == before);
+    check("Zero cell size does nothing", same.decimate(0.0) == 0 && same.size() == before);
+
+    BGL::Mesh3d coarse(fine);
+    int32_t dropped = coarse.decimate(0.5);
+    check("A coarse grid drops most triangles", dropped > before / 2 && coarse.size() == before - dropped);
+    check("Bounds stay within a cell", fabs(coarse.maxX - 10.0) <= 0.25 && fabs(coarse.minY + 10.0) <= 0.25 &&
+                                       coarse.minZ == 0.0 && coarse.maxZ == 10.0);
+
+    BGL::CompoundRegion reg;
+    coarse.regionForSliceAtZ(5.25, reg);
+    bool closed = reg.subregions.size() == 1 && reg.subregions.front().outerPath.isClosed();
+    check("Coarsened mesh slices to one closed outline", closed);
+    check("Outline still holds the middle", closed && reg.subregions.front().contains(BGL::Point(0, 0)));
+    check("Outline stays near the original", closed && reg.subregions.front().contains(BGL::Point(9.0, 0)) &&
+                                             !reg.subregions.front().contains(BGL::Point(10.5, 0)));
+
+    return failures ? 1 : 0;
+}
+
+
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include "../BGL.h"
+#include "TestCheck.h"
+
+// Checks that filling a region's columns in runs matches filling them all at once.
+
+
+
+static bool samePaths(const BGL::Paths &a, const BGL::Paths &b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    BGL::Paths::const_iterator pa = a.begin(), pb = b.begin();
+    for ( ; pa != a.end(); pa++, pb++) {
+        if (pa->segments.size() != pb->segments.size()) {
+            return false;
+        }
+        BGL::Lines::const_iterator la = pa->segments.begin(), lb = pb->segments.begin();
+        for ( ; la != pa->segments.end(); la++, lb++) {
+            if (la->startPt.x != lb->startPt.x || la->startPt.y != lb->startPt.y ||
+                la->endPt.x != lb->endPt.x || la->endPt.y != lb->endPt.y) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+
+// A square with a square hole, off the origin so the columns don't
+//  start on a round number.
+BGL::Point outer[] =
+{
+    BGL::Point(  3.3,   1.7),
+    BGL::Point(103.3,   1.7),
+    BGL::Point(103.3, 101.7),
+    BGL::Point(  3.3, 101.7),
+    BGL::Point(  3.3,   1.7)
+};
+
+BGL::Point hole[] =
+{
+    BGL::Point( 40.0,  40.0),
+    BGL::Point( 40.0,  60.0),
+    BGL::Point( 60.0,  60.0),
+    BGL::Point( 60.0,  40.0),
+    BGL::Point( 40.0,  40.0)
+};
+
+
+
+int main(int argc, char**argv)
+{
+    BGL::SimpleRegion reg(BGL::Path(5, outer));
+    reg.subpaths.push_back(BGL::Path(5, hole));
+
+    double densities[] = { 0.2, 0.5, 1.0 };
+    for (int d = 0; d < 3; d++) {
+        BGL::Paths whole;
+        reg.infillPathsForRegionWithDensity(densities[d], 0.5, whole);
+        int columns = reg.infillColumnCount(densities[d], 0.5);
+
+        BGL::Paths striped;
+        for (int first = 0; first < columns; first += 7) {
+            BGL::Paths stripe;
+            reg.infillPathsForColumns(densities[d], 0.5, first, 7, stripe);
+            striped.splice(striped.end(), stripe);
+        }
+        char what[64];
+        snprintf(what, sizeof(what), "Stripes match whole infill at density %.1f", densities[d]);
+        check(what, !whole.empty() && columns > 7 && samePaths(whole, striped));
+    }
+
+    BGL::Paths none;
+    reg.infillPathsForColumns(0.5, 0.5, reg.infillColumnCount(0.5, 0.5), 10, none);
+    check("No columns past the last", none.empty());
+    check("No columns at zero density", reg.infillColumnCount(0.0, 0.5) == 0);
+
+    return failures ? 1 : 0;
+}
+
+
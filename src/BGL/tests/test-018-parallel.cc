@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "../BGL.h"
+#include "TestCheck.h"
+
+// Checks that whole-mesh passes come out the same split into runs as
+//  done in one go.
+
+
+
+// Does the runs of a loop backwards, one at a time, so nothing can
+//  depend on them being done in order, or all at once.
+class BackwardsExecutor : public BGL::Executor {
+public:
+    int calls;
+
+    BackwardsExecutor() : calls(0) {}
+    virtual void parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)> &body) {
+        calls++;
+        size_t runs = (end - begin + grain - 1) / grain;
+        for (size_t r = runs; r-- > 0; ) {
+            size_t first = begin + r * grain;
+            body(first, std::min(first + grain, end));
+        }
+    }
+};
+
+
+
+static void addTriangles(BGL::Mesh3d &mesh, int count)
+{
+    for (int i = 0; i < count; i++) {
+        double a = i * 0.001;
+        BGL::Point3d p1(10.0 * cos(a), 10.0 * sin(a), i * 0.0001);
+        BGL::Point3d p2(p1.x + 1.0, p1.y, p1.z + 0.5);
+        BGL::Point3d p3(p1.x, p1.y - 2.0, p1.z + 1.0);
+        mesh.triangles.push_back(BGL::Triangle3d(p1, p2, p3));
+    }
+    mesh.recalculateBounds();
+}
+
+
+
+static bool sameMesh(const BGL::Mesh3d &a, const BGL::Mesh3d &b)
+{
+    if (a.triangles.size() != b.triangles.size() ||
+        a.minX != b.minX || a.maxX != b.maxX ||
+        a.minY != b.minY || a.maxY != b.maxY ||
+        a.minZ != b.minZ || a.maxZ != b.maxZ
+    ) {
+        return false;
+    }
+    for (size_t i = 0; i < a.triangles.size(); i++) {
+        const BGL::Triangle3d &s = a.triangles[i];
+        const BGL::Triangle3d &t = b.triangles[i];
+        if (s.vertex1.x != t.vertex1.x || s.vertex1.y != t.vertex1.y || s.vertex1.z != t.vertex1.z ||
+            s.vertex2.x != t.vertex2.x || s.vertex2.y != t.vertex2.y || s.vertex2.z != t.vertex2.z ||
+            s.vertex3.x != t.vertex3.x || s.vertex3.y != t.vertex3.y || s.vertex3.z != t.vertex3.z
+        ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+static void putFloat(FILE *f, float val)
+{
+    uint8_t bytes[4];
+    memcpy(bytes, &val, 4);
+    fwrite(bytes, 1, 4, f);
+}
+
+
+
+int main(int argc, char**argv)
+{
+    BackwardsExecutor backwards;
+
+    // Sums of doubles depend on the order they're added in, so this
+    //  only matches if the runs are joined in order.
+    std::function<double(size_t, size_t, double)> sum = [](size_t first, size_t last, double init) {
+        double total = init;
+        for (size_t i = first; i < last; i++) {
+            total += 1.0 / (i + 1);
+        }
+        return total;
+    };
+    std::function<double(double, double)> add = [](double a, double b) { return a + b; };
+    double byNone = BGL::parallelReduce(NULL, 0, 100000, 1000, 0.0, sum, add);
+    double byBackwards = BGL::parallelReduce(&backwards, 0, 100000, 1000, 0.0, sum, add);
+    check("Reductions join runs in order", byNone == byBackwards && backwards.calls == 1);
+    check("An empty reduction is the identity", BGL::parallelReduce(&backwards, 5, 5, 10, 7.0, sum, add) == 7.0);
+
+    int calls = backwards.calls;
+    BGL::parallelFor(&backwards, 0, 10, 100, [](size_t, size_t) {});
+    check("Small loops aren't handed to the executor", backwards.calls == calls);
+
+    BGL::Mesh3d serial;
+    addTriangles(serial, 3 * BGL::MESH_PASS_GRAIN + 17);
+    BGL::Mesh3d split(serial);
+
+    serial.translate(1.5, -2.0, 0.25);
+    serial.scale(1.1, 0.9, 1.0);
+    serial.rotateX(0.3);
+    serial.rotateY(-0.2);
+    serial.rotateZ(1.0);
+
+    BGL::Executor::setCurrent(&backwards);
+    calls = backwards.calls;
+    split.translate(1.5, -2.0, 0.25);
+    split.scale(1.1, 0.9, 1.0);
+    split.rotateX(0.3);
+    split.rotateY(-0.2);
+    split.rotateZ(1.0);
+    check("Mesh passes use the current executor", backwards.calls > calls);
+    check("Mesh passes match done in one go", sameMesh(serial, split));
+
+    // A binary STL, with the normals left as zeros.
+    FILE *f = tmpfile();
+    char header[80];
+    memset(header, 0, sizeof(header));
+    fwrite(header, 1, sizeof(header), f);
+    uint32_t count = 2 * BGL::MESH_PASS_GRAIN + 5;
+    uint8_t countBytes[4] = { (uint8_t)count, (uint8_t)(count >> 8), (uint8_t)(count >> 16), (uint8_t)(count >> 24) };
+    fwrite(countBytes, 1, 4, f);
+    for (uint32_t i = 0; i < count; i++) {
+        for (int j = 0; j < 3; j++) {
+            putFloat(f, 0.0f);
+        }
+        putFloat(f, i * 0.5f); putFloat(f, 1.0f); putFloat(f, 2.0f);
+        putFloat(f, i * 0.5f + 1.0f); putFloat(f, 1.0f); putFloat(f, 2.0f);
+        putFloat(f, i * 0.5f); putFloat(f, 3.0f); putFloat(f, 2.25f);
+        uint8_t attr[2] = { 0, 0 };
+        fwrite(attr, 1, 2, f);
+    }
+    rewind(f);
+    BGL::Mesh3d loaded;
+    int32_t got = loaded.loadFromSTLStream(f);
+    fclose(f);
+    check("Binary STL reads every triangle", got == (int32_t)count && loaded.triangles.size() == count);
+    const BGL::Triangle3d &last = loaded.triangles.back();
+    check("Binary STL reads vertices as floats", last.vertex1.x == (count - 1) * 0.5f &&
+                                                 last.vertex2.x == (count - 1) * 0.5f + 1.0f &&
+                                                 last.vertex3.y == 3.0 && last.vertex3.z == 2.25);
+    check("Binary STL bounds", loaded.minX == 0.0 && loaded.maxX == (count - 1) * 0.5f + 1.0f &&
+                               loaded.minY == 1.0 && loaded.maxY == 3.0 &&
+                               loaded.minZ == 2.0 && loaded.maxZ == 2.25);
+    BGL::Executor::setCurrent(NULL);
+
+    return failures ? 1 : 0;
+}
+
+
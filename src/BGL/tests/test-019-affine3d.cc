@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <math.h>
+#include "../BGL.h"
+#include "TestCheck.h"
+
+// Checks 3D transforms, and placing meshes with one.
+
+
+
+static bool near(double a, double b)
+{
+    return fabs(a - b) < 1e-9;
+}
+
+
+
+static bool nearPoint(const BGL::Point3d &pt, double x, double y, double z)
+{
+    return near(pt.x, x) && near(pt.y, y) && near(pt.z, z);
+}
+
+
+
+// An off-center box, as twelve triangles.
+static void addBox(BGL::Mesh3d &mesh, double x0, double y0, double z0, double x1, double y1, double z1)
+{
+    BGL::Point3d p[8];
+    for (int i = 0; i < 8; i++) {
+        p[i] = BGL::Point3d((i & 1) ? x1 : x0, (i & 2) ? y1 : y0, (i & 4) ? z1 : z0);
+    }
+    static const int faces[12][3] = {
+        {0,2,1}, {1,2,3}, {4,5,6}, {5,7,6},
+        {0,1,4}, {1,5,4}, {2,6,3}, {3,6,7},
+        {0,4,2}, {2,4,6}, {1,3,5}, {3,7,5}
+    };
+    for (int i = 0; i < 12; i++) {
+        mesh.triangles.push_back(BGL::Triangle3d(p[faces[i][0]], p[faces[i][1]], p[faces[i][2]]));
+    }
+    mesh.recalculateBounds();
+}
+
+
+
+int main(int argc, char**argv)
+{
+    BGL::Affine3d aff;
+    check("Starts as the identity", aff.isIdentity());
+
+    // Steps are done in the order they're added.
+    aff.scale(2.0, 2.0, 2.0);
+    aff.translate(1.0, 0.0, 0.0);
+    BGL::Point3d pt(1.0, 1.0, 1.0);
+    aff.transformPoint(pt);
+    check("Scales, then translates", nearPoint(pt, 3.0, 2.0, 2.0));
+
+    BGL::Affine3d rot;
+    rot.rotateZAroundPoint(M_PI / 2.0, BGL::Point3d(1.0, 1.0, 5.0));
+    pt = BGL::Point3d(2.0, 1.0, 3.0);
+    rot.transformPoint(pt);
+    check("Rotates about a point", nearPoint(pt, 1.0, 2.0, 3.0));
+
+    BGL::Affine3d rx;
+    rx.rotateX(M_PI / 2.0);
+    pt = BGL::Point3d(0.0, 1.0, 0.0);
+    rx.transformPoint(pt);
+    check("Rotates about X", nearPoint(pt, 0.0, 0.0, 1.0));
+
+    BGL::Affine3d ry;
+    ry.rotateY(M_PI / 2.0);
+    pt = BGL::Point3d(0.0, 0.0, 1.0);
+    ry.transformPoint(pt);
+    check("Rotates about Y", nearPoint(pt, 1.0, 0.0, 0.0));
+
+    BGL::Affine flat(0.6, -0.8, 0.8, 0.6, 3.0, -4.0);
+    double fx = 2.0, fy = 5.0;
+    flat.transformPoint(fx, fy);
+    pt = BGL::Point3d(2.0, 5.0, 7.0);
+    BGL::Affine3d(flat).transformPoint(pt);
+    check("2D transforms work in the XY plane", nearPoint(pt, fx, fy, 7.0));
+
+    // Placing in one go matches the separate passes.
+    BGL::Mesh3d steps;
+    addBox(steps, 3.0, 4.0, 5.0, 13.0, 9.0, 25.0);
+    BGL::Mesh3d placed(steps);
+    steps.scale(1.5);
+    steps.rotateZ(0.4);
+    steps.translateToCenterOfPlatform();
+    placed.place(1.5, 0.4, true);
+    bool same = true;
+    for (size_t i = 0; i < steps.triangles.size(); i++) {
+        const BGL::Triangle3d &s = steps.triangles[i];
+        const BGL::Triangle3d &t = placed.triangles[i];
+        same = same && nearPoint(t.vertex1, s.vertex1.x, s.vertex1.y, s.vertex1.z) &&
+                       nearPoint(t.vertex2, s.vertex2.x, s.vertex2.y, s.vertex2.z) &&
+                       nearPoint(t.vertex3, s.vertex3.x, s.vertex3.y, s.vertex3.z);
+    }
+    check("Placing matches scaling, rotating, and centering", same);
+    check("Placed bounds match", near(placed.minX, steps.minX) && near(placed.maxX, steps.maxX) &&
+                                 near(placed.minY, steps.minY) && near(placed.maxY, steps.maxY) &&
+                                 placed.minZ == 0.0 && near(placed.maxZ, steps.maxZ));
+    check("Placed mesh is centered", near(placed.minX, -placed.maxX) && near(placed.minY, -placed.maxY));
+
+    // Just centering is exact.
+    BGL::Mesh3d moved;
+    addBox(moved, 3.0, 4.0, 5.0, 13.0, 9.0, 25.0);
+    BGL::Mesh3d centered(moved);
+    moved.translateToCenterOfPlatform();
+    centered.place(1.0, 0.0, true);
+    same = true;
+    for (size_t i = 0; i < moved.triangles.size(); i++) {
+        const BGL::Triangle3d &s = moved.triangles[i];
+        const BGL::Triangle3d &t = centered.triangles[i];
+        same = same && t.vertex1.x == s.vertex1.x && t.vertex1.y == s.vertex1.y && t.vertex1.z == s.vertex1.z &&
+                       t.vertex2.x == s.vertex2.x && t.vertex2.y == s.vertex2.y && t.vertex2.z == s.vertex2.z &&
+                       t.vertex3.x == s.vertex3.x && t.vertex3.y == s.vertex3.y && t.vertex3.z == s.vertex3.z;
+    }
+    check("Centering alone is exact", same && centered.minX == moved.minX && centered.maxZ == moved.maxZ);
+
+    BGL::Mesh3d bounds = moved.boundsAfter(rot);
+    BGL::Mesh3d rotated(moved);
+    rotated.transform(rot);
+    check("Bounds after match transforming", bounds.minX == rotated.minX && bounds.maxY == rotated.maxY &&
+                                             bounds.size() == 0 && rotated.size() == 12);
+
+    return failures ? 1 : 0;
+}
+
+
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "../BGL.h"
+#include "TestCheck.h"
+
+// Checks that every version of the slicing kernel this CPU can run
+//  finds the same triangles as the scalar one, and never misses one
+//  that slices, and that limiting CPU features picks plainer ones.
+//  Also that Mesh3d counts the same triangles at each Z.
+
+
+
+// Z values that are often exactly on the planes tried, or just by them.
+static double someZ()
+{
+    switch (rand() % 4) {
+        case 0: return (rand() % 5) * 0.5;
+        case 1: return (rand() % 5) * 0.5 + 1e-12;
+        default: return (rand() % 2000) / 1000.0;
+    }
+}
+
+
+
+int main(int argc, char**argv)
+{
+    const BGL::KernelFamily<BGL::ReachingZKernel> &family = BGL::reachingZKernelFamily();
+    unsigned detected = BGL::detectedCpuFeatures();
+    printf("CPU has %s.  Using the %s kernel.\n", BGL::cpuFeatureNames(detected).c_str(), family.best().name);
+    srand(1234);
+
+    // An odd count, so every kernel has some left over at the end.
+    std::vector<BGL::Triangle3d> tris;
+    for (int i = 0; i < 10007; i++) {
+        tris.push_back(BGL::Triangle3d(BGL::Point3d(rand() % 10, rand() % 10, someZ()),
+                                       BGL::Point3d(rand() % 10, rand() % 10, someZ()),
+                                       BGL::Point3d(rand() % 10, rand() % 10, someZ())));
+    }
+    tris[17].vertex2.z = NAN;
+
+    std::vector<uint32_t> fast(tris.size()), slow(tris.size());
+    for (size_t v = 0; v < family.count(); v++) {
+        const BGL::Kernel<BGL::ReachingZKernel> &kernel = family.kernel(v);
+        if ((kernel.needs & detected) != kernel.needs) {
+            printf("SKIP: %s kernel, which this CPU can't run\n", kernel.name);
+            continue;
+        }
+        bool same = true;
+        bool complete = true;
+        for (double Z = -0.25; Z <= 2.25; Z += 0.25) {
+            size_t nfast = kernel.fn(&tris[0], tris.size(), Z, &fast[0]);
+            size_t nslow = BGL::trianglesReachingZScalar(&tris[0], tris.size(), Z, &slow[0]);
+            same = same && nfast == nslow && std::equal(fast.begin(), fast.begin() + nfast, slow.begin());
+
+            size_t k = 0;
+            for (size_t i = 0; i < tris.size(); i++) {
+                BGL::Line ln;
+                if (tris[i].sliceAtZ(Z, ln)) {
+                    while (k < nfast && fast[k] < i) {
+                        k++;
+                    }
+                    complete = complete && k < nfast && fast[k] == i;
+                }
+            }
+        }
+        size_t few = kernel.fn(&tris[0], 3, 1.0, &fast[0]);
+        bool edges = few == BGL::trianglesReachingZScalar(&tris[0], 3, 1.0, &slow[0]) &&
+                     kernel.fn(&tris[0], 0, 1.0, &fast[0]) == 0;
+
+        char what[128];
+        snprintf(what, sizeof(what), "The %s kernel finds the same triangles as the scalar one", kernel.name);
+        check(what, same);
+        snprintf(what, sizeof(what), "The %s kernel finds every triangle that slices", kernel.name);
+        check(what, complete);
+        snprintf(what, sizeof(what), "The %s kernel handles fewer triangles than lanes", kernel.name);
+        check(what, edges);
+    }
+
+    // Counting the triangles at many Zs at once should agree with
+    //  going through them at each.
+    BGL::Mesh3d mesh;
+    mesh.triangles = tris;
+    mesh.triangles[17] = tris[16];
+    std::vector<double> zs;
+    for (double Z = -0.25; Z <= 2.25; Z += 0.125) {
+        zs.push_back(Z);
+    }
+    std::vector<uint32_t> crossings;
+    mesh.countCrossings(zs, crossings);
+    bool counted = crossings.size() == zs.size();
+    for (size_t k = 0; counted && k < zs.size(); k++) {
+        counted = crossings[k] == BGL::trianglesReachingZScalar(&mesh.triangles[0], mesh.triangles.size(), zs[k], &slow[0]);
+    }
+    check("Crossings are counted at every Z", counted);
+
+    unsigned features = 0;
+    check("Feature lists parse", BGL::parseCpuFeatures("sse2,avx512", features) &&
+                                 features == (BGL::CPU_SSE2 | BGL::CPU_AVX512));
+    check("None parses", BGL::parseCpuFeatures("none", features) && features == 0);
+    check("Unknown features don't parse", !BGL::parseCpuFeatures("sse2,mmx", features));
+    check("Feature names", BGL::cpuFeatureNames(BGL::CPU_SSE2 | BGL::CPU_AVX2) == "sse2,avx2" &&
+                           BGL::cpuFeatureNames(0) == "none");
+
+    BGL::limitCpuFeatures(0);
+    check("Limiting to no features picks the scalar kernel", std::string(family.best().name) == "scalar" &&
+                                                             BGL::cpuFeatures() == 0);
+    BGL::limitCpuFeatures(BGL::CPU_SSE2);
+    check("Limiting features picks no more than allowed", (family.best().needs & ~BGL::CPU_SSE2) == 0);
+    BGL::limitCpuFeatures(BGL::CPU_ALL);
+    size_t best = 0;
+    while ((family.kernel(best).needs & detected) != family.kernel(best).needs) {
+        best++;
+    }
+    check("Lifting the limit picks the best again", BGL::cpuFeatures() == detected && &family.best() == &family.kernel(best));
+
+    return failures ? 1 : 0;
+}
+
+
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../BGL.h"
+#include "TestCheck.h"
+
+// Checks that points, lines and triangles work alike with double,
+//  float and fixed point coordinates, each to their own tolerances.
+
+
+
+int main(int argc, char**argv)
+{
+    check("Double tolerances are unchanged", BGL::EPSILON == (double)1e-14f && BGL::CLOSEENOUGH == (double)1e-9f);
+    check("Float coordinates are half the size", sizeof(BGL::Triangle3dF) * 2 == sizeof(BGL::Triangle3d));
+
+    // Tenths can't be held exactly in floating point, but add up
+    //  exactly in fixed point.
+    BGL::PointX sumX;
+    BGL::Point sum;
+    for (int i = 0; i < 10; i++) {
+        sumX += BGL::PointX(0.1, 0.7);
+        sum += BGL::Point(0.1, 0.7);
+    }
+    check("Fixed point sums are exact", sumX.x == BGL::PointX(1.0, 7.0).x && sumX.y == BGL::PointX(1.0, 7.0).y);
+    check("Double sums aren't", sum.y != 7.0);
+    check("Fixed points within a unit aren't the same", BGL::PointX(1.0, 1.0) != BGL::PointX(1.0, 1.000001));
+    check("Fixed points compare equal", BGL::PointX(1.0, 1.0) == BGL::PointX(1.0000001, 1.0));
+
+    BGL::PointF pf(BGL::Point(1.25, -2.5));
+    BGL::Point3dX p3x(BGL::Point3d(1.25, -2.5, 3.0));
+    check("Points convert between coordinates", pf.x == 1.25f && pf.y == -2.5f && p3x.x == 1250000 && p3x.z == 3000000);
+
+    BGL::LineF lf(BGL::PointF(0.0, 0.0), BGL::PointF(10.0, 10.0));
+    BGL::IntersectionF isf = lf.intersectionWithSegment(BGL::LineF(BGL::PointF(0.0, 10.0), BGL::PointF(10.0, 0.0)));
+    check("Float lines intersect", isf.type == BGL::POINT && isf.p1 == BGL::PointF(5.0, 5.0));
+    BGL::LineX lx(BGL::PointX(0.0, 0.0), BGL::PointX(10.0, 10.0));
+    BGL::IntersectionX isx = lx.intersectionWithSegment(BGL::LineX(BGL::PointX(0.0, 10.0), BGL::PointX(10.0, 0.0)));
+    check("Fixed point lines intersect", isx.type == BGL::POINT && isx.p1 == BGL::PointX(5.0, 5.0));
+    check("Fixed point lines contain their midpoints", lx.contains(BGL::PointX(2.5, 2.5)) && !lx.contains(BGL::PointX(2.5, 2.501)));
+
+    // Slicing the same triangles as doubles and floats should agree to
+    //  within what a float can hold.
+    srand(4321);
+    bool agree = true;
+    for (int i = 0; i < 1000; i++) {
+        BGL::Triangle3d tri(BGL::Point3d(rand() % 100 / 4.0, rand() % 100 / 4.0, rand() % 40 / 8.0),
+                            BGL::Point3d(rand() % 100 / 4.0, rand() % 100 / 4.0, rand() % 40 / 8.0),
+                            BGL::Point3d(rand() % 100 / 4.0, rand() % 100 / 4.0, rand() % 40 / 8.0));
+        BGL::Triangle3dF trif(BGL::Point3dF(tri.vertex1), BGL::Point3dF(tri.vertex2), BGL::Point3dF(tri.vertex3));
+        for (double Z = 0.3; Z < 5.0; Z += 0.5) {
+            BGL::Line ln;
+            BGL::LineF lnf;
+            bool sliced = tri.sliceAtZ(Z, ln);
+            if (sliced != trif.sliceAtZ(Z, lnf)) {
+                agree = false;
+            } else if (sliced) {
+                agree = agree && BGL::PointF(ln.startPt) == lnf.startPt && BGL::PointF(ln.endPt) == lnf.endPt;
+            }
+        }
+    }
+    check("Float triangles slice like double ones", agree);
+
+    return failures ? 1 : 0;
+}
+
+
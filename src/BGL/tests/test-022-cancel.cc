@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <unistd.h>
+#include "../BGL.h"
+#include "TestCheck.h"
+
+// Checks that cancelling, by hand, by deadline or through a parent, is
+//  seen through nested scopes, and that slicing, filling and boolean
+//  ops give up early once it is.
+
+
+
+// Enough boxes, stacked, that a slice goes through many blocks of them.
+static void addBoxes(BGL::Mesh3d &mesh, int count)
+{
+    for (int k = 0; k < count; k++) {
+        double s = 1.0 + k * 0.01;
+        BGL::Point3d b[4] = {
+            BGL::Point3d(-s, -s, 0.0), BGL::Point3d( s, -s, 0.0),
+            BGL::Point3d( s,  s, 0.0), BGL::Point3d(-s,  s, 0.0)
+        };
+        BGL::Point3d t[4] = {
+            BGL::Point3d(-s, -s, 10.0), BGL::Point3d( s, -s, 10.0),
+            BGL::Point3d( s,  s, 10.0), BGL::Point3d(-s,  s, 10.0)
+        };
+        for (int i = 0; i < 4; i++) {
+            int j = (i + 1) % 4;
+            mesh.triangles.push_back(BGL::Triangle3d(b[i], b[j], t[j]));
+            mesh.triangles.push_back(BGL::Triangle3d(b[i], t[j], t[i]));
+        }
+    }
+}
+
+
+
+BGL::Point square[] =
+{
+    BGL::Point(  0.0,   0.0),
+    BGL::Point(100.0,   0.0),
+    BGL::Point(100.0, 100.0),
+    BGL::Point(  0.0, 100.0),
+    BGL::Point(  0.0,   0.0)
+};
+
+BGL::Point corner[] =
+{
+    BGL::Point( 50.0,  50.0),
+    BGL::Point(150.0,  50.0),
+    BGL::Point(150.0, 150.0),
+    BGL::Point( 50.0, 150.0),
+    BGL::Point( 50.0,  50.0)
+};
+
+
+
+int main(int argc, char**argv)
+{
+    BGL::Cancellation job;
+    BGL::Cancellation layer;
+    layer.setParent(&job);
+    check("Nothing is cancelled to start with", !job.isCancelled() && !layer.isCancelled() && !BGL::cancelRequested());
+    job.cancel();
+    check("Cancelling a parent cancels its children", layer.isCancelled());
+    BGL::Cancellation copy(job);
+    check("Copies start out fresh", !copy.isCancelled());
+
+    BGL::Cancellation timed;
+    timed.setDeadline(0.01);
+    check("Deadlines don't pass early", !timed.isCancelled());
+    usleep(20000);
+    check("Deadlines cancel once passed", timed.isCancelled());
+    BGL::Cancellation cleared;
+    cleared.setDeadline(0.01);
+    cleared.setDeadline(0.0);
+    usleep(20000);
+    check("Deadlines can be cleared", !cleared.isCancelled());
+
+    BGL::Cancellation outer, inner, other;
+    {
+        BGL::CancelScope outerScope(&outer);
+        BGL::CancelScope innerScope(&inner);
+        check("Scopes nest", BGL::CancelScope::current() == &innerScope && !BGL::cancelRequested());
+        outer.cancel();
+        check("Cancelling an outer scope is seen inside it", BGL::cancelRequested());
+        {
+            BGL::CancelScope helperScope(&other, NULL);
+            check("A scope needn't carry on from the one it's in", !BGL::cancelRequested());
+        }
+        BGL::CancelScope helperScope(NULL, &outerScope);
+        check("A scope can carry on from another", BGL::cancelRequested());
+    }
+    check("Leaving scopes restores none", BGL::CancelScope::current() == NULL && !BGL::cancelRequested());
+
+    BGL::Mesh3d mesh;
+    addBoxes(mesh, 1000);
+    BGL::CompoundRegion whole;
+    mesh.regionForSliceAtZ(5.0, whole);
+    BGL::SimpleRegion reg((BGL::Path(5, square)));
+    BGL::Paths fill;
+    reg.infillPathsForRegionWithDensity(0.5, 0.5, fill);
+    BGL::CompoundRegion a, b, diff;
+    a.subregions.push_back(reg);
+    b.subregions.push_back(BGL::SimpleRegion(BGL::Path(5, corner)));
+    BGL::CompoundRegion::differenceOf(a, b, diff);
+
+    BGL::Cancellation cancelled;
+    cancelled.cancel();
+    {
+        BGL::CancelScope scope(&cancelled);
+        BGL::CompoundRegion part;
+        mesh.regionForSliceAtZ(5.0, part);
+        check("Cancelled slicing gives up", !whole.subregions.empty() && part.subregions.empty() && part.zLevel == 5.0);
+        BGL::Paths partFill;
+        reg.infillPathsForRegionWithDensity(0.5, 0.5, partFill);
+        check("Cancelled filling gives up", !fill.empty() && partFill.empty());
+        BGL::CompoundRegion partDiff;
+        BGL::CompoundRegion::differenceOf(a, b, partDiff);
+        check("Cancelled boolean ops give up", diff.subregions.size() == 1 && diff.subregions.front().outerPath.size() == 6 &&
+                                              partDiff.subregions.size() == 1 && partDiff.subregions.front().outerPath.size() == 4);
+    }
+
+    return failures ? 1 : 0;
+}
+
+
@@ -21,14 +21,25 @@ CarveOp::~CarveOp()
 
 void CarveOp::main()
 {
-    if ( isCancelled ) return;
+    if ( isCancelled() ) return;
     if ( NULL == context ) return;
     if ( NULL == slice ) return;
 
-    context->mesh.regionForSliceAtZ(zLayer, slice->perimeter);
+    ArenaScope scope(slice->arena.get());
+    context->mesh.regionForSliceAtZ(zLayer, slice->perimeter.mutate());
+
+    // Carving gives up partway through once cancelled.
+    if ( isCancelled() ) return;
     slice->state = CARVED;
+}
+
 
-    if ( isCancelled ) return;
+
+// The key for this stage's output, given the key for the mesh it's
+//  carved from.  The outline only depends on the mesh and the Z.
+uint64_t CarveOp::dependencyKey(const SlicingContext &ctx, uint64_t upstream)
+{
+    return fnv1a("carve", 5, upstream);
 }
 
 
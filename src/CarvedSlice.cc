@@ -2,7 +2,203 @@
 #include "CarvedSlice.h"
 
 
-void CarvedSlice::svgPathWithSizeAndOffset(ostream &os, float width, float height, float dx, float dy, float strokeWidth)
+
+// Drops all of this layer's geometry, and frees the arena it was
+//  allocated from in one go, unless some other slice still shares
+//  regions out of it.  Call when the layer has been emitted.
+void CarvedSlice::release()
+{
+    perimeter.reset();
+    infillMask.reset();
+    shells.clear();
+    infill.clear();
+    arena = Arena::create();
+}
+
+
+// Takes on all of another layer's geometry, for a layer that's known
+//  to come out the same.  The regions are shared; the infill is copied
+//  into this layer's own arena.
+void CarvedSlice::reuseGeometryFrom(const CarvedSlice &src)
+{
+    ArenaScope scope(arena.get());
+    state = src.state;
+    perimeter = src.perimeter;
+    infillMask = src.infillMask;
+    shells = src.shells;
+    infill = src.infill;
+}
+
+
+
+// Bits saying which regions share the perimeter's geometry, so that
+//  reading them back shares it again, instead of making copies.
+#define SLICE_MASK_IS_PERIMETER   0x1
+#define SLICE_SHELLS_ARE_SHARED   0x2
+
+// More shells than this means the data's bad.
+#define SLICE_MAX_SHELLS          4096
+
+
+
+// Which of the layer's regions are the perimeter itself.
+uint32_t CarvedSlice::sharingFlags() const
+{
+    uint32_t sharing = 0;
+    if (infillMask.sharesWith(perimeter)) {
+        sharing |= SLICE_MASK_IS_PERIMETER;
+    }
+    bool shellsShared = !shells.empty();
+    SharedRegions::const_iterator it;
+    for (it = shells.begin(); it != shells.end(); it++) {
+        shellsShared = shellsShared && it->sharesWith(perimeter);
+    }
+    if (shellsShared) {
+        sharing |= SLICE_SHELLS_ARE_SHARED;
+    }
+    return sharing;
+}
+
+
+
+// Writes the layer's state and all its geometry.  Regions that are the
+//  perimeter, as they are until real insets are done, aren't repeated.
+void CarvedSlice::writeTo(BinaryWriter &out) const
+{
+    uint32_t sharing = sharingFlags();
+    SharedRegions::const_iterator it;
+
+    out.writeU32(state);
+    out.writeDouble(zLevel);
+    out.writeU32(sharing);
+    out.write(*perimeter);
+    if (!(sharing & SLICE_MASK_IS_PERIMETER)) {
+        out.write(*infillMask);
+    }
+    out.writeU32(shells.size());
+    if (!(sharing & SLICE_SHELLS_ARE_SHARED)) {
+        for (it = shells.begin(); it != shells.end(); it++) {
+            out.write(**it);
+        }
+    }
+    out.write(infill);
+}
+
+
+
+// Replaces the layer with one written by writeTo(), building it in
+//  the layer's own arena.  Returns false if the data was bad, in which
+//  case the layer is left empty.
+bool CarvedSlice::readFrom(BinaryReader &in)
+{
+    release();
+    ArenaScope scope(arena.get());
+    uint32_t st, sharing, shellCount;
+    double z;
+    in.readU32(st);
+    in.readDouble(z);
+    in.readU32(sharing);
+    in.read(perimeter.mutate());
+    if (sharing & SLICE_MASK_IS_PERIMETER) {
+        infillMask = perimeter;
+    } else {
+        in.read(infillMask.mutate());
+    }
+    if (!in.readU32(shellCount) || shellCount > SLICE_MAX_SHELLS) {
+        release();
+        state = INIT;
+        return false;
+    }
+    for (uint32_t i = 0; in.ok() && i < shellCount; i++) {
+        if (sharing & SLICE_SHELLS_ARE_SHARED) {
+            shells.push_back(perimeter);
+        } else {
+            shells.push_back(SharedRegion());
+            in.read(shells.back().mutate());
+        }
+    }
+    in.read(infill);
+    if (!in.ok() || st > OUTPUT) {
+        release();
+        state = INIT;
+        return false;
+    }
+    state = (CarveSliceStatus)st;
+    zLevel = z;
+    return true;
+}
+
+
+
+// As writeTo(), but with coordinates rounded to the writer's quantum
+//  and packed small, for checkpoint files.
+void CarvedSlice::writeCompact(CompactWriter &out) const
+{
+    uint32_t sharing = sharingFlags();
+    SharedRegions::const_iterator it;
+
+    out.writeVarint(state);
+    out.writeDouble(zLevel);
+    out.writeVarint(sharing);
+    out.write(*perimeter);
+    if (!(sharing & SLICE_MASK_IS_PERIMETER)) {
+        out.write(*infillMask);
+    }
+    out.writeVarint(shells.size());
+    if (!(sharing & SLICE_SHELLS_ARE_SHARED)) {
+        for (it = shells.begin(); it != shells.end(); it++) {
+            out.write(**it);
+        }
+    }
+    out.write(infill);
+}
+
+
+
+// Replaces the layer with one written by writeCompact().  Returns
+//  false if the data was bad, in which case the layer is left empty.
+bool CarvedSlice::readCompact(CompactReader &in)
+{
+    release();
+    ArenaScope scope(arena.get());
+    uint64_t st, sharing, shellCount;
+    double z;
+    in.readVarint(st);
+    in.readDouble(z);
+    in.readVarint(sharing);
+    in.read(perimeter.mutate());
+    if (sharing & SLICE_MASK_IS_PERIMETER) {
+        infillMask = perimeter;
+    } else {
+        in.read(infillMask.mutate());
+    }
+    if (!in.readVarint(shellCount) || shellCount > SLICE_MAX_SHELLS) {
+        release();
+        state = INIT;
+        return false;
+    }
+    for (uint64_t i = 0; in.ok() && i < shellCount; i++) {
+        if (sharing & SLICE_SHELLS_ARE_SHARED) {
+            shells.push_back(perimeter);
+        } else {
+            shells.push_back(SharedRegion());
+            in.read(shells.back().mutate());
+        }
+    }
+    in.read(infill);
+    if (!in.ok() || st > OUTPUT) {
+        release();
+        state = INIT;
+        return false;
+    }
+    state = (CarveSliceStatus)st;
+    zLevel = z;
+    return true;
+}
+
+
+
+void CarvedSlice::svgHeader(ostream &os, float width, float height)
 {
     float pwidth  = width * 90.0f / 25.4f;
     float pheight = height * 90.0f / 25.4f;
@@ -16,23 +212,55 @@ void CarvedSlice::svgPathWithSizeAndOffset(ostream &os, float width, float heigh
     os << " width=\"" << width << "mm\"";
     os << " height=\"" << height << "mm\"";
     os << " viewport=\"0 0 " << pwidth << " " << pheight << "\">\n";
+}
+
 
-    CompoundRegions::iterator rit;
+
+void CarvedSlice::svgFooter(ostream &os)
+{
+    os << "</svg>\n";
+}
+
+
+
+void CarvedSlice::svgPathWithSizeAndOffset(ostream &os, float width, float height, float dx, float dy, float strokeWidth)
+{
+    svgHeader(os, width, height);
+    svgPathsWithPlacementAndOffset(os, Affine(), dx, dy, strokeWidth);
+    svgFooter(os);
+}
+
+
+
+// Writes this layer's paths as they'd be for one copy of the model,
+//  placed on the plate by the given affine.  The layer's own geometry
+//  is left alone; each copy is transformed on the way out.
+void CarvedSlice::svgPathsWithPlacementAndOffset(ostream &os, const Affine &placement, float dx, float dy, float strokeWidth) const
+{
+    bool moved = !placement.isIdentity();
+
+    SharedRegions::const_iterator rit;
     for (rit = shells.begin(); rit != shells.end(); rit++) {
 	os << "<path fill=\"none\" stroke=\"black\"";
 	os << " stroke-width=\"" << strokeWidth << "mm\"";
-	os << " d=\"" << rit->svgPathWithOffset(dx,dy) << "\" />\n";
+	if (moved) {
+	    CompoundRegion reg(**rit);
+	    os << " d=\"" << reg.transform(placement).svgPathWithOffset(dx,dy) << "\" />\n";
+	} else {
+	    os << " d=\"" << (*rit)->svgPathWithOffset(dx,dy) << "\" />\n";
+	}
     }
 
     Paths::const_iterator pit;
     for (pit = infill.begin(); pit != infill.end(); pit++) {
 	os << "<path fill=\"none\" stroke=\"black\"";
 	os << " stroke-width=\"" << strokeWidth << "mm\"";
-	os << " d=\"" << pit->svgPathWithOffset(dx,dy) << "\" />\n";
+	if (moved) {
+	    Path path(*pit);
+	    os << " d=\"" << path.transform(placement).svgPathWithOffset(dx,dy) << "\" />\n";
+	} else {
+	    os << " d=\"" << pit->svgPathWithOffset(dx,dy) << "\" />\n";
+	}
     }
-
-    os << "</svg>\n";
 }
 
-
-
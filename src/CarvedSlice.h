@@ -9,6 +9,7 @@ using namespace BGL;
 typedef enum {
     INIT,
     CARVED,
+    SIMPLIFIED,
     INSET,
     INFILLED,
     PATHED,
@@ -18,15 +19,55 @@ typedef enum {
 
 class CarvedSlice {
 public:
+    // Layer geometry is allocated out of this arena by the ops that
+    //  build it.  It must be declared first, so that it outlives the
+    //  geometry members when the slice is destroyed.  Regions shared
+    //  out to other slices keep it alive after that.
+    std::shared_ptr<Arena> arena;
+
+    // The regions are copy-on-write, so stages that only read them,
+    //  or that pass them along unchanged, share them for free.
     CarveSliceStatus state;
-    CompoundRegion perimeter;
-    CompoundRegion infillMask;
-    CompoundRegions shells;
+    // The Z this layer is printed at.  A layer that reuses another's
+    //  geometry keeps its own zLevel, while the regions keep theirs.
+    float zLevel;
+    SharedRegion perimeter;
+    SharedRegion infillMask;
+    SharedRegions shells;
     Paths infill;
 
-    CarvedSlice() : state(INIT), perimeter(), infill() {}
+    CarvedSlice() : arena(Arena::create()), state(INIT), zLevel(0.0f), perimeter(), infill() {}
+    CarvedSlice(const CarvedSlice& x)
+        : arena(Arena::create()), state(x.state), zLevel(x.zLevel), perimeter(x.perimeter), infillMask(x.infillMask),
+          shells(x.shells), infill(x.infill) {}
+
+    // Assignment operator.  The arena itself is never shared.
+    CarvedSlice& operator=(const CarvedSlice &rhs) {
+        if (this != &rhs) {
+            state = rhs.state;
+            zLevel = rhs.zLevel;
+            perimeter = rhs.perimeter;
+            infillMask = rhs.infillMask;
+            shells = rhs.shells;
+            infill = rhs.infill;
+        }
+        return *this;
+    }
 
+    void reuseGeometryFrom(const CarvedSlice &src);
+    void release();
+    void writeTo(BinaryWriter &out) const;
+    bool readFrom(BinaryReader &in);
+    void writeCompact(CompactWriter &out) const;
+    bool readCompact(CompactReader &in);
     void svgPathWithSizeAndOffset(ostream &os, float width, float height, float dx, float dy, float strokeWidth);
+    void svgPathsWithPlacementAndOffset(ostream &os, const Affine &placement, float dx, float dy, float strokeWidth) const;
+
+    static void svgHeader(ostream &os, float width, float height);
+    static void svgFooter(ostream &os);
+
+private:
+    uint32_t sharingFlags() const;
 };
 
 
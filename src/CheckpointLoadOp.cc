@@ -0,0 +1,32 @@
+//
+//  CheckpointLoadOp.cc
+//  Mandoline
+//
+//  Created by GM on 2/24/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include "CheckpointLoadOp.h"
+#include "SliceCheckpoint.h"
+#include "CarvedSlice.h"
+
+
+
+CheckpointLoadOp::~CheckpointLoadOp()
+{
+}
+
+
+
+void CheckpointLoadOp::main()
+{
+    if ( isCancelled() ) return;
+    if ( NULL == checkpoint ) return;
+    if ( NULL == slice ) return;
+
+    checkpoint->loadLayer(layerIndex, *slice);
+
+    if ( isCancelled() ) return;
+}
+
+
@@ -0,0 +1,33 @@
+//
+//  CheckpointLoadOp.h
+//  Mandoline
+//
+//  Created by GM on 2/24/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef CHECKPOINTLOADOP_H
+#define CHECKPOINTLOADOP_H
+
+#include "CarvedSlice.h"
+#include "SliceCheckpoint.h"
+#include "Operation.h"
+
+// Decodes one layer from a checkpoint.  The slice's state says which
+//  stages are left to do.  A layer that can't be read is left at INIT.
+class CheckpointLoadOp : public Operation {
+public:
+    size_t layerIndex;
+    const SliceCheckpoint* checkpoint;
+    CarvedSlice* slice;
+
+    CheckpointLoadOp(const SliceCheckpoint* ckpt, CarvedSlice* slc, size_t k)
+        : Operation(), layerIndex(k), checkpoint(ckpt), slice(slc)
+    {
+    }
+    virtual ~CheckpointLoadOp();
+    virtual void main();
+};
+
+#endif
+
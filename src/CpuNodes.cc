@@ -0,0 +1,104 @@
+//
+//  CpuNodes.cc
+//  Mandoline
+//
+//  Created by GM on 2/28/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
+#include "CpuNodes.h"
+
+
+
+#ifdef __linux__
+
+// Reads a CPU list such as "0-3,8-11" from sysfs.
+static bool readCpuList(const char *path, std::vector<int> &out)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+    char buf[4096];
+    bool ok = fgets(buf, sizeof(buf), f) != NULL;
+    fclose(f);
+    if (!ok) {
+        return false;
+    }
+    char *p = buf;
+    while (*p && *p != '\n') {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p) {
+            return false;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            out.push_back(cpu);
+        }
+        if (*p == ',') {
+            p++;
+        }
+    }
+    return true;
+}
+
+#endif
+
+
+
+CpuNodes::CpuNodes()
+{
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool haveAllowed = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    // Node numbers can have gaps, so go on a little past a missing one.
+    int missing = 0;
+    for (int node = 0; missing < 64; node++) {
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        std::vector<int> listed;
+        if (!readCpuList(path, listed)) {
+            missing++;
+            continue;
+        }
+        std::vector<int> usable;
+        for (size_t i = 0; i < listed.size(); i++) {
+            if (!haveAllowed || (listed[i] < CPU_SETSIZE && CPU_ISSET(listed[i], &allowed))) {
+                usable.push_back(listed[i]);
+            }
+        }
+        if (!usable.empty()) {
+            cpus.push_back(usable);
+        }
+    }
+#endif
+    if (cpus.empty()) {
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        cpus.push_back(std::vector<int>());
+        for (long cpu = 0; cpu < count || cpu == 0; cpu++) {
+            cpus[0].push_back(cpu);
+        }
+    }
+}
+
+
+
+const CpuNodes& CpuNodes::system()
+{
+    static CpuNodes nodes;
+    return nodes;
+}
+
+
@@ -0,0 +1,31 @@
+//
+//  CpuNodes.h
+//  Mandoline
+//
+//  Created by GM on 2/28/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef CPUNODES_H
+#define CPUNODES_H
+
+#include <vector>
+
+// The CPUs this process may run on, grouped by the NUMA node whose
+//  memory is nearest them.  Where there's no way to tell, it's one node
+//  with every online CPU.
+class CpuNodes {
+private:
+    std::vector<std::vector<int> > cpus;
+
+public:
+    CpuNodes();
+
+    static const CpuNodes& system();
+
+    int nodeCount() const { return cpus.size(); }
+    const std::vector<int>& cpusOfNode(int node) const { return cpus[node]; }
+};
+
+#endif
+
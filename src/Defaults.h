@@ -14,6 +14,25 @@
 #define DEFAULT_SHRINKAGE_RATIO       0.98f    /* Ratio of hot part to cooled part size. */
 #define DEFAULT_INFILL_DENSITY        0.2      /* Density of infill pattern.  1.0 = solid.  0.0 = hollow. */
 #define DEFAULT_PERIMETER_SHELLS      2
+#define DEFAULT_SIMPLIFY_RESOLUTION   0.0f     /* mm.  Carved outlines may stray this far to drop vertices.  0 = off.  (0.01 works well.) */
+#define REPEATED_LAYER_TOLERANCE      0.0001f  /* mm.  Walls this close to vertical count as vertical when finding repeated layers. */
 
 #define DEFAULT_WORKER_THREADS        8   /* Number of threads to slice with. */
 
+#define DEFAULT_MESH_CACHE_SIZE       16  /* Number of loaded models a server keeps ready to reslice. */
+#define SERVER_SPARE_ARENA_CHUNKS     256 /* Freed arena chunks a server keeps to reuse.  64K each. */
+#define SERVER_MAX_STL_BYTES          (1L << 30)  /* Largest model a server takes in a SLICEDATA request. */
+#define SERVER_CANCEL_POLL_MSEC       50  /* How often a server checks whether a client has moved on from a job. */
+#define SERVER_HANGUP_GRACE_MSEC      1000 /* How long a stopping server lets clients hear how their jobs ended before hanging up. */
+
+#define CHECKPOINT_QUANTUM            0.0001  /* mm.  Coordinates in checkpoint files are rounded to this. */
+#define OUT_OF_CORE_BAND_TRIANGLES    1000000 /* Triangles to aim for in each Z-band when slicing out of core. */
+#define OUT_OF_CORE_MAX_BANDS         256     /* Most Z-band spill files open at once. */
+#define WORKER_BANDS_PER_WORKER       4       /* Z-bands to split a model into for each worker process. */
+#define PREVIEW_MAX_LAYERS            64      /* Most layers to carve for a preview. */
+#define PREVIEW_MAX_TRIANGLES         100000  /* Models with more faces than this are coarsened for a preview. */
+#define PREVIEW_GRID_CELLS            256     /* Grid cells across a coarsened model's widest side. */
+#define PREVIEW_QUANTUM               0.01    /* mm.  Coordinates in compact previews are rounded to this. */
+#define PROGRESSIVE_COARSEST_STRIDE   64      /* Progressive slicing does every this many layers first. */
+#define INFILL_STRIPE_COLUMNS         16      /* Fill columns in each stripe a big layer is split into, to infill on many threads. */
+#define OP_BLOCK_MSEC                 5       /* Layers are handed to threads in blocks that should take about this long. */
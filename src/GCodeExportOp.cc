@@ -26,12 +26,12 @@ GCodeExportOp::~GCodeExportOp()
 
 void GCodeExportOp::main()
 {
-    if ( isCancelled ) return;
+    if ( isCancelled() ) return;
     if ( NULL == context ) return;
 
     // TODO: join paths and optimize them
 
-    if ( isCancelled ) return;
+    if ( isCancelled() ) return;
 }
 
 
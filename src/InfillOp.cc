@@ -6,13 +6,26 @@
 //  Copyright 2010 Belfry DevWorks. All rights reserved.
 //
 
+#include <vector>
 #include "InfillOp.h"
+#include "OpQueue.h"
+#include "Defaults.h"
 #include "BGL/BGL.h"
 #include "SlicingContext.h"
 #include "CarvedSlice.h"
 
 
 
+// A run of fill columns of one island of a layer.
+struct InfillStripe {
+    const SimpleRegion* region;
+    int firstColumn;
+    int columnCount;
+    Paths paths;
+};
+
+
+
 InfillOp::~InfillOp()
 {
 }
@@ -21,16 +34,60 @@ InfillOp::~InfillOp()
 
 void InfillOp::main()
 {
-    if ( isCancelled ) return;
+    if ( isCancelled() ) return;
     if ( NULL == context ) return;
     if ( NULL == slice ) return;
 
+    ArenaScope scope(slice->arena.get());
     float extrusionWidth = context->standardExtrusionWidth();
+    const CompoundRegion &mask = slice->infillMask.get();
+
+    // Split each island into stripes of columns.
+    vector<InfillStripe> stripes;
+    if (queue && queue->maxConcurrentOperationCount() > 1) {
+        SimpleRegions::const_iterator rit;
+        for (rit = mask.subregions.begin(); rit != mask.subregions.end(); rit++) {
+            int columns = rit->infillColumnCount(context->infillDensity, extrusionWidth);
+            for (int first = 0; first < columns; first += INFILL_STRIPE_COLUMNS) {
+                InfillStripe stripe;
+                stripe.region = &*rit;
+                stripe.firstColumn = first;
+                stripe.columnCount = INFILL_STRIPE_COLUMNS;
+                stripes.push_back(stripe);
+            }
+        }
+    }
+
+    if (stripes.size() > 1) {
+        // Stripes filled on other threads take their paths from the
+        //  heap, as a layer's arena is only for one thread at a time.
+        double density = context->infillDensity;
+        queue->parallelFor(0, stripes.size(), 1, [&](size_t first, size_t last) {
+            for (size_t k = first; k < last; k++) {
+                InfillStripe &stripe = stripes[k];
+                stripe.region->infillPathsForColumns(density, extrusionWidth, stripe.firstColumn, stripe.columnCount, stripe.paths);
+            }
+        });
+        for (size_t k = 0; k < stripes.size(); k++) {
+            slice->infill.splice(slice->infill.end(), stripes[k].paths);
+        }
+    } else {
+        mask.infillPathsForRegionWithDensity(context->infillDensity, extrusionWidth, slice->infill);
+    }
 
-    slice->infillMask.infillPathsForRegionWithDensity(context->infillDensity, extrusionWidth, slice->infill);
+    // Filling gives up partway through once cancelled.
+    if ( isCancelled() ) return;
     slice->state = INFILLED;
+}
+
 
-    if ( isCancelled ) return;
+
+// The key for this stage's output, given the key for its input.
+uint64_t InfillOp::dependencyKey(const SlicingContext &ctx, uint64_t upstream)
+{
+    uint64_t key = fnv1a("infill", 6, upstream);
+    key = fnv1aValue(ctx.infillDensity, key);
+    return fnv1aValue(ctx.standardExtrusionWidth(), key);
 }
 
 
@@ -13,18 +13,28 @@
 #include "SlicingContext.h"
 #include "Operation.h"
 
+class OpQueue;
+
+// Infills one layer.  Given a queue, a layer with more fill columns
+//  than INFILL_STRIPE_COLUMNS is split into stripes of columns, which
+//  threads on the queue help fill, so one big layer can keep them all
+//  busy.  The stripes are put back together in order, so the infill
+//  comes out just the same either way.
 class InfillOp : public Operation {
 public:
     float zLayer;
     SlicingContext* context;
     CarvedSlice* slice;
+    OpQueue* queue;
 
-    InfillOp(SlicingContext* ctx, CarvedSlice* slc, float Z)
-        : Operation(), zLayer(Z), context(ctx), slice(slc)
+    InfillOp(SlicingContext* ctx, CarvedSlice* slc, float Z, OpQueue* opQ = NULL)
+        : Operation(), zLayer(Z), context(ctx), slice(slc), queue(opQ)
     {
     }
     virtual ~InfillOp();
     virtual void main();
+
+    static uint64_t dependencyKey(const SlicingContext &ctx, uint64_t upstream);
 };
 
 #endif
@@ -21,16 +21,30 @@ InsetOp::~InsetOp()
 
 void InsetOp::main()
 {
-    if ( isCancelled ) return;
+    if ( isCancelled() ) return;
     if ( NULL == context ) return;
     if ( NULL == slice ) return;
 
+    ArenaScope scope(slice->arena.get());
     // TODO: perform actual insets to generate perimeter shells and the infill mask
+    // Until then, both just share the perimeter's geometry.
     slice->infillMask = slice->perimeter;
     slice->shells.push_back(slice->perimeter);
     slice->state = INSET;
 
-    if ( isCancelled ) return;
+    if ( isCancelled() ) return;
+}
+
+
+
+// The key for this stage's output, given the key for its input.
+//  Shells are extrusion widths apart, so that matters as well as
+//  how many there are.
+uint64_t InsetOp::dependencyKey(const SlicingContext &ctx, uint64_t upstream)
+{
+    uint64_t key = fnv1a("inset", 5, upstream);
+    key = fnv1aValue(ctx.perimeterShells, key);
+    return fnv1aValue(ctx.standardExtrusionWidth(), key);
 }
 
 
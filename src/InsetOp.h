@@ -25,6 +25,8 @@ public:
     }
     virtual ~InsetOp();
     virtual void main();
+
+    static uint64_t dependencyKey(const SlicingContext &ctx, uint64_t upstream);
 };
 
 #endif
@@ -0,0 +1,33 @@
+//
+//  LoadJobOp.cc
+//  Mandoline
+//
+//  Created by GM on 2/21/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include "LoadJobOp.h"
+#include "SliceJob.h"
+#include "OpQueue.h"
+
+
+
+LoadJobOp::~LoadJobOp()
+{
+}
+
+
+
+void LoadJobOp::main()
+{
+    if ( isCancelled() ) return;
+    if ( NULL == job ) return;
+    if ( NULL == queue ) return;
+
+    if (!job->load()) {
+        return;
+    }
+    job->addLayerOps(queue);
+}
+
+
@@ -0,0 +1,32 @@
+//
+//  LoadJobOp.h
+//  Mandoline
+//
+//  Created by GM on 2/21/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef LOADJOBOP_H
+#define LOADJOBOP_H
+
+#include "SliceJob.h"
+#include "OpQueue.h"
+#include "Operation.h"
+
+// Loads a batch job's model, then adds its layers to the same queue
+//  this op is run from.
+class LoadJobOp : public Operation {
+public:
+    SliceJob* job;
+    OpQueue* queue;
+
+    LoadJobOp(SliceJob* jb, OpQueue* opQ)
+        : Operation(), job(jb), queue(opQ)
+    {
+    }
+    virtual ~LoadJobOp();
+    virtual void main();
+};
+
+#endif
+
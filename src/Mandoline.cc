@@ -1,16 +1,35 @@
+#include <string.h>
 #include <unistd.h>
 #include <getopt.h>
+#include <vector>
+#include <list>
+#include <set>
 #include "Defaults.h"
 #include "Stopwatch.h"
 #include "SlicingContext.h"
 #include "Operation.h"
 #include "OpQueue.h"
 #include "CarveOp.h"
+#include "SimplifyOp.h"
 #include "InfillOp.h"
 #include "InsetOp.h"
 #include "SvgDumpOp.h"
 #include "PathFinderOp.h"
 #include "GCodeExportOp.h"
+#include "SliceJob.h"
+#include "LoadJobOp.h"
+#include "SliceServer.h"
+#include "MeshCache.h"
+#include "StageCache.h"
+#include "StageLoadOp.h"
+#include "StageSaveOp.h"
+#include "SliceCheckpoint.h"
+#include "CheckpointLoadOp.h"
+#include "MeshBands.h"
+#include "SliceWorker.h"
+#include "WorkerPool.h"
+#include "SlicePreview.h"
+#include "CpuNodes.h"
 #include "BGL/BGL.h"
 
 static string inFileName  = "";
@@ -20,7 +39,32 @@ static float rotation     = 0.0f;
 static bool  doCenter     = true;
 static float onlyAtZ      = -1.0;
 static bool  doDumpSVG    = false;
+static bool  doReuse      = true;
+static bool  doProgressive = false;
 static int   threadcount  = DEFAULT_WORKER_THREADS;
+static const char* batchManifest = NULL;
+static const char* serveSocket   = NULL;
+static string meshCacheDir  = "";
+static string stageCacheDir = "";
+static CarveSliceStatus saveAfter = INIT;
+static string saveAfterFile = "";
+static const char* resumeFrom = NULL;
+static string outOfCoreDir  = "";
+static int   workerCount  = 0;
+static bool  isWorker     = false;
+static string workerCommand = "";
+static const char* previewFile = NULL;
+static const char* cpuFeatureList = NULL;
+static bool  doPinThreads = false;
+static double jobDeadline = 0.0;
+
+// A copy of a model on the build plate.  An empty fileName means
+//  the model named on the command line.
+struct PlateInstance {
+    string fileName;
+    Affine placement;
+};
+static vector<PlateInstance> instances;
 
 enum ExportTypes {
     NONE,
@@ -34,24 +78,547 @@ void usage(const char* arg0, SlicingContext& ctx)
 {
     fprintf(stderr, "Usage: %s [OPTIONS] FILE\n", arg0);
     fprintf(stderr, "Or   : %s -m MATERIAL [OPTIONS] FILE\n", arg0);
+    fprintf(stderr, "Or   : %s -b MANIFEST [OPTIONS] [FILE...]\n", arg0);
+    fprintf(stderr, "Or   : %s -S SOCKET [OPTIONS]\n", arg0);
+    fprintf(stderr, "Or   : %s -U CHECKPOINT [OPTIONS]\n", arg0);
+    fprintf(stderr, "Or   : %s -W COUNT [-E COMMAND] [OPTIONS] FILE\n", arg0);
     fprintf(stderr, "\t[-m STRING]   Extruded material. (default ABS)\n");
     fprintf(stderr, "\t[-f FLOAT]    Filament diameter. (default %.1f mm)\n", ctx.filamentDiameter);
     fprintf(stderr, "\t[-F FLOAT]    Filament feedrate. (default %.3f mm/s)\n", ctx.filamentFeedRate);
     fprintf(stderr, "\t[-i FLOAT]    Infill density. (default %.2f)\n", ctx.infillDensity);
     fprintf(stderr, "\t[-l FLOAT]    Slicing layer thickness. (default %.2f mm)\n", ctx.layerThickness);
     fprintf(stderr, "\t[-p INT]      Number of perimeter shell layers. (default %d)\n", ctx.perimeterShells);
+    fprintf(stderr, "\t[-R FLOAT]    Simplify carved outlines to this resolution, in mm.  Lossy.  0 = off. (default %.3f)\n", ctx.simplifyResolution);
     fprintf(stderr, "\t[-w FLOAT]    Extrusion width over thickness ratio. (default %.2f)\n", ctx.widthOverHeightRatio);
     fprintf(stderr, "\t[-c]          DON'T center model on platform before slicing.\n");
+    fprintf(stderr, "\t[-D]          DON'T reuse layers that are identical to the one below.  (only done with -R above 0)\n");
+    fprintf(stderr, "\t[-G]          Slice batch and server jobs coarse to fine: every %dth layer, then the ones between.\n", PROGRESSIVE_COARSEST_STRIDE);
     fprintf(stderr, "\t[-s FLOAT]    Scale model.  (default %.4gx)\n", scaling);
     fprintf(stderr, "\t[-r FLOAT]    Rotate model about Z.  (default %.4g deg)\n", rotation);
     fprintf(stderr, "\t[-z FLOAT]    Slice model only at the given Z level.\n");
     fprintf(stderr, "\t[-d PREFIX]   Dump layers to SVG files with names like PREFIX-12.34.svg.\n");
     fprintf(stderr, "\t[-t INT]      Number of threads to slice with. (default %d)\n", threadcount);
+    fprintf(stderr, "\t[-V LIST]     Use no CPU features but these, from sse2,avx2,avx512, or none.  (this CPU has %s)\n",
+            BGL::cpuFeatureNames(BGL::detectedCpuFeatures()).c_str());
+    fprintf(stderr, "\t[-N]          Pin threads to CPUs, grouped by NUMA node, each node slicing its own layers.  (%d nodes here)\n",
+            CpuNodes::system().nodeCount());
+    fprintf(stderr, "\t[-I [FILE:]X,Y[,DEG]]  Place a copy of the model (or FILE) at X,Y, rotated about Z.  Repeatable.\n");
+    fprintf(stderr, "\t[-b MANIFEST] Slice every job in MANIFEST, one per line as FILE [OPTIONS], and each FILE given.\n");
+    fprintf(stderr, "\t              Jobs share one thread pool.  Options given here are the defaults.  - reads stdin.\n");
+    fprintf(stderr, "\t[-T SECONDS]  Cancel batch, server and worker jobs that take longer than this.\n");
+    fprintf(stderr, "\t[-C DIR]      Cache models, ready to slice, in DIR.  Reslicing the same model loads from there.\n");
+    fprintf(stderr, "\t[-K DIR]      Cache each layer after each stage in DIR.  Reslicing redoes only stages whose settings changed.\n");
+    fprintf(stderr, "\t[-A STAGE[:FILE]]  Save every layer after STAGE (carve, simplify, inset or infill) to FILE.\n");
+    fprintf(stderr, "\t              (default FILE is the model's name, ending in -STAGE.mckpt)\n");
+    fprintf(stderr, "\t[-U FILE]     Resume slicing from a checkpoint FILE saved by -A, instead of from a model.\n");
+    fprintf(stderr, "\t[-P FILE]     Preview: carve just the outlines of up to %d layers, coarsening big models, to FILE.\n", PREVIEW_MAX_LAYERS);
+    fprintf(stderr, "\t              As SVG if FILE ends in .svg, and compact otherwise.  - is compact on stdout.\n");
+    fprintf(stderr, "\t[-O DIR]      Slice out of core: spill the model to Z-bands in DIR, and carve one band at a time.\n");
+    fprintf(stderr, "\t[-W INT]      Slice in Z-bands on this many worker processes, then export here.\n");
+    fprintf(stderr, "\t[-E COMMAND]  Start each worker with this shell command, such as 'ssh node$MANDOLINE_WORKER mandoline -X'.\n");
+    fprintf(stderr, "\t              The model is sent to them.  Without it, workers are copies of this program.\n");
+    fprintf(stderr, "\t[-X]          Be a worker, taking bands to slice on stdin, and sending layers back on stdout.\n");
+    fprintf(stderr, "\t[-S SOCKET]   Serve slicing jobs on a Unix domain socket, keeping loaded models ready.\n");
     exit(-1);
 }
 
 
 
+// Parses an instance placement of the form [FILE:]X,Y[,DEG].
+bool parseInstance(const char* arg)
+{
+    PlateInstance inst;
+    const char* coords = strrchr(arg, ':');
+    if (coords) {
+        inst.fileName = string(arg, coords - arg);
+        coords++;
+    } else {
+        coords = arg;
+    }
+    float x = 0.0f, y = 0.0f, deg = 0.0f;
+    if (sscanf(coords, "%f,%f,%f", &x, &y, &deg) < 2) {
+        return false;
+    }
+    inst.placement = Affine::rotationAffine(deg*M_PI/180.0f);
+    inst.placement.tx = x;
+    inst.placement.ty = y;
+    instances.push_back(inst);
+    return true;
+}
+
+
+
+// The stages a checkpoint can be saved after, by name.
+static const struct {
+    const char *name;
+    CarveSliceStatus stage;
+} checkpointStages[] = {
+    {"carve",    CARVED},
+    {"simplify", SIMPLIFIED},
+    {"inset",    INSET},
+    {"infill",   INFILLED},
+    {NULL,       INIT}
+};
+
+
+
+// Parses a checkpoint request of the form STAGE[:FILE].  Without a
+//  FILE, the checkpoint is named for the model, as MODEL-STAGE.mckpt.
+bool parseSaveAfter(const char* arg)
+{
+    const char* file = strchr(arg, ':');
+    string name = file ? string(arg, file - arg) : string(arg);
+    for (int i = 0; checkpointStages[i].name; i++) {
+        if (name == checkpointStages[i].name) {
+            saveAfter = checkpointStages[i].stage;
+            saveAfterFile = file ? string(file + 1) : string();
+            return !file || file[1] != '\0';
+        }
+    }
+    return false;
+}
+
+
+
+string defaultCheckpointFile(const string &modelFile)
+{
+    size_t slash = modelFile.find_last_of('/');
+    size_t dot = modelFile.find_last_of('.');
+    string base = modelFile;
+    if (dot != string::npos && (slash == string::npos || dot > slash)) {
+        base = modelFile.substr(0, dot);
+    }
+    for (int i = 0; checkpointStages[i].name; i++) {
+        if (saveAfter == checkpointStages[i].stage) {
+            return base + "-" + checkpointStages[i].name + ".mckpt";
+        }
+    }
+    return base + ".mckpt";
+}
+
+
+
+// Loads a model, and scales, rotates and centers it as requested.
+void loadModel(SlicingContext &ctx, const string &fileName, Stopwatch &stopwatch)
+{
+    BGL::Mesh3d &mesh = ctx.mesh;
+
+    // A model that's been prepared the same way before can be mapped
+    //  straight in from the cache.
+    string cachePath;
+    if (!meshCacheDir.empty()) {
+        cachePath = MeshCache::preparedCachePath(meshCacheDir, fileName, scaling, rotation, doCenter);
+        if (!cachePath.empty() && MeshCache::loadPrepared(cachePath, mesh)) {
+            printf("Found %d faces in %s\n", mesh.size(), cachePath.c_str());
+            printf("Model Bounds = (%.2f, %.2f, %.2f) to (%.2f, %.2f, %.2f)\n", mesh.minX, mesh.minY, mesh.minZ, mesh.maxX, mesh.maxY, mesh.maxZ);
+            stopwatch.checkpoint("Prepared model loaded from cache");
+            return;
+        }
+    }
+
+    mesh.loadFromSTLFile(fileName.c_str());
+    printf("Found %d faces.\n", mesh.size());
+    stopwatch.checkpoint("Model loaded from file");
+    printf("Model Bounds = (%.2f, %.2f, %.2f) to (%.2f, %.2f, %.2f)\n", mesh.minX, mesh.minY, mesh.minZ, mesh.maxX, mesh.maxY, mesh.maxZ);
+    
+    // Scale, rotate, and center the model, as requested, all in one go.
+    if (scaling != 1.0f) {
+        printf("Scaling model by %.4gx\n", scaling);
+    }
+    if (rotation != 0.0f) {
+        printf("Rotating model by %.4g degrees\n", rotation);
+    }
+    if (doCenter) {
+        printf("Centering model on X=0, Y=0  Placing bottom at Z=0.\n");
+    }
+    mesh.place(scaling, rotation*M_PI/180.0f, doCenter);
+
+    if (scaling != 1.0f || rotation != 0.0f || doCenter) {
+	printf("New Bounds = (%.2f, %.2f, %.2f) to (%.2f, %.2f, %.2f)\n", mesh.minX, mesh.minY, mesh.minZ, mesh.maxX, mesh.maxY, mesh.maxZ);
+        stopwatch.checkpoint("Transformed");
+    }
+
+    if (!cachePath.empty() && mesh.size() > 0) {
+        MeshCache::savePrepared(cachePath, mesh);
+    }
+}
+
+
+
+// Streams a model too big to load into Z-bands on disk.  Only the
+//  model's bounds are loaded; its triangles wait in the bands.
+void spillModel(SlicingContext &ctx, MeshBands &bands, const string &fileName, Stopwatch &stopwatch)
+{
+    int64_t count = bands.build(fileName.c_str(), scaling, rotation, doCenter);
+    if (count == 0) {
+        fprintf(stderr, "Error: Couldn't spill model from '%s' to bands in '%s'.\n", fileName.c_str(), outOfCoreDir.c_str());
+        exit(-1);
+    }
+    ctx.mesh = bands.modelBounds();
+    Mesh3d &mesh = ctx.mesh;
+    printf("Found %lld faces.  Spilled to %d bands.\n", (long long)count, (int)bands.bandCount());
+    printf("Model Bounds = (%.2f, %.2f, %.2f) to (%.2f, %.2f, %.2f)\n", mesh.minX, mesh.minY, mesh.minZ, mesh.maxX, mesh.maxY, mesh.maxZ);
+    stopwatch.checkpoint("Model spilled to bands");
+}
+
+
+
+// The settings given on the command line, as defaults for batch
+//  and server jobs.
+SliceJob jobDefaults(const SlicingContext &ctx)
+{
+    SliceJob defaults;
+    defaults.context   = ctx;
+    defaults.scaling   = scaling;
+    defaults.rotation  = rotation;
+    defaults.doCenter  = doCenter;
+    defaults.onlyAtZ   = onlyAtZ;
+    defaults.doDumpSVG = doDumpSVG;
+    defaults.doReuse   = doReuse;
+    defaults.progressive = doProgressive;
+    defaults.meshCacheDir = meshCacheDir;
+    defaults.stageCacheDir = stageCacheDir;
+    defaults.deadline = jobDeadline;
+    return defaults;
+}
+
+
+
+// Slices every job in the batch on the one queue.  Loading a job
+//  queues up its layers, and layers from any job may run side by
+//  side, so nothing waits until the whole batch is done.  Returns
+//  the number of jobs that failed.
+int sliceBatch(list<SliceJob> &jobs, OpQueue &opQ, Stopwatch &stopwatch)
+{
+    list<SliceJob>::iterator it;
+    for (it = jobs.begin(); it != jobs.end(); it++) {
+        opQ.addOperation(new LoadJobOp(&*it, &opQ));
+    }
+    opQ.waitUntilAllOperationsAreFinished();
+    stopwatch.checkpoint("Batch sliced");
+
+    int failures = 0;
+    for (it = jobs.begin(); it != jobs.end(); it++) {
+        if (it->failed) {
+            failures++;
+        }
+    }
+    if (failures > 0) {
+        fprintf(stderr, "%d of %d jobs failed.\n", failures, (int)jobs.size());
+    }
+    return failures;
+}
+
+
+
+// Adds one stage's op for a layer to those to be queued.  With a stage
+//  cache, the layer is saved to it once the op is done.
+void addStageOperation(vector<Operation*> &ops, StageCache* stageCache, Operation* op, CarvedSlice* slice, float z)
+{
+    if (stageCache) {
+        double cost = op->cost;
+        op = new StageSaveOp(op, stageCache, slice, z);
+        op->cost = cost;
+    }
+    ops.push_back(op);
+}
+
+
+
+// Guesses how long a layer will take to infill.  Each fill column of
+//  an island is cut against every segment of its outline.
+double infillCost(const SlicingContext &ctx, const CarvedSlice &slice)
+{
+    double cost = 0.0;
+    float extrusionWidth = ctx.standardExtrusionWidth();
+    const CompoundRegion &mask = slice.infillMask.get();
+    SimpleRegions::const_iterator rit;
+    for (rit = mask.subregions.begin(); rit != mask.subregions.end(); rit++) {
+        cost += (double)rit->infillColumnCount(ctx.infillDensity, extrusionWidth) * rit->segmentCount();
+    }
+    return cost;
+}
+
+
+
+// Saves every layer to a checkpoint file, if this is the stage
+//  that was asked for.
+void saveCheckpoint(SlicingContext &ctx, const vector<double> &zs, const vector<int32_t> &sameAs,
+                    CarveSliceStatus stage, Stopwatch &stopwatch)
+{
+    if (stage != saveAfter) {
+        return;
+    }
+    if (!SliceCheckpoint::save(saveAfterFile, ctx, zs, sameAs, stage)) {
+        fprintf(stderr, "Error: Couldn't save checkpoint to '%s'.\n", saveAfterFile.c_str());
+        exit(-1);
+    }
+    printf("Saved %d layers to %s\n", (int)zs.size(), saveAfterFile.c_str());
+    stopwatch.checkpoint("Saved checkpoint");
+}
+
+
+
+// Carves a quick look at a model: just the outlines, of every few
+//  layers, from a coarsened copy of the model if it's big.  The layers
+//  carved are ones the real slice would have, in the same way, so the
+//  preview matches it.
+void previewModel(SlicingContext &ctx, OpQueue &opQ, Stopwatch &stopwatch)
+{
+    BGL::Mesh3d &mesh = ctx.mesh;
+
+    printf("Layer Thickness=%.4g\n", ctx.layerThickness);
+    vector<double> zs;
+    ctx.calculateLayerZs(onlyAtZ, zs);
+    size_t step = max((size_t)1, (zs.size() + PREVIEW_MAX_LAYERS - 1) / PREVIEW_MAX_LAYERS);
+
+    if (mesh.size() > PREVIEW_MAX_TRIANGLES) {
+        double extent = max(mesh.maxX - mesh.minX, max(mesh.maxY - mesh.minY, mesh.maxZ - mesh.minZ));
+        mesh.decimate(extent / PREVIEW_GRID_CELLS);
+        printf("Coarsened to %d faces.\n", mesh.size());
+        stopwatch.checkpoint("Coarsened");
+    }
+
+    vector<Operation*> ops;
+    for (size_t k = 0; k < zs.size(); k += step) {
+        CarvedSlice* slice = ctx.allocSlice(zs[k]);
+        ops.push_back(new CarveOp(&ctx, slice, zs[k]));
+    }
+    opQ.addOperations(ops);
+    opQ.waitUntilAllOperationsAreFinished();
+    printf("Previewed %d of %d layers.\n", (int)ctx.slices.size(), (int)zs.size());
+    stopwatch.checkpoint("Carved");
+}
+
+
+
+// Has the workers slice every layer of a model, a band at a time.
+void farmOutModel(SlicingContext &ctx, const SliceJob &defaults, const string &fileName, WorkerPool &pool, Stopwatch &stopwatch)
+{
+    printf("Layer Thickness=%.4g\n", ctx.layerThickness);
+    vector<double> zs;
+    ctx.calculateLayerZs(onlyAtZ, zs);
+    SliceJob job(defaults);
+    job.fileName = fileName;
+    if (!pool.slice(ctx, job, zs)) {
+        exit(-1);
+    }
+    printf("Sliced %d layers on %d workers.\n", (int)zs.size(), (int)pool.size());
+    stopwatch.checkpoint("Sliced by workers");
+}
+
+
+
+// Carves a model one Z-band at a time, with just that band's triangles
+//  loaded.  Repeated layers are found within each band, as it's loaded.
+void carveInBands(SlicingContext &ctx, OpQueue &opQ, const MeshBands &bands, const vector<double> &zs,
+                  vector<int32_t> &sameAs, map<float,float> &repeatedLayers)
+{
+    vector<size_t> firstInBand;
+    bands.splitLayers(zs, firstInBand);
+    sameAs.resize(zs.size());
+    for (size_t k = 0; k < zs.size(); k++) {
+        sameAs[k] = k;
+    }
+
+    int32_t repeats = 0;
+    for (size_t b = 0; b < bands.bandCount(); b++) {
+        size_t first = firstInBand[b];
+        size_t last = firstInBand[b+1];
+        if (first == last) {
+            continue;
+        }
+        if (!bands.loadBand(b, ctx.mesh)) {
+            fprintf(stderr, "Error: Couldn't read back band %d.\n", (int)b);
+            exit(-1);
+        }
+        vector<double> bandZs(zs.begin() + first, zs.begin() + last);
+        if (doReuse && ctx.canReuseLayers()) {
+            vector<int32_t> bandSameAs;
+            repeats += ctx.mesh.findRepeatedSlices(bandZs, REPEATED_LAYER_TOLERANCE, bandSameAs);
+            for (size_t i = 0; i < bandZs.size(); i++) {
+                if (bandSameAs[i] != (int32_t)i) {
+                    sameAs[first + i] = first + bandSameAs[i];
+                    repeatedLayers[zs[first + i]] = zs[first + bandSameAs[i]];
+                }
+            }
+        }
+        vector<uint32_t> crossings;
+        ctx.mesh.countCrossings(bandZs, crossings);
+        vector<Operation*> ops;
+        for (size_t k = first; k < last; k++) {
+            CarvedSlice* slice = &ctx.slices[zs[k]];
+            if (repeatedLayers.count(zs[k]) || slice->state >= CARVED) {
+                continue;
+            }
+            CarveOp* op = new CarveOp(&ctx, slice, zs[k]);
+            op->cost = crossings[k - first];
+            ops.push_back(op);
+        }
+        opQ.addOperations(ops);
+        opQ.waitUntilAllOperationsAreFinished();
+        ctx.mesh = bands.modelBounds();
+    }
+    if (doReuse && ctx.canReuseLayers()) {
+        printf("Found %d layers identical to the one below.\n", repeats);
+    }
+}
+
+
+
+// Carves, simplifies, insets and infills every layer of a model.  With
+//  a checkpoint to resume from, the layers come from that instead, and
+//  only the stages after it are done.  With bands, the model is carved
+//  from them, a band at a time.
+void sliceModel(SlicingContext &ctx, OpQueue &opQ, Stopwatch &stopwatch, const SliceCheckpoint* resume, const MeshBands* bands)
+{
+    BGL::Mesh3d &mesh = ctx.mesh;
+
+    // Calculate first and last layer Zs
+    printf("Layer Thickness=%.4g\n", ctx.layerThickness);
+    vector<double> zs;
+    vector<int32_t> sameAs;
+    if (resume) {
+        resume->layerZs(zs, sameAs);
+    } else {
+        ctx.calculateLayerZs(onlyAtZ, zs);
+    }
+    
+    // Find layers that will come out the same as the one below them.
+    //  These just reuse that layer's geometry, rather than being
+    //  carved, inset and infilled all over again.
+    map<float,float> repeatedLayers;
+    if (doReuse && ctx.canReuseLayers() && !resume && !bands) {
+        int32_t repeats = mesh.findRepeatedSlices(zs, REPEATED_LAYER_TOLERANCE, sameAs);
+        printf("Found %d layers identical to the one below.\n", repeats);
+    }
+
+    for (size_t k = 0; k < zs.size(); k++) {
+        ctx.allocSlice(zs[k]);
+        if (k < sameAs.size() && sameAs[k] != (int32_t)k) {
+            repeatedLayers[zs[k]] = zs[sameAs[k]];
+        }
+    }
+
+    map<float,CarvedSlice>::iterator it;
+    vector<Operation*> ops;
+
+    // Decode the layers that were saved, side by side.
+    if (resume) {
+        for (size_t k = 0; k < zs.size(); k++) {
+            if (sameAs[k] == (int32_t)k) {
+                ops.push_back(new CheckpointLoadOp(resume, &ctx.slices[zs[k]], k));
+            }
+        }
+        opQ.addOperations(ops);
+        opQ.waitUntilAllOperationsAreFinished();
+        for (it = ctx.slices.begin(); it != ctx.slices.end(); it++) {
+            if (!repeatedLayers.count((*it).first) && (*it).second.state == INIT) {
+                fprintf(stderr, "Error: Checkpoint layer at Z=%.4f is damaged.\n", (*it).first);
+                exit(-1);
+            }
+        }
+        stopwatch.checkpoint("Resumed from checkpoint");
+    }
+
+    // Pick layers up from wherever the stage cache leaves off.  Each
+    //  stage below skips layers that are already past it.
+    StageCache* stageCache = NULL;
+    if (!stageCacheDir.empty()) {
+        stageCache = new StageCache(stageCacheDir, ctx);
+        ops.clear();
+        for (it = ctx.slices.begin(); it != ctx.slices.end(); it++) {
+            if (repeatedLayers.count((*it).first)) {
+                continue;
+            }
+            ops.push_back(new StageLoadOp(stageCache, &(*it).second, (*it).first));
+        }
+        opQ.addOperations(ops);
+        opQ.waitUntilAllOperationsAreFinished();
+        stopwatch.checkpoint("Loaded cached stages");
+    }
+
+    // Carve model to find layer outlines.  A layer takes about as long
+    //  as the number of triangles it crosses.
+    if (bands) {
+        carveInBands(ctx, opQ, *bands, zs, sameAs, repeatedLayers);
+    }
+    vector<double> sliceZs;
+    for (it = ctx.slices.begin(); it != ctx.slices.end(); it++) {
+        sliceZs.push_back((*it).first);
+    }
+    vector<uint32_t> crossings;
+    mesh.countCrossings(sliceZs, crossings);
+    ops.clear();
+    size_t k = 0;
+    for (it = ctx.slices.begin(); it != ctx.slices.end(); it++, k++) {
+        if (repeatedLayers.count((*it).first) || (*it).second.state >= CARVED) {
+            continue;
+        }
+        CarveOp* op = new CarveOp(&ctx, &(*it).second, (*it).first);
+        op->cost = crossings[k];
+	addStageOperation(ops, stageCache, op, &(*it).second, (*it).first);
+    }
+    opQ.addOperations(ops);
+    opQ.waitUntilAllOperationsAreFinished();
+    stopwatch.checkpoint("Carved");
+    saveCheckpoint(ctx, zs, sameAs, CARVED, stopwatch);
+
+    // Simplify each level's carved outline
+    ops.clear();
+    for (it = ctx.slices.begin(); it != ctx.slices.end(); it++) {
+        if (repeatedLayers.count((*it).first) || (*it).second.state >= SIMPLIFIED) {
+            continue;
+        }
+        SimplifyOp* op = new SimplifyOp(&ctx, &(*it).second, (*it).first);
+        op->cost = (*it).second.perimeter.get().segmentCount();
+	addStageOperation(ops, stageCache, op, &(*it).second, (*it).first);
+    }
+    opQ.addOperations(ops);
+    opQ.waitUntilAllOperationsAreFinished();
+    stopwatch.checkpoint("Simplified");
+    saveCheckpoint(ctx, zs, sameAs, SIMPLIFIED, stopwatch);
+
+    // Inset each level's carved region
+    ops.clear();
+    for (it = ctx.slices.begin(); it != ctx.slices.end(); it++) {
+        if (repeatedLayers.count((*it).first) || (*it).second.state >= INSET) {
+            continue;
+        }
+        InsetOp* op = new InsetOp(&ctx, &(*it).second, (*it).first);
+        op->cost = (*it).second.perimeter.get().segmentCount();
+	addStageOperation(ops, stageCache, op, &(*it).second, (*it).first);
+    }
+    opQ.addOperations(ops);
+    opQ.waitUntilAllOperationsAreFinished();
+    stopwatch.checkpoint("Inset");
+    saveCheckpoint(ctx, zs, sameAs, INSET, stopwatch);
+    
+    // Infill each level's carved region
+    ops.clear();
+    for (it = ctx.slices.begin(); it != ctx.slices.end(); it++) {
+        if (repeatedLayers.count((*it).first) || (*it).second.state >= INFILLED) {
+            continue;
+        }
+        InfillOp* op = new InfillOp(&ctx, &(*it).second, (*it).first, &opQ);
+        op->cost = infillCost(ctx, (*it).second);
+	addStageOperation(ops, stageCache, op, &(*it).second, (*it).first);
+    }
+    opQ.addOperations(ops);
+    opQ.waitUntilAllOperationsAreFinished();
+    stopwatch.checkpoint("Infilled");
+    saveCheckpoint(ctx, zs, sameAs, INFILLED, stopwatch);
+    delete stageCache;
+
+    // Fill in the repeated layers from the layers they repeat.
+    map<float,float>::iterator rit;
+    for (rit = repeatedLayers.begin(); rit != repeatedLayers.end(); rit++) {
+        ctx.slices[(*rit).first].reuseGeometryFrom(ctx.slices[(*rit).second]);
+    }
+}
+
+
+
 int main (int argc, char * const argv[])
 {
     Stopwatch stopwatch;
@@ -62,7 +629,7 @@ int main (int argc, char * const argv[])
 
     int ch;
     const char *progName = argv[0];
-    const char * shortopts = "?cd:f:F:hi:l:m:o:p:r:s:t:w:Z:";
+    const char * shortopts = "?A:b:cC:Dd:E:f:F:Ghi:I:K:l:m:No:O:p:P:r:R:s:S:t:T:U:V:w:W:XZ:";
     static struct option longopts[] = {
 	{"material", required_argument, NULL, 'm'},
 	{"diameter", required_argument, NULL, 'f'},
@@ -70,13 +637,31 @@ int main (int argc, char * const argv[])
 	{"infill", required_argument, NULL, 'i'},
 	{"layer", required_argument, NULL, 'l'},
 	{"shells", required_argument, NULL, 'p'},
+	{"resolution", required_argument, NULL, 'R'},
 	{"ratio", required_argument, NULL, 'w'},
 	{"nocenter", required_argument, NULL, 'c'},
+	{"noreuse", no_argument, NULL, 'D'},
+	{"progressive", no_argument, NULL, 'G'},
 	{"scale", required_argument, NULL, 's'},
 	{"rotatex", required_argument, NULL, 'r'},
 	{"onlyatz", required_argument, NULL, 'Z'},
 	{"dumpprefix", required_argument, NULL, 'd'},
 	{"threads", required_argument, NULL, 't'},
+	{"instance", required_argument, NULL, 'I'},
+	{"batch", required_argument, NULL, 'b'},
+	{"serve", required_argument, NULL, 'S'},
+	{"meshcache", required_argument, NULL, 'C'},
+	{"stagecache", required_argument, NULL, 'K'},
+	{"save-after", required_argument, NULL, 'A'},
+	{"resume-from", required_argument, NULL, 'U'},
+	{"outofcore", required_argument, NULL, 'O'},
+	{"workers", required_argument, NULL, 'W'},
+	{"worker-command", required_argument, NULL, 'E'},
+	{"worker", no_argument, NULL, 'X'},
+	{"preview", required_argument, NULL, 'P'},
+	{"cpu-features", required_argument, NULL, 'V'},
+	{"numa", no_argument, NULL, 'N'},
+	{"deadline", required_argument, NULL, 'T'},
 	{0, 0, 0, 0}
     };
     
@@ -95,9 +680,30 @@ int main (int argc, char * const argv[])
     optreset = opterr = optind = 1;
     while ((ch = getopt_long(argc, argv, shortopts, longopts, NULL)) != -1) {
         switch (ch) {
+        case 'A':
+            if (!parseSaveAfter(optarg)) {
+                fprintf(stderr, "Error: Bad stage '%s'.  Expected carve, simplify, inset or infill, then maybe :FILE\n", optarg);
+                usage(progName, ctx);
+            }
+            break;
+        case 'b':
+            batchManifest = optarg;
+            break;
         case 'c':
             doCenter = false;
             break;
+        case 'C':
+            meshCacheDir = optarg;
+            break;
+        case 'K':
+            stageCacheDir = optarg;
+            break;
+        case 'D':
+            doReuse = false;
+            break;
+        case 'G':
+            doProgressive = true;
+            break;
         case 'd':
             doDumpSVG = true;
             ctx.dumpPrefix = optarg;
@@ -117,6 +723,9 @@ int main (int argc, char * const argv[])
         case 'p':
             ctx.perimeterShells = atoi(optarg);
             break;
+        case 'R':
+            ctx.simplifyResolution = atof(optarg);
+            break;
         case 'w':
             ctx.widthOverHeightRatio = atof(optarg);
             break;
@@ -126,6 +735,51 @@ int main (int argc, char * const argv[])
         case 's':
             scaling = atof(optarg);
             break;
+        case 'S':
+            serveSocket = optarg;
+            break;
+        case 'U':
+            resumeFrom = optarg;
+            break;
+        case 'O':
+            outOfCoreDir = optarg;
+            break;
+        case 'W':
+            workerCount = atoi(optarg);
+            if (workerCount < 1) {
+                fprintf(stderr, "Error: Worker count cannot be less than 1.\n");
+                usage(progName, ctx);
+            }
+            break;
+        case 'E':
+            workerCommand = optarg;
+            break;
+        case 'X':
+            isWorker = true;
+            break;
+        case 'P':
+            previewFile = optarg;
+            break;
+        case 'V': {
+            unsigned features = 0;
+            if (!BGL::parseCpuFeatures(optarg, features)) {
+                fprintf(stderr, "Error: Bad CPU features '%s'.  Expected a list of sse2, avx2 and avx512, or none.\n", optarg);
+                usage(progName, ctx);
+            }
+            BGL::limitCpuFeatures(features);
+            cpuFeatureList = optarg;
+        }
+            break;
+        case 'N':
+            doPinThreads = true;
+            break;
+        case 'T':
+            jobDeadline = atof(optarg);
+            if (jobDeadline <= 0.0) {
+                fprintf(stderr, "Error: Deadline must be more than 0 seconds.\n");
+                usage(progName, ctx);
+            }
+            break;
         case 't': {
             int cnt = atoi(optarg);
             if (cnt < 1) {
@@ -137,6 +791,12 @@ int main (int argc, char * const argv[])
         case 'Z':
             onlyAtZ = atof(optarg);
             break;
+        case 'I':
+            if (!parseInstance(optarg)) {
+                fprintf(stderr, "Error: Bad instance '%s'.  Expected [FILE:]X,Y[,DEG]\n", optarg);
+                usage(progName, ctx);
+            }
+            break;
         case 'm':
             // We already parsed this one out.  Ignore.
             break;
@@ -148,98 +808,260 @@ int main (int argc, char * const argv[])
     }
     argc -= optind;
     argv += optind;
+
+    if ((batchManifest || serveSocket) && !instances.empty()) {
+        fprintf(stderr, "Error: Can't place instances in batch or server mode.\n");
+        usage(progName, ctx);
+    }
+    if ((batchManifest || serveSocket) && (saveAfter != INIT || resumeFrom)) {
+        fprintf(stderr, "Error: Can't save or resume checkpoints in batch or server mode.\n");
+        usage(progName, ctx);
+    }
+    if (jobDeadline > 0.0 && !batchManifest && !serveSocket && !isWorker && workerCount == 0) {
+        fprintf(stderr, "Error: Deadlines only apply to batch, server and worker jobs.\n");
+        usage(progName, ctx);
+    }
+    if (resumeFrom && !stageCacheDir.empty()) {
+        fprintf(stderr, "Error: Can't use a stage cache when resuming from a checkpoint.\n");
+        usage(progName, ctx);
+    }
+    if (!outOfCoreDir.empty() && (batchManifest || serveSocket || resumeFrom || !meshCacheDir.empty() || !stageCacheDir.empty())) {
+        fprintf(stderr, "Error: Out of core slicing can't be used with batches, servers, checkpoints, or caches.\n");
+        usage(progName, ctx);
+    }
+
+    // Set up Operations Queue and threadpool.  Whole-mesh passes, such
+    //  as loading and moving models, are spread across it too.
+    OpQueue opQ;
+    opQ.setPinning(doPinThreads);
+    opQ.setMaxConcurrentOperationCount(threadcount);
+    BGL::Executor::setCurrent(&opQ);
+
+    if (isWorker) {
+        // Replies go out on the real stdout.  Anything else printed
+        //  goes to stderr, so it can't get mixed in with them.
+        int replyFd = dup(STDOUT_FILENO);
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+        SliceWorker worker(jobDefaults(ctx), &opQ);
+        return worker.serve(STDIN_FILENO, replyFd) ? 1 : 0;
+    }
+    if (workerCount > 0 && (batchManifest || serveSocket || resumeFrom || saveAfter != INIT ||
+                            !outOfCoreDir.empty() || !stageCacheDir.empty())) {
+        fprintf(stderr, "Error: Workers can't be used with batches, servers, checkpoints, out of core slicing, or stage caches.\n");
+        usage(progName, ctx);
+    }
+
+    if (previewFile && (batchManifest || serveSocket || resumeFrom || saveAfter != INIT || workerCount > 0 ||
+                        !outOfCoreDir.empty() || !stageCacheDir.empty() || doDumpSVG)) {
+        fprintf(stderr, "Error: Previews can't be used with batches, servers, checkpoints, workers, out of core slicing,\n");
+        fprintf(stderr, "       stage caches, or SVG dumps.  Give -P a FILE ending in .svg for SVG.\n");
+        usage(progName, ctx);
+    }
+    // A preview on stdout goes out on the real stdout, and anything
+    //  else printed goes to stderr.
+    FILE* previewOut = NULL;
+    if (previewFile && string(previewFile) == "-") {
+        previewOut = fdopen(dup(STDOUT_FILENO), "wb");
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+    }
+
+    if (serveSocket) {
+        SliceServer server(jobDefaults(ctx), &opQ);
+        return server.serve(serveSocket) ? 1 : 0;
+    }
+
+    if (batchManifest) {
+        SliceJob defaults = jobDefaults(ctx);
+        list<SliceJob> jobs;
+        if (!SliceJob::readManifest(batchManifest, defaults, jobs)) {
+            exit(-1);
+        }
+        for (int i = 0; i < argc; i++) {
+            SliceJob job(defaults);
+            job.fileName = argv[i];
+            if (job.doDumpSVG) {
+                job.dumpUnderPrefix(ctx.dumpPrefix);
+            }
+            jobs.push_back(job);
+        }
+        stopwatch.checkpoint("Batch read");
+
+        int failures = sliceBatch(jobs, opQ, stopwatch);
+        stopwatch.finish();
+        return failures ? 1 : 0;
+    }
+
     if (argc > 0) {
         inFileName = string(argv[0]);
     }
-    if (inFileName.length() < 1) {
+    bool needInFile = instances.empty();
+    for (size_t i = 0; i < instances.size(); i++) {
+        if (instances[i].fileName.empty()) {
+            needInFile = true;
+        } else if (saveAfter != INIT || resumeFrom) {
+            fprintf(stderr, "Error: Checkpoints hold just one model.  Can't place copies of '%s'.\n", instances[i].fileName.c_str());
+            usage(progName, ctx);
+        }
+    }
+    if (resumeFrom) {
+        inFileName = resumeFrom;
+    }
+    if (needInFile && inFileName.length() < 1) {
         usage(progName, ctx);
     }
-    
-    // Load the model from the file.
-    BGL::Mesh3d &mesh = ctx.mesh;
-    mesh.loadFromSTLFile(inFileName.c_str());
-    printf("Found %d faces.\n", mesh.size());
-    stopwatch.checkpoint("Model loaded from file");
-    printf("Model Bounds = (%.2f, %.2f, %.2f) to (%.2f, %.2f, %.2f)\n", mesh.minX, mesh.minY, mesh.minZ, mesh.maxX, mesh.maxY, mesh.maxZ);
-    
-    // Scale the model if requested.
-    if (scaling != 1.0f) {
-        printf("Scaling model by %.4gx\n", scaling);
-        mesh.scale(scaling);
+    if (saveAfter != INIT && saveAfterFile.empty()) {
+        saveAfterFile = defaultCheckpointFile(inFileName);
+    }
+    if (instances.empty()) {
+        PlateInstance inst;
+        instances.push_back(inst);
     }
 
-    // Rotate the model if requested.
-    if (rotation != 0.0f) {
-        printf("Rotating model by %.4g degrees\n", rotation);
-        mesh.rotateZ(rotation*M_PI/180.0f);
+    // Each distinct model is sliced just once, however many copies of
+    //  it are on the plate.  The copies are only placed on output.
+    list<SlicingContext> models;
+    map<string, SlicingContext*> modelsByFile;
+    SliceCheckpoint checkpoint;
+    map<SlicingContext*, std::shared_ptr<MeshBands> > bandsByModel;
+    map<SlicingContext*, string> fileByModel;
+    for (size_t i = 0; i < instances.size(); i++) {
+        string fileName = instances[i].fileName.empty() ? inFileName : instances[i].fileName;
+        SlicingContext* model = modelsByFile[fileName];
+        if (!model) {
+            models.push_back(ctx);
+            model = modelsByFile[fileName] = &models.back();
+            fileByModel[model] = fileName;
+            if (resumeFrom) {
+                if (!checkpoint.open(resumeFrom)) {
+                    fprintf(stderr, "Error: Couldn't read checkpoint from '%s'.\n", resumeFrom);
+                    exit(-1);
+                }
+                checkpoint.applyTo(*model);
+                printf("Found %d layers in %s\n", (int)checkpoint.layerCount(), resumeFrom);
+                stopwatch.checkpoint("Checkpoint opened");
+            } else if (!outOfCoreDir.empty()) {
+                bandsByModel[model] = std::make_shared<MeshBands>(outOfCoreDir);
+                spillModel(*model, *bandsByModel[model], fileName, stopwatch);
+            } else {
+                loadModel(*model, fileName, stopwatch);
+            }
+        }
+        model->instances.push_back(instances[i].placement);
     }
 
-    // Center the model.
-    if (doCenter) {
-        printf("Centering model on X=0, Y=0  Placing bottom at Z=0.\n");
-        mesh.translateToCenterOfPlatform();
-    }    
-    
-    if (scaling != 1.0f || rotation != 0.0f || doCenter) {
-	printf("New Bounds = (%.2f, %.2f, %.2f) to (%.2f, %.2f, %.2f)\n", mesh.minX, mesh.minY, mesh.minZ, mesh.maxX, mesh.maxY, mesh.maxZ);
-        stopwatch.checkpoint("Transformed");
+    // A lone copy that isn't moved is drawn as is.
+    if (models.size() == 1 && models.front().instances.size() == 1 && models.front().instances.front().isIdentity()) {
+        models.front().instances.clear();
     }
-    
-    // Recalculate SVG offsets.
-    ctx.calculateSvgOffsets();
-    
-    // Calculate first and last layer Zs
-    printf("Layer Thickness=%.4g\n", ctx.layerThickness);
-    float z = ctx.layerThickness/2.0f;
-    float topZ = mesh.maxZ;
-    if (onlyAtZ > 0.0f) {
-        z = onlyAtZ;
-        topZ = onlyAtZ + ctx.layerThickness / 2.0f;
+
+    // Recalculate SVG offsets to fit every copy on the plate.
+    double minX = 9e9, minY = 9e9, maxX = -9e9, maxY = -9e9;
+    list<SlicingContext>::iterator mit;
+    for (mit = models.begin(); mit != models.end(); mit++) {
+        Mesh3d &mesh = mit->mesh;
+        vector<Affine> placements(mit->instances);
+        if (placements.empty()) {
+            placements.push_back(Affine());
+        }
+        for (size_t i = 0; i < placements.size(); i++) {
+            double cx[4] = { mesh.minX, mesh.maxX, mesh.maxX, mesh.minX };
+            double cy[4] = { mesh.minY, mesh.minY, mesh.maxY, mesh.maxY };
+            for (int j = 0; j < 4; j++) {
+                placements[i].transformPoint(cx[j], cy[j]);
+                minX = min(minX, cx[j]);
+                minY = min(minY, cy[j]);
+                maxX = max(maxX, cx[j]);
+                maxY = max(maxY, cy[j]);
+            }
+        }
     }
-    
-    // Set up Operations Queue and threadpool.
-    OpQueue opQ;
-    opQ.setMaxConcurrentOperationCount(threadcount);
+    SlicingContext &plate = models.front();
+    plate.calculateSvgOffsets(minX, minY, maxX, maxY);
 
-    // Carve model to find layer outlines
-    while (z < topZ) {
-        CarveOp* op = new CarveOp(&ctx, ctx.allocSlice(z), z);
-	opQ.addOperation(op);
-        z += ctx.layerThickness;
+    // Start the workers, if any, each with a share of our threads.
+    WorkerPool pool;
+    if (workerCount > 0) {
+        char threads[16];
+        snprintf(threads, sizeof(threads), "%d", max(1, threadcount / workerCount));
+        vector<string> selfArgs;
+        selfArgs.push_back(progName);
+        selfArgs.push_back("-X");
+        selfArgs.push_back("-m");
+        selfArgs.push_back(material);
+        selfArgs.push_back("-t");
+        selfArgs.push_back(threads);
+        if (cpuFeatureList) {
+            selfArgs.push_back("-V");
+            selfArgs.push_back(cpuFeatureList);
+        }
+        if (doPinThreads) {
+            selfArgs.push_back("-N");
+        }
+        if (!pool.start(workerCount, selfArgs, workerCommand)) {
+            fprintf(stderr, "Error: Couldn't start %d workers.\n", workerCount);
+            exit(-1);
+        }
     }
-    opQ.waitUntilAllOperationsAreFinished();
-    stopwatch.checkpoint("Carved");
-    
-    map<float,CarvedSlice>::iterator it;
 
-    // Inset each level's carved region
-    for (it = ctx.slices.begin(); it != ctx.slices.end(); it++) {
-        InsetOp* op = new InsetOp(&ctx, &(*it).second, (*it).first);
-	opQ.addOperation(op);
+    for (mit = models.begin(); mit != models.end(); mit++) {
+        if (previewFile) {
+            previewModel(*mit, opQ, stopwatch);
+            continue;
+        }
+        if (workerCount > 0) {
+            farmOutModel(*mit, jobDefaults(ctx), fileByModel[&*mit], pool, stopwatch);
+            continue;
+        }
+        sliceModel(*mit, opQ, stopwatch, resumeFrom ? &checkpoint : NULL, bandsByModel[&*mit].get());
+        bandsByModel.erase(&*mit);
     }
-    opQ.waitUntilAllOperationsAreFinished();
-    stopwatch.checkpoint("Inset");
-    
-    // Infill each level's carved region
-    for (it = ctx.slices.begin(); it != ctx.slices.end(); it++) {
-        InfillOp* op = new InfillOp(&ctx, &(*it).second, (*it).first);
-	opQ.addOperation(op);
+
+    if (previewFile) {
+        SlicePreview preview(models);
+        bool ok = previewOut ? preview.writeCompact(previewOut, PREVIEW_QUANTUM) : preview.save(previewFile, plate);
+        if (!ok) {
+            fprintf(stderr, "Error: Couldn't write preview to '%s'.\n", previewFile);
+            exit(-1);
+        }
+        stopwatch.checkpoint("Saved preview");
+        stopwatch.finish();
+        return 0;
     }
-    opQ.waitUntilAllOperationsAreFinished();
-    stopwatch.checkpoint("Infilled");
     
-    // Optionally dump to SVG
+    // Optionally dump to SVG, with every copy of every model at each layer.
     if (doDumpSVG) {
-	for (it = ctx.slices.begin(); it != ctx.slices.end(); it++) {
-	    SvgDumpOp* op = new SvgDumpOp(&ctx, &(*it).second, (*it).first);
-	    opQ.addOperation(op);
+        set<float> zs;
+        map<float,CarvedSlice>::iterator it;
+        for (mit = models.begin(); mit != models.end(); mit++) {
+            for (it = mit->slices.begin(); it != mit->slices.end(); it++) {
+                zs.insert((*it).first);
+            }
+        }
+        set<float>::iterator zit;
+        vector<Operation*> ops;
+        for (zit = zs.begin(); zit != zs.end(); zit++) {
+            SvgDumpOp* op = new SvgDumpOp(&plate, *zit);
+            for (mit = models.begin(); mit != models.end(); mit++) {
+                it = mit->slices.find(*zit);
+                if (it == mit->slices.end()) {
+                    continue;
+                }
+                if (mit->instances.empty()) {
+                    op->addCopy(&(*it).second, Affine());
+                }
+                for (size_t i = 0; i < mit->instances.size(); i++) {
+                    op->addCopy(&(*it).second, mit->instances[i]);
+                }
+            }
+	    ops.push_back(op);
         }
+	opQ.addOperations(ops);
 	opQ.waitUntilAllOperationsAreFinished();
         stopwatch.checkpoint("Dumped to SVG");
     }
 
     // Find optimized path.
-    PathFinderOp* op = new PathFinderOp(&ctx);
+    PathFinderOp* op = new PathFinderOp(&plate);
     opQ.addOperation(op);
     opQ.waitUntilAllOperationsAreFinished();
     stopwatch.checkpoint("Path Optimized");
@@ -248,7 +1070,7 @@ int main (int argc, char * const argv[])
     Operation* expOp = NULL;
     switch (exportType) {
     case GCODE:
-        expOp = new GCodeExportOp(&ctx);
+        expOp = new GCodeExportOp(&plate);
         break;
     default:
         break;
@@ -0,0 +1,218 @@
+//
+//  MeshBands.cc
+//  Mandoline
+//
+//  Created by GM on 2/25/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include "MeshBands.h"
+#include "Defaults.h"
+
+
+// Triangles are read back from a band this many at a time.
+static const size_t BAND_READ_CHUNK = 4096;
+
+
+
+MeshBands::MeshBands(const string &spillDir)
+    : dir(spillDir), bandPaths(), bottomZ(0.0), bandHeight(1.0), placement(), dz(0.0), bounds()
+{
+}
+
+
+
+MeshBands::~MeshBands()
+{
+    removeSpillFiles();
+}
+
+
+
+void MeshBands::removeSpillFiles()
+{
+    for (size_t i = 0; i < bandPaths.size(); i++) {
+        unlink(bandPaths[i].c_str());
+    }
+    if (!bandPaths.empty()) {
+        rmdir(bandPaths[0].substr(0, bandPaths[0].find_last_of('/')).c_str());
+    }
+    bandPaths.clear();
+}
+
+
+
+// Which band a Z, scaled and rotated but not yet centered, falls in.
+size_t MeshBands::bandFor(double Z) const
+{
+    double band = floor((Z - bottomZ) / bandHeight);
+    if (band < 0.0) {
+        return 0;
+    }
+    if (band >= bandPaths.size()) {
+        return bandPaths.size() - 1;
+    }
+    return (size_t)band;
+}
+
+
+
+// Streams the model into bands, placed as loadModel() would place it.
+//  There are enough bands that each holds about OUT_OF_CORE_BAND_TRIANGLES.
+//  Returns the number of triangles in the model, or 0 if it couldn't
+//  be read, or the bands couldn't be written.
+int64_t MeshBands::build(const char *fileName, float scaling, float rotation, bool doCenter)
+{
+    removeSpillFiles();
+
+    // First pass, for the bounds.
+    FILE *f = fopen(fileName, "rb");
+    if (!f) {
+        return 0;
+    }
+    Mesh3d placed;
+    Triangle3d tri;
+    int64_t count = 0;
+    STLReader firstPass(f);
+    while (firstPass.next(tri)) {
+        placed.includeInBounds(tri);
+        count++;
+    }
+    fclose(f);
+    if (count == 0) {
+        return 0;
+    }
+    // The placement is put together just as Mesh3d::place() does it.
+    double rad = rotation*M_PI/180.0f;
+    Affine3d aff;
+    if (scaling != 1.0f) {
+        aff.scale(scaling, scaling, scaling);
+        placed.scale(scaling);
+    }
+    if (rotation != 0.0f) {
+        aff.rotateZAroundPoint(rad, placed.centerPoint());
+    }
+
+    int64_t bands = (count + OUT_OF_CORE_BAND_TRIANGLES - 1) / OUT_OF_CORE_BAND_TRIANGLES;
+    bands = std::min(bands, (int64_t)OUT_OF_CORE_MAX_BANDS);
+    bottomZ = placed.minZ;
+    bandHeight = (placed.maxZ - placed.minZ) / bands;
+    if (bandHeight <= 0.0) {
+        bands = 1;
+        bandHeight = 1.0;
+    }
+
+    string tmpl = dir + "/mandoline-bands-XXXXXX";
+    if (!mkdtemp(&tmpl[0])) {
+        return 0;
+    }
+    vector<FILE*> spills;
+    for (int64_t i = 0; i < bands; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "/band-%04d.tri", (int)i);
+        bandPaths.push_back(tmpl + name);
+        spills.push_back(fopen(bandPaths.back().c_str(), "wb"));
+    }
+
+    // Second pass, spilling each triangle, as read, to each band it
+    //  reaches into once scaled and rotated.  Bounds are found again
+    //  after rotating, to center by.
+    bool ok = true;
+    for (size_t i = 0; i < spills.size(); i++) {
+        ok = ok && spills[i];
+    }
+    f = ok ? fopen(fileName, "rb") : NULL;
+    ok = (f != NULL);
+    if (ok) {
+        STLReader secondPass(f);
+        if (rotation != 0.0f) {
+            placed = Mesh3d();
+        }
+        while (ok && secondPass.next(tri)) {
+            Triangle3d moved(tri);
+            aff.transformTriangle(moved);
+            if (rotation != 0.0f) {
+                placed.includeInBounds(moved);
+            }
+            double lo = fmin(moved.vertex1.z, fmin(moved.vertex2.z, moved.vertex3.z));
+            double hi = fmax(moved.vertex1.z, fmax(moved.vertex2.z, moved.vertex3.z));
+            size_t last = bandFor(hi + CLOSEENOUGH);
+            for (size_t band = bandFor(lo - CLOSEENOUGH); ok && band <= last; band++) {
+                ok = fwrite(&tri, sizeof(tri), 1, spills[band]) == 1;
+            }
+        }
+        fclose(f);
+    }
+    for (size_t i = 0; i < spills.size(); i++) {
+        if (spills[i]) {
+            ok = (fclose(spills[i]) == 0) && ok;
+        }
+    }
+    if (!ok) {
+        removeSpillFiles();
+        return 0;
+    }
+
+    // The centering is what Mesh3d::place() would add, given the
+    //  bounds after rotating.
+    dz = 0.0;
+    if (doCenter) {
+        double dx = -(placed.maxX + placed.minX) / 2.0;
+        double dy = -(placed.maxY + placed.minY) / 2.0;
+        dz = -placed.minZ;
+        aff.translate(dx, dy, dz);
+        placed.translate(dx, dy, dz);
+    }
+    placement = aff;
+    bounds = placed;
+    return count;
+}
+
+
+
+// Works out which layers fall in which band.  The layers of band b
+//  are firstInBand[b] up to, but not including, firstInBand[b+1].
+void MeshBands::splitLayers(const vector<double> &zs, vector<size_t> &firstInBand) const
+{
+    firstInBand.assign(bandCount() + 1, zs.size());
+    size_t k = 0;
+    for (size_t b = 0; b < bandCount(); b++) {
+        while (k < zs.size() && bandFor(zs[k] - dz) < b) {
+            k++;
+        }
+        firstInBand[b] = k;
+    }
+}
+
+
+
+// Loads every triangle that reaches into the given band, placed, into
+//  the mesh.  The mesh's bounds are those of the whole model.
+bool MeshBands::loadBand(size_t band, Mesh3d &mesh) const
+{
+    mesh = bounds;
+    if (band >= bandCount()) {
+        return false;
+    }
+    FILE *f = fopen(bandPaths[band].c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    vector<Triangle3d> chunk(BAND_READ_CHUNK);
+    size_t cnt;
+    while ((cnt = fread(&chunk[0], sizeof(Triangle3d), chunk.size(), f)) > 0) {
+        for (size_t i = 0; i < cnt; i++) {
+            placement.transformTriangle(chunk[i]);
+            mesh.triangles.push_back(chunk[i]);
+        }
+    }
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+
@@ -0,0 +1,64 @@
+//
+//  MeshBands.h
+//  Mandoline
+//
+//  Created by GM on 2/25/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef MESHBANDS_H
+#define MESHBANDS_H
+
+#include <string>
+#include <vector>
+#include "BGL/BGL.h"
+
+using namespace std;
+using namespace BGL;
+
+
+// A model too big to hold in memory, split into Z-bands spilled to
+//  disk.  Each band's file holds every triangle that overlaps it once
+//  placed, so a band can be loaded, carved and let go of in turn, and
+//  only one band is ever in memory.
+//
+// The STL is streamed through twice: once to find its bounds, and once
+//  to find which bands each triangle spans once scaled and rotated,
+//  and write it to them as read.  The whole placement, centering and
+//  all, is done when a band is loaded, as centering depends on the
+//  bounds after rotating.  It's put together just as Mesh3d::place()
+//  does it, so the triangles come out exactly the same, and slicing
+//  by bands gives the same layers as slicing the whole model.
+class MeshBands {
+private:
+    string dir;
+    vector<string> bandPaths;
+    double bottomZ;
+    double bandHeight;
+    // How the model is placed once loaded, and how far that moves it
+    //  up or down.
+    Affine3d placement;
+    double dz;
+    // Just the bounds of the whole model, placed.
+    Mesh3d bounds;
+
+    size_t bandFor(double Z) const;
+    void removeSpillFiles();
+
+    // Not copyable, as it owns the spill files.
+    MeshBands(const MeshBands &);
+    MeshBands& operator=(const MeshBands &);
+
+public:
+    MeshBands(const string &spillDir);
+    ~MeshBands();
+
+    int64_t build(const char *fileName, float scaling, float rotation, bool doCenter);
+    size_t bandCount() const { return bandPaths.size(); }
+    const Mesh3d& modelBounds() const { return bounds; }
+    void splitLayers(const vector<double> &zs, vector<size_t> &firstInBand) const;
+    bool loadBand(size_t band, Mesh3d &mesh) const;
+};
+
+#endif
+
@@ -0,0 +1,174 @@
+//
+//  MeshCache.cc
+//  Mandoline
+//
+//  Created by GM on 2/22/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "MeshCache.h"
+
+
+
+MeshCache::MeshCache(size_t maxMeshes)
+    : entries(), maxEntries(maxMeshes), useClock(0)
+{
+    pthread_mutex_init(&theMutex, 0);
+}
+
+
+
+MeshCache::~MeshCache()
+{
+    pthread_mutex_destroy(&theMutex);
+}
+
+
+
+bool MeshCache::fetch(const string &key, Mesh3d &outMesh)
+{
+    pthread_mutex_lock(&theMutex);
+    map<string, Entry>::iterator it = entries.find(key);
+    bool found = (it != entries.end());
+    if (found) {
+        it->second.lastUsed = ++useClock;
+        outMesh = it->second.mesh;
+    }
+    pthread_mutex_unlock(&theMutex);
+    return found;
+}
+
+
+
+void MeshCache::store(const string &key, const Mesh3d &mesh)
+{
+    if (maxEntries == 0) {
+        return;
+    }
+    pthread_mutex_lock(&theMutex);
+    while (entries.size() >= maxEntries) {
+        map<string, Entry>::iterator oldest = entries.begin();
+        map<string, Entry>::iterator it;
+        for (it = entries.begin(); it != entries.end(); it++) {
+            if (it->second.lastUsed < oldest->second.lastUsed) {
+                oldest = it;
+            }
+        }
+        entries.erase(oldest);
+    }
+    Entry &entry = entries[key];
+    entry.mesh = mesh;
+    entry.lastUsed = ++useClock;
+    pthread_mutex_unlock(&theMutex);
+}
+
+
+
+// Fills in outMesh with the model in the given STL file.  Returns
+//  false if it couldn't be read.
+bool MeshCache::loadFile(const string &fileName, Mesh3d &outMesh)
+{
+    struct stat st;
+    if (stat(fileName.c_str(), &st) != 0) {
+        return false;
+    }
+    char key[1024];
+    snprintf(key, sizeof(key), "file:%lld:%lld:%.900s",
+             (long long)st.st_size, (long long)st.st_mtime, fileName.c_str());
+    if (fetch(key, outMesh)) {
+        return true;
+    }
+    if (outMesh.loadFromSTLFile(fileName.c_str()) < 1) {
+        return false;
+    }
+    store(key, outMesh);
+    return true;
+}
+
+
+
+// Fills in outMesh with the model in a buffer of STL data.  Returns
+//  false if it couldn't be read.
+bool MeshCache::loadData(const string &stlData, Mesh3d &outMesh)
+{
+    // FNV-1a hash of the contents, with the length to make
+    //  collisions that much less likely.
+    uint64_t hash = fnv1a(stlData.data(), stlData.size());
+    char key[64];
+    snprintf(key, sizeof(key), "data:%lld:%016llx", (long long)stlData.size(), (unsigned long long)hash);
+    if (fetch(key, outMesh)) {
+        return true;
+    }
+
+    FILE *f = tmpfile();
+    if (!f) {
+        return false;
+    }
+    size_t written = fwrite(stlData.data(), 1, stlData.size(), f);
+    rewind(f);
+    int32_t faces = (written == stlData.size()) ? outMesh.loadFromSTLStream(f) : 0;
+    fclose(f);
+    if (faces < 1) {
+        return false;
+    }
+    store(key, outMesh);
+    return true;
+}
+
+
+
+// Finds where the given model, prepared with the given transforms,
+//  goes in the on-disk cache in dir.  It's named for a hash of the
+//  file's contents, so a model is found again even if it's been moved
+//  or copied, and an edited model never is.  Returns an empty string
+//  if the model file can't be read.
+string MeshCache::preparedCachePath(const string &dir, const string &fileName, float scaling, float rotation, bool doCenter)
+{
+    FILE *f = fopen(fileName.c_str(), "rb");
+    if (!f) {
+        return "";
+    }
+    uint64_t hash = FNV_OFFSET_BASIS;
+    char buf[65536];
+    size_t cnt;
+    while ((cnt = fread(buf, 1, sizeof(buf), f)) > 0) {
+        hash = fnv1a(buf, cnt, hash);
+    }
+    bool ok = !ferror(f);
+    fclose(f);
+    if (!ok) {
+        return "";
+    }
+
+    char params[128];
+    snprintf(params, sizeof(params), "s%.9g:r%.9g:c%d", scaling, rotation, doCenter ? 1 : 0);
+    char name[64];
+    snprintf(name, sizeof(name), "/%016llx-%08x.bglmesh",
+             (unsigned long long)hash, (unsigned)fnv1a(params, strlen(params)));
+    return dir + name;
+}
+
+
+
+// Loads a prepared model from the on-disk cache.  Returns false if
+//  it isn't there yet.
+bool MeshCache::loadPrepared(const string &cachePath, Mesh3d &outMesh)
+{
+    return outMesh.loadFromCacheFile(cachePath.c_str());
+}
+
+
+
+// Adds a prepared model to the on-disk cache.  Failures are only
+//  reported, since the cache is just a shortcut.
+void MeshCache::savePrepared(const string &cachePath, const Mesh3d &mesh)
+{
+    if (!mesh.saveToCacheFile(cachePath.c_str())) {
+        fprintf(stderr, "Warning: Couldn't save model to cache file '%s'.\n", cachePath.c_str());
+    }
+}
+
+
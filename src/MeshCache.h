@@ -0,0 +1,62 @@
+//
+//  MeshCache.h
+//  Mandoline
+//
+//  Created by GM on 2/22/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <map>
+#include <string>
+#include <pthread.h>
+#include "BGL/BGL.h"
+#include "Defaults.h"
+
+using namespace std;
+using namespace BGL;
+
+
+// Keeps recently loaded models in memory, as they were before being
+//  scaled, rotated or centered, so that slicing the same model again
+//  only has to copy it.  Files are known by path, size and modification
+//  time, and models sent as data by their contents.  The least recently
+//  used model is dropped when the cache is full.  Thread-safe.
+class MeshCache {
+private:
+    struct Entry {
+        Mesh3d mesh;
+        unsigned long lastUsed;
+    };
+
+    map<string, Entry> entries;
+    size_t maxEntries;
+    unsigned long useClock;
+    pthread_mutex_t theMutex;
+
+    // Can't be copied.
+    MeshCache(const MeshCache&);
+    MeshCache& operator=(const MeshCache&);
+
+    bool fetch(const string &key, Mesh3d &outMesh);
+    void store(const string &key, const Mesh3d &mesh);
+
+public:
+    MeshCache(size_t maxMeshes = DEFAULT_MESH_CACHE_SIZE);
+    ~MeshCache();
+
+    bool loadFile(const string &fileName, Mesh3d &outMesh);
+    bool loadData(const string &stlData, Mesh3d &outMesh);
+
+    // The on-disk cache holds models as they are after being loaded,
+    //  scaled, rotated and centered, so they're ready to slice.  It's
+    //  shared by every run that's pointed at the same directory.
+    static string preparedCachePath(const string &dir, const string &fileName, float scaling, float rotation, bool doCenter);
+    static bool loadPrepared(const string &cachePath, Mesh3d &outMesh);
+    static void savePrepared(const string &cachePath, const Mesh3d &mesh);
+};
+
+#endif
+
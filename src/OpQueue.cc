@@ -1,10 +1,228 @@
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include "Defaults.h"
+#include "CpuNodes.h"
 #include "OpQueue.h"
 #include "OpThread.h"
 #include "Operation.h"
 
 
 
-OpQueue::OpQueue() : pending(), max_threads(16)
+// The runs of one parallelFor(), handed out one at a time to whichever
+//  threads come asking, the caller's own included.  Helpers that come
+//  asking after they're all handed out just go away, so this outlives
+//  the call until they do.  The body is only used while runs are left,
+//  and so while the caller is still waiting on them.  The same goes for
+//  the caller's cancel scope, which helpers carry on in, and once it's
+//  cancelled the rest of the runs are skipped.
+class RangeRuns {
+private:
+    pthread_mutex_t theMutex;
+    pthread_cond_t theCond;
+    size_t begin, end, grain;
+    size_t nextRun, runCount, runsDone;
+    const std::function<void(size_t, size_t)> *body;
+    const BGL::CancelScope *callerScope;
+
+public:
+    RangeRuns(size_t b, size_t e, size_t g, const std::function<void(size_t, size_t)> *bdy)
+        : begin(b), end(e), grain(g), nextRun(0), runCount((e - b + g - 1) / g), runsDone(0), body(bdy),
+          callerScope(BGL::CancelScope::current())
+    {
+        pthread_mutex_init(&theMutex, 0);
+        pthread_cond_init(&theCond, 0);
+    }
+    ~RangeRuns() {
+        pthread_mutex_destroy(&theMutex);
+        pthread_cond_destroy(&theCond);
+    }
+
+    size_t count() const { return runCount; }
+
+    // Does the next run not yet handed out.  Returns false if there
+    //  were none left.
+    bool doNext() {
+        pthread_mutex_lock(&theMutex);
+        size_t r = nextRun;
+        if (r < runCount) {
+            nextRun++;
+        }
+        pthread_mutex_unlock(&theMutex);
+        if (r >= runCount) {
+            return false;
+        }
+
+        size_t first = begin + r * grain;
+        size_t last = (end - first > grain) ? first + grain : end;
+        if (!callerScope || !callerScope->isCancelled()) {
+            BGL::CancelScope scope(NULL, callerScope);
+            (*body)(first, last);
+        }
+
+        pthread_mutex_lock(&theMutex);
+        runsDone++;
+        pthread_cond_broadcast(&theCond);
+        pthread_mutex_unlock(&theMutex);
+        return true;
+    }
+
+    void waitUntilAllAreDone() {
+        pthread_mutex_lock(&theMutex);
+        while (runsDone < runCount) {
+            pthread_cond_wait(&theCond, &theMutex);
+        }
+        pthread_mutex_unlock(&theMutex);
+    }
+};
+
+
+
+// Helps a parallelFor() with its runs.  Helpers go ahead of everything
+//  else pending, as the op that called parallelFor() is already running,
+//  and holding up a thread until they're done.
+class RangeOp : public Operation {
+public:
+    std::shared_ptr<RangeRuns> runs;
+
+    RangeOp(const std::shared_ptr<RangeRuns> &rns) : Operation(), runs(rns) {
+        cost = HUGE_VAL;
+    }
+    virtual ~RangeOp() {}
+    virtual void main() {
+        if ( isCancelled() ) return;
+        while (runs->doNext()) {
+        }
+    }
+};
+
+
+
+// A stage's worth of operations, handed out in blocks to whichever
+//  helpers come asking, so they go through the queue a helper at a time
+//  instead of one at a time.  Each block is sized from how long the ops
+//  done so far took, to take about OP_BLOCK_MSEC, and per unit of cost
+//  when they have one.  Blocks stay small enough near the end to leave
+//  every helper a share.  Ops are deleted as they're done, and any never
+//  handed out are deleted with the blocks.
+//
+// With threads pinned to NUMA nodes, the ops are split into a part for
+//  each node, and helpers take from their own node's part first, and
+//  only then from the others.
+class OpBlocks {
+private:
+    struct Part {
+        std::vector<Operation*> ops;
+        size_t nextOp;
+    };
+
+    pthread_mutex_t theMutex;
+    std::vector<Part> parts;
+    size_t helpers;
+    size_t opsDone;
+    double costDone, secondsTaken;
+
+    double predictedSeconds(const Operation *op) const {
+        if (op->cost > 0.0 && costDone > 0.0) {
+            return op->cost * secondsTaken / costDone;
+        }
+        return secondsTaken / opsDone;
+    }
+
+public:
+    OpBlocks(const std::vector<std::vector<Operation*> > &p, size_t h)
+        : parts(p.size()), helpers(h), opsDone(0), costDone(0.0), secondsTaken(0.0)
+    {
+        for (size_t i = 0; i < p.size(); i++) {
+            parts[i].ops = p[i];
+            parts[i].nextOp = 0;
+        }
+        helpers = std::max((size_t)1, helpers / parts.size());
+        pthread_mutex_init(&theMutex, 0);
+    }
+    ~OpBlocks() {
+        for (size_t p = 0; p < parts.size(); p++) {
+            for (size_t i = parts[p].nextOp; i < parts[p].ops.size(); i++) {
+                delete parts[p].ops[i];
+            }
+        }
+        pthread_mutex_destroy(&theMutex);
+    }
+
+    // Does the next block of ops not yet handed out.  Returns false if
+    //  there were none left.
+    bool doNext() {
+        pthread_mutex_lock(&theMutex);
+        size_t home = OpThread::currentNode() % parts.size();
+        Part *part = &parts[home];
+        for (size_t k = 1; k < parts.size() && part->nextOp >= part->ops.size(); k++) {
+            part = &parts[(home + k) % parts.size()];
+        }
+        std::vector<Operation*> &ops = part->ops;
+        size_t first = part->nextOp;
+        size_t last = first;
+        if (first < ops.size()) {
+            last++;
+            if (opsDone > 0) {
+                size_t most = std::max((size_t)1, (ops.size() - first) / (2 * helpers));
+                double budget = OP_BLOCK_MSEC / 1000.0;
+                double predicted = predictedSeconds(ops[first]);
+                while (last < ops.size() && last - first < most) {
+                    predicted += predictedSeconds(ops[last]);
+                    if (predicted > budget) {
+                        break;
+                    }
+                    last++;
+                }
+            }
+        }
+        part->nextOp = last;
+        pthread_mutex_unlock(&theMutex);
+        if (first == last) {
+            return false;
+        }
+
+        double cost = 0.0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t i = first; i < last; i++) {
+            BGL::CancelScope scope(&ops[i]->cancellation);
+            ops[i]->main();
+            cost += ops[i]->cost;
+            delete ops[i];
+        }
+        std::chrono::duration<double> taken = std::chrono::steady_clock::now() - start;
+
+        pthread_mutex_lock(&theMutex);
+        opsDone += last - first;
+        costDone += cost;
+        secondsTaken += taken.count();
+        pthread_mutex_unlock(&theMutex);
+        return true;
+    }
+};
+
+
+
+// Helps work through some OpBlocks.  Once cancelled, the ops it hands
+//  out are too, so they're drained without doing their work.
+class BlockOp : public Operation {
+public:
+    std::shared_ptr<OpBlocks> blocks;
+
+    BlockOp(const std::shared_ptr<OpBlocks> &blks, double cst) : Operation(), blocks(blks) {
+        cost = cst;
+    }
+    virtual ~BlockOp() {}
+    virtual void main() {
+        while (blocks->doNext()) {
+        }
+    }
+};
+
+
+
+OpQueue::OpQueue() : pending(), max_threads(16), liveThreads(0), finishing(0), pinning(false)
 {
     pthread_mutex_init(&theMutex, 0);
     pthread_cond_init(&theCond, 0);
@@ -12,53 +230,107 @@ OpQueue::OpQueue() : pending(), max_threads(16)
 
 
 
+// Threads wait on our condition, which can't be destroyed under them,
+//  so they're all asked to finish up, and waited for.  They finish the
+//  ops they're running first, but anything still pending is dropped.
 OpQueue::~OpQueue()
 {
+    pthread_mutex_lock(&theMutex);
+    std::list<OpThread*>::iterator it;
+    for (it = threadpool.begin(); it != threadpool.end(); it++) {
+        (*it)->requestTermination();
+    }
+    threadpool.clear();
+    pthread_cond_broadcast(&theCond);
+    while (liveThreads > 0) {
+        pthread_cond_wait(&theCond, &theMutex);
+    }
+    std::multimap<double, Operation*, std::greater<double> >::iterator pit;
+    for (pit = pending.begin(); pit != pending.end(); pit++) {
+        delete pit->second;
+    }
+    pending.clear();
+    pthread_mutex_unlock(&theMutex);
+
     pthread_mutex_destroy(&theMutex);
     pthread_cond_destroy(&theCond);
 }
 
 
 
+// Threads are only asked to terminate with the mutex held, so one
+//  can't be missed between checking and waiting.  Returns NULL to a
+//  thread that should stop.
 Operation* OpQueue::waitForOperation(OpThread* th)
 {
     Operation* op = NULL;
-    bool isStopping = false;
 
     pthread_mutex_lock(&theMutex);
-    while(!isStopping && pending.size() == 0) {
+    while(!th->isTerminating() && pending.size() == 0) {
 	pthread_cond_wait(&theCond, &theMutex);
-	isStopping = (th->getStatus() == STOPPING);
     }
-    if (!isStopping) {
-	op = pending.front();
-	pending.pop_front();
+    if (!th->isTerminating()) {
+	op = pending.begin()->second;
+	pending.erase(pending.begin());
+	running.push_back(op);
     }
-    running.push_back(op);
     pthread_mutex_unlock(&theMutex);
     return op;
 }
 
 
 
+// The op is only deleted once it's off the running list, where
+//  cancelAll() can't get at it any more.  It's still counted until
+//  then, so nobody waiting sees the queue empty too soon.
 void OpQueue::operationFinished(Operation* op)
 {
     pthread_mutex_lock(&theMutex);
     running.remove(op);
+    finishing++;
+    pthread_mutex_unlock(&theMutex);
+    delete op;
+    pthread_mutex_lock(&theMutex);
+    finishing--;
+    pthread_cond_broadcast(&theCond);
+    pthread_mutex_unlock(&theMutex);
+}
+
+
+
+void OpQueue::threadExited()
+{
+    pthread_mutex_lock(&theMutex);
+    liveThreads--;
     pthread_cond_broadcast(&theCond);
     pthread_mutex_unlock(&theMutex);
 }
 
 
 
+// Operations may add more operations, so this can be called from the
+//  worker threads as well as the main thread.  New threads block in
+//  waitForOperation() until the mutex is let go.
 void OpQueue::growOrPrunePool()
 {
     OpThread* mythread;
 
-    // If threadpool is too small, spawn some threads.
+    pthread_mutex_lock(&theMutex);
+
+    // If threadpool is too small, spawn some threads.  Pinned ones are
+    //  dealt out a node at a time, so each node gets its share.
     while (threadpool.size() < max_threads) {
-	mythread = new OpThread(this);
+	if (pinning) {
+	    const CpuNodes &nodes = CpuNodes::system();
+	    int slot = threadpool.size();
+	    int node = slot % nodes.nodeCount();
+	    const std::vector<int> &cpus = nodes.cpusOfNode(node);
+	    mythread = new OpThread(this, cpus[(slot / nodes.nodeCount()) % cpus.size()], node);
+	} else {
+	    mythread = new OpThread(this);
+	}
 	threadpool.push_back(mythread);
+	liveThreads++;
     }
 
     // If threadpool is too big, ask some threads to terminate
@@ -72,10 +344,9 @@ void OpQueue::growOrPrunePool()
     }
     // Let terminated threads wake up so they can finish.
     if (didChange) {
-	pthread_mutex_lock(&theMutex);
 	pthread_cond_broadcast(&theCond);
-	pthread_mutex_unlock(&theMutex);
     }
+    pthread_mutex_unlock(&theMutex);
 }
 
 
@@ -83,7 +354,7 @@ void OpQueue::growOrPrunePool()
 void OpQueue::addOperation(Operation *op)
 {
     pthread_mutex_lock(&theMutex);
-    pending.push_back(op);
+    pending.insert(std::make_pair(op->cost, op));
     pthread_cond_broadcast(&theCond);
     pthread_mutex_unlock(&theMutex);
     growOrPrunePool();
@@ -91,20 +362,114 @@ void OpQueue::addOperation(Operation *op)
 
 
 
+// Adds a stage's worth of operations at once, costliest first, to be
+//  done in blocks by a helper for each thread.  When pinned, they're
+//  dealt out to the nodes in turn, in the order given, so the same
+//  layers land on the same node stage after stage, where their memory
+//  was touched.  Dealing, rather than splitting into runs, keeps each
+//  node's part in the order given too, as progressive jobs need to go
+//  coarse to fine across the whole model, not within a run of it.
+void OpQueue::addOperations(const std::vector<Operation*> &ops)
+{
+    if (ops.empty()) {
+        return;
+    }
+    size_t nodeCount = pinning ? std::min(ops.size(), (size_t)CpuNodes::system().nodeCount()) : 1;
+    std::vector<std::vector<Operation*> > parts(nodeCount);
+    double cost = 0.0;
+    for (size_t i = 0; i < ops.size(); i++) {
+        parts[i % nodeCount].push_back(ops[i]);
+    }
+    for (size_t n = 0; n < nodeCount; n++) {
+        std::stable_sort(parts[n].begin(), parts[n].end(), [](const Operation *a, const Operation *b) {
+            return a->cost > b->cost;
+        });
+        cost = std::max(cost, parts[n].front()->cost);
+    }
+    size_t helpers = std::min(ops.size(), (size_t)std::max(max_threads, (uint32_t)1));
+    std::shared_ptr<OpBlocks> blocks = std::make_shared<OpBlocks>(parts, helpers);
+
+    pthread_mutex_lock(&theMutex);
+    for (size_t i = 0; i < helpers; i++) {
+        pending.insert(std::make_pair(cost, (Operation*)new BlockOp(blocks, cost)));
+    }
+    pthread_cond_broadcast(&theCond);
+    pthread_mutex_unlock(&theMutex);
+    growOrPrunePool();
+}
+
+
+
+// A running operation may add new ones before it finishes, so
+//  we're only done once nothing is pending or running at once.
 void OpQueue::waitUntilAllOperationsAreFinished()
 {
     pthread_mutex_lock(&theMutex);
-    while(pending.size() > 0) {
+    while(pending.size() > 0 || running.size() > 0 || finishing > 0) {
 	pthread_cond_wait(&theCond, &theMutex);
     }
-    while(running.size() > 0) {
-	pthread_cond_wait(&theCond, &theMutex);
+    pthread_mutex_unlock(&theMutex);
+}
+
+
+
+// Splits the range into runs of grain, and queues up helpers to do them
+//  alongside the calling thread.  The caller does runs too, until none
+//  are left, so it never waits on helpers that are stuck in the queue
+//  behind it.  That makes it safe to call from an operation.
+void OpQueue::parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)> &body)
+{
+    if (begin >= end) {
+        return;
+    }
+    if (grain < 1) {
+        grain = 1;
+    }
+    std::shared_ptr<RangeRuns> runs = std::make_shared<RangeRuns>(begin, end, grain, &body);
+    if (runs->count() <= 1 || max_threads <= 1) {
+        body(begin, end);
+        return;
+    }
+    size_t helpers = std::min(runs->count(), (size_t)max_threads) - 1;
+    for (size_t i = 0; i < helpers; i++) {
+        addOperation(new RangeOp(runs));
+    }
+    while (runs->doNext()) {
+    }
+    runs->waitUntilAllAreDone();
+}
+
+
+
+// Cancels everything pending or running.  Pending ops still run, but
+//  only to find they're cancelled, so they can tidy up, as layers of a
+//  job count themselves done.  Running ops give up at their next check.
+//  Ops added afterwards aren't affected.
+void OpQueue::cancelAll()
+{
+    pthread_mutex_lock(&theMutex);
+    std::multimap<double, Operation*, std::greater<double> >::iterator pit;
+    for (pit = pending.begin(); pit != pending.end(); pit++) {
+        pit->second->cancel();
+    }
+    std::list<Operation*>::iterator rit;
+    for (rit = running.begin(); rit != running.end(); rit++) {
+        (*rit)->cancel();
     }
     pthread_mutex_unlock(&theMutex);
 }
 
 
 
+void OpQueue::setPinning(bool pin)
+{
+    pthread_mutex_lock(&theMutex);
+    pinning = pin;
+    pthread_mutex_unlock(&theMutex);
+}
+
+
+
 void OpQueue::setMaxConcurrentOperationCount(int maxcnt)
 {
     max_threads = maxcnt;
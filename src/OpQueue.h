@@ -2,31 +2,54 @@
 #define OPQUEUE_H
 
 #include <list>
+#include <map>
+#include <vector>
+#include <functional>
 #include <pthread.h>
+#include "BGL/BGLParallel.h"
 
 class OpThread;
 class Operation;
 
-class OpQueue {
+// Runs operations on a pool of threads.  Pending operations are started
+//  costliest first, and in the order they were added when they cost the
+//  same, so the big ones aren't left until last with the pool idling.
+//  Operations belong to the queue once added, and are deleted when
+//  they're done.  It's also a BGL::Executor, so a loop can be split into
+//  runs, and spread across the same threads.  Threads can be pinned to
+//  CPUs, grouped by NUMA node, with each node working on its own share
+//  of a stage's operations first.  Everything queued can be cancelled
+//  at once, to free up the threads for something else.
+class OpQueue : public BGL::Executor {
 private:
     std::list<OpThread*> threadpool;
     pthread_mutex_t theMutex;
     pthread_cond_t theCond;
 
     std::list<Operation*> running;
-    std::list<Operation*> pending;
+    std::multimap<double, Operation*, std::greater<double> > pending;
     uint32_t max_threads;
+    uint32_t liveThreads;
+    uint32_t finishing;
+    bool pinning;
 
 public:
     OpQueue();
     ~OpQueue();
 
     void addOperation(Operation *op);
+    void addOperations(const std::vector<Operation*> &ops);
     void waitUntilAllOperationsAreFinished();
+    void cancelAll();
     void setMaxConcurrentOperationCount(int maxcnt);
+    // Only affects threads started after, so set it before the count.
+    void setPinning(bool pin);
+    int maxConcurrentOperationCount() const { return max_threads; }
+    virtual void parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)> &body);
 
     Operation* waitForOperation(OpThread* th);
     void operationFinished(Operation* op);
+    void threadExited();
 
 private:
     void growOrPrunePool();
@@ -1,9 +1,15 @@
+#include <sched.h>
 #include "OpThread.h"
 
 
+static thread_local int threadNode = 0;
+
+
 static void* start_thread(void *obj)
 {
-    //All we do here is call the do_work() function
+    //All we do here is call the do_work() function.  Nothing joins
+    // the thread, so it's detached to be cleaned up when it's done.
+    pthread_detach(pthread_self());
     OpThread *mythread = reinterpret_cast<OpThread *>(obj);
     mythread->doWork();
     delete mythread;
@@ -12,9 +18,11 @@ static void* start_thread(void *obj)
 
 
 
-OpThread::OpThread(OpQueue* opQ)
+OpThread::OpThread(OpQueue* opQ, int onCpu, int onNode)
 {
     parent = opQ;
+    cpu = onCpu;
+    node = onNode;
     terminating = false;
     currentOp = NULL;
     status = INIT;
@@ -33,15 +41,36 @@ OpThread::~OpThread()
 
 void OpThread::doWork()
 {
+#ifdef __linux__
+    if (cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0) {
+            threadNode = node;
+        }
+    }
+#endif
     while (!terminating) {
 	setStatus(READY);
 	currentOp = parent->waitForOperation(this);
 	if (currentOp) {
 	    setStatus(BUSY);
-	    currentOp->main();
+	    {
+		BGL::CancelScope scope(&currentOp->cancellation);
+		currentOp->main();
+	    }
 	    parent->operationFinished(currentOp);
 	}
     }
+    parent->threadExited();
+}
+
+
+
+int OpThread::currentNode()
+{
+    return threadNode;
 }
 
 
@@ -21,15 +21,23 @@ private:
     Operation* currentOp;
     OpThreadStatus status;
     volatile bool terminating;
+    int cpu, node;
 
 public:
-    OpThread(OpQueue* opQ);
+    // A thread given a cpu of 0 or more is pinned to it, and counted as
+    //  on that node.
+    OpThread(OpQueue* opQ, int onCpu = -1, int onNode = 0);
     ~OpThread();
 
     OpThreadStatus getStatus();
+    bool isTerminating() const { return terminating; }
     void requestTermination();
     void doWork();
 
+    // The node of the pool thread calling, or 0 if it isn't pinned, or
+    //  isn't one.
+    static int currentNode();
+
 private:
     void setStatus(OpThreadStatus stat);
 
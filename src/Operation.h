@@ -1,13 +1,24 @@
 #ifndef OPERATION_H
 #define OPERATION_H
 
+#include "BGL/BGLCancel.h"
+
 class Operation {
 public:
-    bool isCancelled;
+    // Cancelled by cancel(), by the queue's cancelAll(), or with its
+    //  parent, such as the job it's part of.
+    BGL::Cancellation cancellation;
+    // A guess at how much work this is, in whatever units suit the
+    //  ops it's queued with.  The queue starts the costliest first.
+    double cost;
 
-    Operation() : isCancelled(false) {}
+    Operation() : cancellation(), cost(0.0) {}
     virtual ~Operation() {};
     virtual void main() = 0;
+
+    void cancel() { cancellation.cancel(); }
+    // Also true when the work this op is run as part of is cancelled.
+    bool isCancelled() const { return cancellation.isCancelled() || BGL::cancelRequested(); }
 };
 
 #endif
@@ -21,13 +21,22 @@ PathFinderOp::~PathFinderOp()
 
 void PathFinderOp::main()
 {
-    if ( isCancelled ) return;
+    if ( isCancelled() ) return;
     if ( NULL == context ) return;
 
     // TODO: join paths and optimize them
 
-    if ( isCancelled ) return;
+    if ( isCancelled() ) return;
 }
 
 
 
+// The key for this stage's output, given the key for its input.
+//  Path order doesn't depend on any settings yet, and in particular
+//  not on feed rates, which only matter on export.
+uint64_t PathFinderOp::dependencyKey(const SlicingContext &ctx, uint64_t upstream)
+{
+    return fnv1a("pathfinder", 10, upstream);
+}
+
+
@@ -23,6 +23,8 @@ public:
     }
     virtual ~PathFinderOp();
     virtual void main();
+
+    static uint64_t dependencyKey(const SlicingContext &ctx, uint64_t upstream);
 };
 
 #endif
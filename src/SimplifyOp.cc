@@ -0,0 +1,48 @@
+//
+//  SimplifyOp.cc
+//  Mandoline
+//
+//  Created by GM on 2/18/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include "SimplifyOp.h"
+#include "BGL/BGL.h"
+#include "SlicingContext.h"
+#include "CarvedSlice.h"
+
+
+
+SimplifyOp::~SimplifyOp()
+{
+}
+
+
+
+// Thins out the carved perimeter's vertices down to what the printer
+//  can actually resolve, so that every later stage has less to chew on.
+void SimplifyOp::main()
+{
+    if ( isCancelled() ) return;
+    if ( NULL == context ) return;
+    if ( NULL == slice ) return;
+
+    ArenaScope scope(slice->arena.get());
+    if (context->simplifyResolution > 0.0f) {
+        slice->perimeter.mutate().decimate(context->simplifyResolution);
+    }
+    slice->state = SIMPLIFIED;
+
+    if ( isCancelled() ) return;
+}
+
+
+
+// The key for this stage's output, given the key for its input.
+uint64_t SimplifyOp::dependencyKey(const SlicingContext &ctx, uint64_t upstream)
+{
+    uint64_t key = fnv1a("simplify", 8, upstream);
+    return fnv1aValue(ctx.simplifyResolution, key);
+}
+
+
@@ -0,0 +1,33 @@
+//
+//  SimplifyOp.h
+//  Mandoline
+//
+//  Created by GM on 2/18/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef SIMPLIFYOP_H
+#define SIMPLIFYOP_H
+
+#include "Operation.h"
+#include "SlicingContext.h"
+#include "CarvedSlice.h"
+
+class SimplifyOp : public Operation {
+public:
+    float zLayer;
+    SlicingContext* context;
+    CarvedSlice* slice;
+
+    SimplifyOp(SlicingContext* ctx, CarvedSlice* slc, float Z)
+        : Operation(), zLayer(Z), context(ctx), slice(slc)
+    {
+    }
+    virtual ~SimplifyOp();
+    virtual void main();
+
+    static uint64_t dependencyKey(const SlicingContext &ctx, uint64_t upstream);
+};
+
+#endif
+
@@ -0,0 +1,254 @@
+//
+//  SliceCheckpoint.cc
+//  Mandoline
+//
+//  Created by GM on 2/24/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "SliceCheckpoint.h"
+#include "Defaults.h"
+
+
+// The header and table are in the machine's own byte order, so they
+//  can be used straight out of the mapping.  The layer data itself is
+//  written a byte at a time, and reads back anywhere.
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t stage;
+    uint64_t byteOrder;
+    uint32_t layerCount;
+    uint32_t reserved;
+    double quantum;
+    double layerThickness;
+    double bounds[6];
+};
+
+// A layer's Z, which layer it repeats, if any, and where its data is.
+struct CheckpointLayer {
+    double z;
+    int32_t sameAs;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t length;
+};
+
+static const char CHECKPOINT_MAGIC[8] = { 'M', 'A', 'N', 'D', 'C', 'K', 'P', '\0' };
+static const uint32_t CHECKPOINT_VERSION = 1;
+static const uint64_t CHECKPOINT_BYTE_ORDER = 0x0102030405060708ULL;
+
+
+
+SliceCheckpoint::SliceCheckpoint()
+    : base(NULL), length(0), header(NULL), table(NULL)
+{
+}
+
+
+
+SliceCheckpoint::~SliceCheckpoint()
+{
+    close();
+}
+
+
+
+void SliceCheckpoint::close()
+{
+    if (base) {
+        munmap((void*)base, length);
+    }
+    base = NULL;
+    length = 0;
+    header = NULL;
+    table = NULL;
+}
+
+
+
+// Maps in a checkpoint file, and checks its header and table.  Returns
+//  false if it isn't one, or doesn't hang together.
+bool SliceCheckpoint::open(const string &path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CheckpointHeader)) {
+        ::close(fd);
+        return false;
+    }
+    size_t len = st.st_size;
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    base = (const char*)map;
+    length = len;
+
+    const CheckpointHeader *hdr = (const CheckpointHeader*)base;
+    bool ok = !memcmp(hdr->magic, CHECKPOINT_MAGIC, sizeof(hdr->magic)) &&
+              hdr->version == CHECKPOINT_VERSION &&
+              hdr->byteOrder == CHECKPOINT_BYTE_ORDER &&
+              hdr->stage >= CARVED && hdr->stage <= INFILLED &&
+              hdr->quantum > 0.0 &&
+              (len - sizeof(CheckpointHeader)) / sizeof(CheckpointLayer) >= hdr->layerCount;
+    const CheckpointLayer *layers = (const CheckpointLayer*)(hdr + 1);
+    for (uint32_t k = 0; ok && k < hdr->layerCount; k++) {
+        ok = layers[k].sameAs >= 0 && (uint32_t)layers[k].sameAs <= k &&
+             layers[k].offset <= len && layers[k].length <= len - layers[k].offset;
+    }
+    if (!ok) {
+        close();
+        return false;
+    }
+    header = hdr;
+    table = layers;
+    return true;
+}
+
+
+
+CarveSliceStatus SliceCheckpoint::stage() const
+{
+    return header ? (CarveSliceStatus)header->stage : INIT;
+}
+
+
+
+size_t SliceCheckpoint::layerCount() const
+{
+    return header ? header->layerCount : 0;
+}
+
+
+
+// Sets up a context to carry on slicing from the checkpoint, with the
+//  layer thickness and model bounds it was sliced with.  There's no
+//  mesh, as the layers are already carved.
+void SliceCheckpoint::applyTo(SlicingContext &ctx) const
+{
+    if (!header) {
+        return;
+    }
+    ctx.layerThickness = header->layerThickness;
+    Mesh3d &mesh = ctx.mesh;
+    mesh = Mesh3d();
+    mesh.minX = header->bounds[0];  mesh.maxX = header->bounds[1];
+    mesh.minY = header->bounds[2];  mesh.maxY = header->bounds[3];
+    mesh.minZ = header->bounds[4];  mesh.maxZ = header->bounds[5];
+    ctx.calculateSvgOffsets();
+}
+
+
+
+// The Z of each layer, and the index of the layer it repeats, or its
+//  own index if it doesn't, as from Mesh3d::findRepeatedSlices().
+void SliceCheckpoint::layerZs(vector<double> &zs, vector<int32_t> &sameAs) const
+{
+    zs.clear();
+    sameAs.clear();
+    for (size_t k = 0; k < layerCount(); k++) {
+        zs.push_back(table[k].z);
+        sameAs.push_back(table[k].sameAs);
+    }
+}
+
+
+
+// Decodes the k'th layer into the slice.  Safe to call for different
+//  layers from different threads.
+bool SliceCheckpoint::loadLayer(size_t k, CarvedSlice &slice) const
+{
+    if (k >= layerCount()) {
+        return false;
+    }
+    const CheckpointLayer &layer = table[k];
+    CompactReader in(base + layer.offset, layer.length, header->quantum);
+    if (!slice.readCompact(in) || !in.atEnd()) {
+        return false;
+    }
+    slice.zLevel = layer.z;
+    return true;
+}
+
+
+
+// Writes every layer of the context out, as left by the given stage.
+//  Layers that repeat another aren't written again; they just point
+//  at its data.  Returns false if the file couldn't be written.
+bool SliceCheckpoint::save(const string &path, const SlicingContext &ctx, const vector<double> &zs,
+                           const vector<int32_t> &sameAs, CarveSliceStatus stage)
+{
+    CheckpointHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CHECKPOINT_MAGIC, sizeof(hdr.magic));
+    hdr.version = CHECKPOINT_VERSION;
+    hdr.stage = stage;
+    hdr.byteOrder = CHECKPOINT_BYTE_ORDER;
+    hdr.layerCount = zs.size();
+    hdr.quantum = CHECKPOINT_QUANTUM;
+    hdr.layerThickness = ctx.layerThickness;
+    const Mesh3d &mesh = ctx.mesh;
+    double bounds[6] = { mesh.minX, mesh.maxX, mesh.minY, mesh.maxY, mesh.minZ, mesh.maxZ };
+    memcpy(hdr.bounds, bounds, sizeof(bounds));
+
+    vector<CheckpointLayer> layers(zs.size());
+    string data;
+    uint64_t offset = sizeof(CheckpointHeader) + zs.size() * sizeof(CheckpointLayer);
+    for (size_t k = 0; k < zs.size(); k++) {
+        CheckpointLayer &layer = layers[k];
+        memset(&layer, 0, sizeof(layer));
+        layer.z = zs[k];
+        layer.sameAs = k < sameAs.size() ? sameAs[k] : k;
+        if (layer.sameAs != (int32_t)k) {
+            layer.offset = layers[layer.sameAs].offset;
+            layer.length = layers[layer.sameAs].length;
+            continue;
+        }
+        map<float,CarvedSlice>::const_iterator it = ctx.slices.find(zs[k]);
+        if (it == ctx.slices.end()) {
+            return false;
+        }
+        CompactWriter out(CHECKPOINT_QUANTUM);
+        (*it).second.writeCompact(out);
+        layer.offset = offset + data.size();
+        layer.length = out.data().size();
+        data.append(out.data());
+    }
+
+    // Write then rename, so no reader ever sees half a file.
+    string tmpPath = path + ".XXXXXX";
+    int fd = mkstemp(&tmpPath[0]);
+    if (fd < 0) {
+        return false;
+    }
+    fchmod(fd, 0644);
+    FILE *f = fdopen(fd, "wb");
+    if (!f) {
+        ::close(fd);
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+              (layers.empty() || fwrite(&layers[0], sizeof(CheckpointLayer), layers.size(), f) == layers.size()) &&
+              fwrite(data.data(), 1, data.size(), f) == data.size();
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+
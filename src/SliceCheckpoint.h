@@ -0,0 +1,61 @@
+//
+//  SliceCheckpoint.h
+//  Mandoline
+//
+//  Created by GM on 2/24/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef SLICECHECKPOINT_H
+#define SLICECHECKPOINT_H
+
+#include <string>
+#include <vector>
+#include "CarvedSlice.h"
+#include "SlicingContext.h"
+
+using namespace std;
+
+struct CheckpointHeader;
+struct CheckpointLayer;
+
+
+// A whole model's layers, saved after some stage, so slicing can be
+//  picked up from there later, or somewhere else.  The file holds a
+//  header, a table of where each layer's data is, and then each
+//  layer as written by CarvedSlice::writeCompact().
+//
+// An open checkpoint is mapped, not read.  Only the header and table
+//  are checked when it's opened, and each layer is only decoded when
+//  it's loaded, so layers can be loaded side by side, or picked out
+//  one at a time.  Layers that repeat another share its data.
+class SliceCheckpoint {
+private:
+    const char *base;
+    size_t length;
+    const CheckpointHeader *header;
+    const CheckpointLayer *table;
+
+    // Not copyable, as it owns the mapping.
+    SliceCheckpoint(const SliceCheckpoint &);
+    SliceCheckpoint& operator=(const SliceCheckpoint &);
+
+public:
+    SliceCheckpoint();
+    ~SliceCheckpoint();
+
+    bool open(const string &path);
+    void close();
+
+    CarveSliceStatus stage() const;
+    size_t layerCount() const;
+    void applyTo(SlicingContext &ctx) const;
+    void layerZs(vector<double> &zs, vector<int32_t> &sameAs) const;
+    bool loadLayer(size_t k, CarvedSlice &slice) const;
+
+    static bool save(const string &path, const SlicingContext &ctx, const vector<double> &zs,
+                     const vector<int32_t> &sameAs, CarveSliceStatus stage);
+};
+
+#endif
+
@@ -0,0 +1,470 @@
+//
+//  SliceJob.cc
+//  Mandoline
+//
+//  Created by GM on 2/21/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/time.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include "SliceJob.h"
+#include "OpQueue.h"
+#include "SliceLayerOp.h"
+#include "MeshCache.h"
+#include "Defaults.h"
+
+
+pthread_mutex_t SliceJob::finishMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t SliceJob::finishCond = PTHREAD_COND_INITIALIZER;
+
+
+// Per-job options, named as on the command line.  Options that apply
+//  to the whole run, like -t and -m, can't be set per job.
+static struct {
+    char shortName;
+    const char *longName;
+    bool hasArg;
+} jobOptions[] = {
+    {'f', "diameter",   true},
+    {'F', "feedrate",   true},
+    {'i', "infill",     true},
+    {'l', "layer",      true},
+    {'p', "shells",     true},
+    {'R', "resolution", true},
+    {'w', "ratio",      true},
+    {'c', "nocenter",   false},
+    {'D', "noreuse",    false},
+    {'G', "progressive", false},
+    {'s', "scale",      true},
+    {'r', "rotatex",    true},
+    {'Z', "onlyatz",    true},
+    {'d', "dumpprefix", true},
+    {'T', "deadline",   true},
+    {0, NULL, false}
+};
+
+
+
+SliceJob::SliceJob()
+    : fileName(), context(), scaling(1.0f), rotation(0.0f), doCenter(true),
+      onlyAtZ(-1.0f), doDumpSVG(false), doReuse(true), progressive(false), meshCacheDir(), stageCacheDir(), deadline(0.0),
+      listener(NULL), cancellation(), stageCache(), zs(), sameAs(), failed(false), stopwatch(), layersLeft(0), finished(false)
+{
+}
+
+
+
+// Sets one option by its long name.  Returns false if the
+//  name isn't a per-job option.
+bool SliceJob::setOption(const string &name, const char *arg)
+{
+    if (name == "diameter") {
+        context.filamentDiameter = atof(arg);
+    } else if (name == "feedrate") {
+        context.filamentFeedRate = atof(arg);
+    } else if (name == "infill") {
+        context.infillDensity = atof(arg);
+    } else if (name == "layer") {
+        context.layerThickness = atof(arg);
+    } else if (name == "shells") {
+        context.perimeterShells = atoi(arg);
+    } else if (name == "resolution") {
+        context.simplifyResolution = atof(arg);
+    } else if (name == "ratio") {
+        context.widthOverHeightRatio = atof(arg);
+    } else if (name == "nocenter") {
+        doCenter = false;
+    } else if (name == "noreuse") {
+        doReuse = false;
+    } else if (name == "progressive") {
+        progressive = true;
+    } else if (name == "scale") {
+        scaling = atof(arg);
+    } else if (name == "rotatex") {
+        rotation = atof(arg);
+    } else if (name == "onlyatz") {
+        onlyAtZ = atof(arg);
+    } else if (name == "dumpprefix") {
+        doDumpSVG = true;
+        context.dumpPrefix = arg;
+    } else if (name == "deadline") {
+        deadline = atof(arg);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+
+
+// Jobs that dump SVGs under a shared prefix each get their own,
+//  named for the model, so that they don't overwrite each other.
+void SliceJob::dumpUnderPrefix(const string &prefix)
+{
+    string base = fileName.substr(fileName.find_last_of('/') + 1);
+    base = base.substr(0, base.find_last_of('.'));
+    context.dumpPrefix = prefix + "-" + base;
+}
+
+
+
+// The job's model file and every per-job option, as a line that
+//  parseLine() reads back to the same job.  Numbers are written with
+//  enough digits to come back exactly.
+string SliceJob::optionLine() const
+{
+    char buf[512];
+    snprintf(buf, sizeof(buf),
+             " --diameter %.9g --feedrate %.9g --infill %.9g --layer %.9g --shells %d"
+             " --resolution %.9g --ratio %.9g --scale %.9g --rotatex %.9g --onlyatz %.9g",
+             context.filamentDiameter, context.filamentFeedRate, context.infillDensity,
+             context.layerThickness, context.perimeterShells, context.simplifyResolution,
+             context.widthOverHeightRatio, scaling, rotation, onlyAtZ);
+    string line = fileName + buf;
+    if (!doCenter) {
+        line += " --nocenter";
+    }
+    if (!doReuse) {
+        line += " --noreuse";
+    }
+    if (progressive) {
+        line += " --progressive";
+    }
+    if (deadline > 0.0) {
+        snprintf(buf, sizeof(buf), " --deadline %.9g", deadline);
+        line += buf;
+    }
+    return line;
+}
+
+
+
+// Sets this job's model file and options from a line of words, in
+//  the form FILE [OPTIONS].  Options not on the line are left as they
+//  were.  Returns false, with a reason in error, if the line is bad.
+bool SliceJob::parseLine(const string &line, string &error)
+{
+    istringstream words(line);
+    vector<string> args;
+    string word;
+    while (words >> word) {
+        args.push_back(word);
+    }
+
+    string inheritedPrefix = context.dumpPrefix;
+    bool hasPrefix = false;
+    for (size_t i = 0; i < args.size(); i++) {
+        if (args[i][0] != '-' || args[i].length() < 2) {
+            fileName = args[i];
+            continue;
+        }
+        string name = args[i].substr(2);
+        int opt;
+        for (opt = 0; jobOptions[opt].longName; opt++) {
+            if (args[i][1] == '-' ? name == jobOptions[opt].longName :
+                    args[i].length() == 2 && args[i][1] == jobOptions[opt].shortName) {
+                break;
+            }
+        }
+        if (!jobOptions[opt].longName) {
+            error = "Unknown option " + args[i];
+            return false;
+        }
+        if (jobOptions[opt].hasArg && i+1 >= args.size()) {
+            error = "Missing value for " + args[i];
+            return false;
+        }
+        const char *arg = jobOptions[opt].hasArg ? args[++i].c_str() : "";
+        setOption(jobOptions[opt].longName, arg);
+        hasPrefix = hasPrefix || jobOptions[opt].shortName == 'd';
+    }
+    if (doDumpSVG && !hasPrefix && !fileName.empty()) {
+        dumpUnderPrefix(inheritedPrefix);
+    }
+    return true;
+}
+
+
+
+// Loads, transforms and lays out the layers of this job's model.  If
+//  the mesh was already filled in, say from a MeshCache, it's used as
+//  is.  Otherwise it may come already transformed from the on-disk
+//  cache.  Returns false if the model couldn't be loaded.
+bool SliceJob::load()
+{
+    stopwatch.start();
+    cancellation.setDeadline(deadline);
+    Mesh3d &mesh = context.mesh;
+    string cachePath;
+    bool prepared = false;
+    if (mesh.size() == 0 && !meshCacheDir.empty()) {
+        cachePath = MeshCache::preparedCachePath(meshCacheDir, fileName, scaling, rotation, doCenter);
+        prepared = !cachePath.empty() && MeshCache::loadPrepared(cachePath, mesh);
+    }
+    if (!prepared) {
+        if (mesh.size() == 0 && mesh.loadFromSTLFile(fileName.c_str()) < 1) {
+            fprintf(stderr, "Error: Couldn't load model from '%s'.\n", fileName.c_str());
+            failed = true;
+            finish();
+            return false;
+        }
+        mesh.place(scaling, rotation*M_PI/180.0f, doCenter);
+        if (!cachePath.empty()) {
+            MeshCache::savePrepared(cachePath, mesh);
+        }
+    }
+    context.calculateSvgOffsets();
+    if (!stageCacheDir.empty()) {
+        stageCache = std::make_shared<StageCache>(stageCacheDir, context);
+    }
+
+    context.calculateLayerZs(onlyAtZ, zs);
+    if (doReuse && context.canReuseLayers()) {
+        mesh.findRepeatedSlices(zs, REPEATED_LAYER_TOLERANCE, sameAs);
+    } else {
+        for (size_t k = 0; k < zs.size(); k++) {
+            sameAs.push_back(k);
+        }
+    }
+    return true;
+}
+
+
+
+// Adds one op per distinct layer to the queue.  Each op takes its
+//  layer from carving through infill, then fills in the layers that
+//  repeat it, so there's no need to wait for the whole job between
+//  stages.  Every slice is made before any op can run, since the
+//  ops hold pointers into the slice map.
+void SliceJob::addLayerOps(OpQueue *opQ)
+{
+    addLayerOps(opQ, 0, zs.size());
+}
+
+
+
+// The order to slice count layers in, coarse to fine: every
+//  PROGRESSIVE_COARSEST_STRIDEth layer, starting with the first, then
+//  every half as many, skipping those already taken, down to every
+//  layer.  Each pass fills in between the layers of the one before,
+//  so the whole part takes shape early on.
+static void progressiveOrder(size_t count, vector<size_t> &order)
+{
+    order.clear();
+    vector<bool> taken(count, false);
+    for (size_t stride = PROGRESSIVE_COARSEST_STRIDE; stride >= 1; stride /= 2) {
+        for (size_t k = 0; k < count; k += stride) {
+            if (!taken[k]) {
+                taken[k] = true;
+                order.push_back(k);
+            }
+        }
+    }
+}
+
+
+
+// As above, but for just count of the layers, starting with the first
+//  given, as for a worker slicing one band of a bigger job.  The first
+//  layer in the band that repeats one below the band is sliced for
+//  itself, and the rest that repeat that same layer reuse it.
+void SliceJob::addLayerOps(OpQueue *opQ, size_t first, size_t count)
+{
+    first = std::min(first, zs.size());
+    count = std::min(count, zs.size() - first);
+    vector<CarvedSlice*> slices(zs.size(), (CarvedSlice*)NULL);
+    for (size_t k = first; k < first + count; k++) {
+        slices[k] = context.allocSlice(zs[k]);
+    }
+    vector<SliceLayerOp*> ops(zs.size(), (SliceLayerOp*)NULL);
+    for (size_t k = first; k < first + count; k++) {
+        size_t src = sameAs[k];
+        if (src == k || (src < first && !ops[src])) {
+            ops[k] = new SliceLayerOp(this, slices[k], zs[k], opQ);
+            ops[src] = ops[k];
+        } else {
+            ops[src]->repeats.push_back(slices[k]);
+        }
+    }
+
+    pthread_mutex_lock(&finishMutex);
+    layersLeft = count;
+    pthread_mutex_unlock(&finishMutex);
+
+    if (count == 0) {
+        layersFinished(0);
+        return;
+    }
+    vector<size_t> order;
+    if (progressive) {
+        progressiveOrder(count, order);
+    } else {
+        for (size_t k = 0; k < count; k++) {
+            order.push_back(k);
+        }
+    }
+    vector<Operation*> ordered;
+    for (size_t i = 0; i < order.size(); i++) {
+        size_t k = first + order[i];
+        if (ops[k]) {
+            ordered.push_back(ops[k]);
+        }
+    }
+    opQ->addOperations(ordered);
+}
+
+
+
+// Called by each layer op as it finishes.  The last one reports on
+//  the job, and lets go of its geometry, since there's nothing left
+//  to do with it once its layers have been written out.
+void SliceJob::layersFinished(int count)
+{
+    pthread_mutex_lock(&finishMutex);
+    layersLeft -= count;
+    bool isLast = (layersLeft <= 0);
+    if (isLast) {
+        bool cancelled = cancellation.isCancelled();
+        failed = failed || cancelled;
+        char buf[512];
+        snprintf(buf, sizeof(buf), "%s %.256s, %d layers,", cancelled ? "Cancelled" : "Sliced",
+                 fileName.c_str(), (int)context.slices.size());
+        stopwatch.checkpoint(buf);
+        context.slices.clear();
+        context.mesh = Mesh3d();
+        stageCache.reset();
+    }
+    pthread_mutex_unlock(&finishMutex);
+    if (isLast) {
+        finish();
+    }
+}
+
+
+
+// Stops the job early, as when whoever's watching it has seen enough,
+//  or seen something wrong, or a newer job has taken its place.  Layers
+//  already being sliced give up partway through the stage they're on,
+//  and layers not yet started are skipped, so the job's threads go
+//  back to the queue right away.  The job still finishes, as failed,
+//  once every layer has been skipped or done.  Running past its
+//  deadline does the same.  Safe to call from a listener, on any thread.
+void SliceJob::cancel()
+{
+    cancellation.cancel();
+    pthread_mutex_lock(&finishMutex);
+    failed = true;
+    pthread_mutex_unlock(&finishMutex);
+}
+
+
+
+bool SliceJob::isCancelled()
+{
+    return cancellation.isCancelled();
+}
+
+
+
+// Marks the job done, whether it worked or not.  The listener is
+//  told before anyone waiting on the job can see it's finished.
+void SliceJob::finish()
+{
+    if (listener) {
+        listener->jobFinished(this);
+    }
+    pthread_mutex_lock(&finishMutex);
+    finished = true;
+    pthread_cond_broadcast(&finishCond);
+    pthread_mutex_unlock(&finishMutex);
+}
+
+
+
+// Waits for just this job, where OpQueue::waitUntilAllOperationsAreFinished()
+//  would wait for every job on the queue.
+void SliceJob::waitUntilFinished()
+{
+    pthread_mutex_lock(&finishMutex);
+    while (!finished) {
+        pthread_cond_wait(&finishCond, &finishMutex);
+    }
+    pthread_mutex_unlock(&finishMutex);
+}
+
+
+
+// As above, but gives up after so many seconds.  Returns whether the
+//  job finished.
+bool SliceJob::waitUntilFinished(double seconds)
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    double until = now.tv_sec + now.tv_usec / 1e6 + seconds;
+    struct timespec abstime;
+    abstime.tv_sec = (time_t)until;
+    abstime.tv_nsec = (long)((until - floor(until)) * 1e9);
+
+    pthread_mutex_lock(&finishMutex);
+    while (!finished) {
+        if (pthread_cond_timedwait(&finishCond, &finishMutex, &abstime) != 0) {
+            break;
+        }
+    }
+    bool result = finished;
+    pthread_mutex_unlock(&finishMutex);
+    return result;
+}
+
+
+
+// Reads a batch manifest, with one job per line, like:
+//    part.stl --layer 0.25 --infill 0.3 --dumpprefix out/part
+//  Options are the per-job command-line options, long or short.  Any
+//  not given come from defaults.  Blank lines and lines starting with
+//  '#' are skipped.  A manifest name of "-" reads from stdin.
+bool SliceJob::readManifest(const char *manifestName, const SliceJob &defaults, list<SliceJob> &outJobs)
+{
+    ifstream fin;
+    istream *in = &cin;
+    if (string(manifestName) != "-") {
+        fin.open(manifestName);
+        if (!fin.good()) {
+            fprintf(stderr, "Error: Couldn't open batch manifest '%s'.\n", manifestName);
+            return false;
+        }
+        in = &fin;
+    }
+
+    string line;
+    string error;
+    int lineNum = 0;
+    while (getline(*in, line)) {
+        lineNum++;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == string::npos || line[start] == '#') {
+            continue;
+        }
+
+        SliceJob job(defaults);
+        if (!job.parseLine(line, error)) {
+            fprintf(stderr, "Error: %s in %s line %d.\n", error.c_str(), manifestName, lineNum);
+            return false;
+        }
+        if (job.fileName.empty()) {
+            fprintf(stderr, "Error: No model file given in %s line %d.\n", manifestName, lineNum);
+            return false;
+        }
+        outJobs.push_back(job);
+    }
+    return true;
+}
+
+
@@ -0,0 +1,103 @@
+//
+//  SliceJob.h
+//  Mandoline
+//
+//  Created by GM on 2/21/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef SLICEJOB_H
+#define SLICEJOB_H
+
+#include <list>
+#include <vector>
+#include <string>
+#include <memory>
+#include <pthread.h>
+#include "Stopwatch.h"
+#include "SlicingContext.h"
+#include "StageCache.h"
+#include "BGL/BGLCancel.h"
+
+class OpQueue;
+class SliceJob;
+
+
+// Told about a job's progress, from whichever thread finishes each
+//  layer.  A layer's geometry is only good until its call returns.
+class SliceJobListener {
+public:
+    virtual ~SliceJobListener() {}
+    virtual void layerFinished(SliceJob *job, CarvedSlice *slice) = 0;
+    virtual void jobFinished(SliceJob *job) = 0;
+};
+
+
+
+// One model to slice in batch mode, with its own settings.  Every
+//  job's layers are sliced on the one shared OpQueue, so that small
+//  jobs keep threads busy while big ones are still carving.
+class SliceJob {
+public:
+    string fileName;
+    SlicingContext context;
+    float scaling;
+    float rotation;
+    bool  doCenter;
+    float onlyAtZ;
+    bool  doDumpSVG;
+    bool  doReuse;
+    // Slice every PROGRESSIVE_COARSEST_STRIDEth layer first, then the
+    //  ones halfway between those, and so on, rather than bottom to top.
+    bool  progressive;
+    // Where prepared models, and layers after each stage, are cached
+    //  on disk.  Empty means don't.
+    string meshCacheDir;
+    string stageCacheDir;
+    // Seconds the job may take, from when it starts loading, before it's
+    //  cancelled.  Zero means no limit.
+    double deadline;
+
+    SliceJobListener *listener;
+    // The parent of every layer op's, so cancelling the job, or running
+    //  past its deadline, cancels them all.
+    BGL::Cancellation cancellation;
+
+    // Filled in by load().
+    std::shared_ptr<StageCache> stageCache;
+    vector<double> zs;
+    vector<int32_t> sameAs;
+    bool failed;
+
+    SliceJob();
+
+    bool setOption(const string &name, const char *arg);
+    bool parseLine(const string &line, string &error);
+    string optionLine() const;
+    void dumpUnderPrefix(const string &prefix);
+    bool load();
+    void addLayerOps(OpQueue *opQ);
+    void addLayerOps(OpQueue *opQ, size_t first, size_t count);
+    void layersFinished(int count);
+    void cancel();
+    bool isCancelled();
+    void waitUntilFinished();
+    bool waitUntilFinished(double seconds);
+
+    static bool readManifest(const char *manifestName, const SliceJob &defaults, list<SliceJob> &outJobs);
+
+private:
+    void finish();
+
+    Stopwatch stopwatch;
+    int layersLeft;
+    bool finished;
+
+    // Guards layersLeft, finished and failed, and keeps job summaries from
+    //  interleaving.  finishCond is signalled whenever any job finishes.
+    static pthread_mutex_t finishMutex;
+    static pthread_cond_t finishCond;
+};
+
+#endif
+
@@ -0,0 +1,114 @@
+//
+//  SliceLayerOp.cc
+//  Mandoline
+//
+//  Created by GM on 2/21/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include "SliceLayerOp.h"
+#include "BGL/BGL.h"
+#include "SlicingContext.h"
+#include "CarvedSlice.h"
+#include "CarveOp.h"
+#include "SimplifyOp.h"
+#include "InsetOp.h"
+#include "InfillOp.h"
+#include "SvgDumpOp.h"
+#include "StageCache.h"
+
+
+
+// Only saves a stage that was finished, and not cut short by cancelling.
+static void saveStage(const StageCache* cache, CarvedSlice* slice, float z, CarveSliceStatus stage)
+{
+    if (cache && slice->state == stage) {
+        cache->save(z, *slice);
+    }
+}
+
+
+
+SliceLayerOp::SliceLayerOp(SliceJob* jb, CarvedSlice* slc, float Z, OpQueue* opQ)
+    : Operation(), zLayer(Z), job(jb), slice(slc), repeats(), queue(opQ)
+{
+    cancellation.setParent(&job->cancellation);
+}
+
+
+
+SliceLayerOp::~SliceLayerOp()
+{
+}
+
+
+
+void SliceLayerOp::main()
+{
+    if ( NULL == job ) return;
+    if ( NULL == slice ) return;
+
+    // A cancelled layer is still counted, so the job can finish.  The
+    //  op is cancelled with its job, and when it's cancelled by itself,
+    //  as by the queue's cancelAll(), the job is left short a layer, so
+    //  it's cancelled too.
+    if (isCancelled()) {
+        job->cancel();
+        job->layersFinished(1 + repeats.size());
+        return;
+    }
+
+    // With a stage cache, only the stages past where it leaves off are
+    //  run, and the layer is saved after each one.
+    SlicingContext* context = &job->context;
+    const StageCache* cache = job->stageCache.get();
+    if (cache) {
+        cache->load(zLayer, *slice);
+    }
+    if (slice->state < CARVED) {
+        CarveOp(context, slice, zLayer).main();
+        saveStage(cache, slice, zLayer, CARVED);
+    }
+    if (slice->state < SIMPLIFIED && !isCancelled()) {
+        SimplifyOp(context, slice, zLayer).main();
+        saveStage(cache, slice, zLayer, SIMPLIFIED);
+    }
+    if (slice->state < INSET && !isCancelled()) {
+        InsetOp(context, slice, zLayer).main();
+        saveStage(cache, slice, zLayer, INSET);
+    }
+    if (slice->state < INFILLED && !isCancelled()) {
+        InfillOp(context, slice, zLayer, queue).main();
+        saveStage(cache, slice, zLayer, INFILLED);
+    }
+
+    if (isCancelled()) {
+        job->cancel();
+        job->layersFinished(1 + repeats.size());
+        return;
+    }
+
+    list<CarvedSlice*>::iterator it;
+    for (it = repeats.begin(); it != repeats.end(); it++) {
+        (*it)->reuseGeometryFrom(*slice);
+    }
+
+    if (job->doDumpSVG) {
+        SvgDumpOp(context, slice, zLayer).main();
+        for (it = repeats.begin(); it != repeats.end(); it++) {
+            SvgDumpOp(context, *it, (*it)->zLevel).main();
+        }
+    }
+    if (job->listener) {
+        job->listener->layerFinished(job, slice);
+        for (it = repeats.begin(); it != repeats.end(); it++) {
+            job->listener->layerFinished(job, *it);
+        }
+    }
+
+    // The job may free this layer once it's been told, so this
+    //  must come last.
+    job->layersFinished(1 + repeats.size());
+}
+
+
@@ -0,0 +1,36 @@
+//
+//  SliceLayerOp.h
+//  Mandoline
+//
+//  Created by GM on 2/21/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef SLICELAYEROP_H
+#define SLICELAYEROP_H
+
+#include <list>
+#include "CarvedSlice.h"
+#include "SliceJob.h"
+#include "Operation.h"
+
+class OpQueue;
+
+// Takes one layer of a batch job all the way from carving to output,
+//  along with any layers that repeat it.
+class SliceLayerOp : public Operation {
+public:
+    float zLayer;
+    SliceJob* job;
+    CarvedSlice* slice;
+    list<CarvedSlice*> repeats;
+    // Big layers are infilled with help from the queue's other threads.
+    OpQueue* queue;
+
+    SliceLayerOp(SliceJob* jb, CarvedSlice* slc, float Z, OpQueue* opQ = NULL);
+    virtual ~SliceLayerOp();
+    virtual void main();
+};
+
+#endif
+
@@ -0,0 +1,130 @@
+//
+//  SlicePreview.cc
+//  Mandoline
+//
+//  Created by GM on 2/26/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <set>
+#include "SlicePreview.h"
+#include "Defaults.h"
+
+
+static const char PREVIEW_MAGIC[8] = { 'M', 'A', 'N', 'D', 'P', 'R', 'V', '\0' };
+
+
+
+// Gathers the outlines of every copy of every model at each Z any of
+//  them were carved at.
+SlicePreview::SlicePreview(list<SlicingContext> &models)
+    : layers()
+{
+    set<float> zs;
+    list<SlicingContext>::iterator mit;
+    map<float,CarvedSlice>::iterator it;
+    for (mit = models.begin(); mit != models.end(); mit++) {
+        for (it = mit->slices.begin(); it != mit->slices.end(); it++) {
+            zs.insert((*it).first);
+        }
+    }
+
+    set<float>::iterator zit;
+    for (zit = zs.begin(); zit != zs.end(); zit++) {
+        layers.push_back(make_pair(*zit, CompoundRegion()));
+        CompoundRegion &outlines = layers.back().second;
+        outlines.zLevel = *zit;
+        for (mit = models.begin(); mit != models.end(); mit++) {
+            it = mit->slices.find(*zit);
+            if (it == mit->slices.end()) {
+                continue;
+            }
+            const CompoundRegion &perimeter = (*it).second.perimeter.get();
+            if (mit->instances.empty()) {
+                outlines.subregions.insert(outlines.subregions.end(), perimeter.subregions.begin(), perimeter.subregions.end());
+            }
+            for (size_t i = 0; i < mit->instances.size(); i++) {
+                CompoundRegion placed(perimeter);
+                placed.transform(mit->instances[i]);
+                outlines.subregions.insert(outlines.subregions.end(), placed.subregions.begin(), placed.subregions.end());
+            }
+        }
+    }
+}
+
+
+
+bool SlicePreview::writeCompact(FILE *f, double quantum) const
+{
+    CompactWriter head(quantum);
+    head.writeDouble(quantum);
+    head.writeVarint(layers.size());
+    if (fwrite(PREVIEW_MAGIC, sizeof(PREVIEW_MAGIC), 1, f) != 1 ||
+        fwrite(head.data().data(), 1, head.data().size(), f) != head.data().size()) {
+        return false;
+    }
+
+    list<pair<float, CompoundRegion> >::const_iterator it;
+    for (it = layers.begin(); it != layers.end(); it++) {
+        CompactWriter layer(quantum);
+        layer.writeDouble(it->first);
+        layer.write(it->second);
+        CompactWriter size(quantum);
+        size.writeVarint(layer.data().size());
+        if (fwrite(size.data().data(), 1, size.data().size(), f) != size.data().size() ||
+            fwrite(layer.data().data(), 1, layer.data().size(), f) != layer.data().size()) {
+            return false;
+        }
+    }
+    return fflush(f) == 0;
+}
+
+
+
+// Writes one SVG document, with each layer's outlines in a group of
+//  their own, with an id like z12.34, so layers can be shown one at a
+//  time.
+void SlicePreview::writeSvg(ostream &os, const SlicingContext &plate) const
+{
+    char id[32];
+    CarvedSlice::svgHeader(os, plate.svgWidth, plate.svgHeight);
+    list<pair<float, CompoundRegion> >::const_iterator it;
+    for (it = layers.begin(); it != layers.end(); it++) {
+        snprintf(id, sizeof(id), "z%.2f", it->first);
+        os << "<g id=\"" << id << "\">\n";
+        os << "<path fill=\"none\" stroke=\"black\"";
+        os << " stroke-width=\"" << plate.standardExtrusionWidth() << "mm\"";
+        os << " d=\"" << it->second.svgPathWithOffset(plate.svgXOff, plate.svgYOff) << "\" />\n";
+        os << "</g>\n";
+    }
+    CarvedSlice::svgFooter(os);
+}
+
+
+
+// Saves the preview to a file, as SVG if its name ends in .svg, and
+//  compact otherwise.
+bool SlicePreview::save(const string &path, const SlicingContext &plate) const
+{
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".svg") == 0) {
+        fstream fout;
+        fout.open(path.c_str(), fstream::out | fstream::trunc);
+        if (!fout.good()) {
+            return false;
+        }
+        writeSvg(fout, plate);
+        fout.close();
+        return !fout.fail();
+    }
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    bool ok = writeCompact(f, PREVIEW_QUANTUM);
+    return (fclose(f) == 0) && ok;
+}
+
+
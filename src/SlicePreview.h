@@ -0,0 +1,49 @@
+//
+//  SlicePreview.h
+//  Mandoline
+//
+//  Created by GM on 2/26/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef SLICEPREVIEW_H
+#define SLICEPREVIEW_H
+
+#include <string>
+#include <list>
+#include <ostream>
+#include <stdio.h>
+#include "SlicingContext.h"
+
+using namespace std;
+
+
+// Writes out just the carved outlines of every layer of every model on
+//  the plate, with each copy placed, for a quick look at a part before
+//  slicing it for real.
+//
+// The compact form is made to be read as it comes, as from a pipe.
+//  It's the magic "MANDPRV\0", then, as written by a CompactWriter:
+//
+//    DOUBLE quantum, VARINT layers
+//    and for each layer: VARINT nbytes, then nbytes of
+//      DOUBLE z, COMPOUNDREGION outlines
+//
+//  Each layer is written by its own CompactWriter, with the quantum
+//  given up front, so it can be decoded by itself.  Doubles don't
+//  depend on the quantum, so the header can be read with any.
+class SlicePreview {
+private:
+    list<pair<float, CompoundRegion> > layers;
+
+public:
+    SlicePreview(list<SlicingContext> &models);
+
+    size_t layerCount() const { return layers.size(); }
+    bool writeCompact(FILE *f, double quantum) const;
+    void writeSvg(ostream &os, const SlicingContext &plate) const;
+    bool save(const string &path, const SlicingContext &plate) const;
+};
+
+#endif
+
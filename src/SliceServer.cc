@@ -0,0 +1,388 @@
+//
+//  SliceServer.cc
+//  Mandoline
+//
+//  Created by GM on 2/22/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <pthread.h>
+#include <new>
+#include <sstream>
+#include "SliceServer.h"
+#include "StreamIO.h"
+#include "SvgDumpOp.h"
+#include "OpQueue.h"
+#include "Defaults.h"
+
+
+struct ConnectionArgs {
+    SliceServer *server;
+    int fd;
+};
+
+
+
+// Sends each layer back to the client as an SVG, as soon as it's done.
+//  Layers finish on the worker threads, in no particular order.
+class LayerStreamer : public SliceJobListener {
+private:
+    int fd;
+    int layersDone;
+    pthread_mutex_t theMutex;
+
+public:
+    LayerStreamer(int sock) : fd(sock), layersDone(0) {
+        pthread_mutex_init(&theMutex, 0);
+    }
+    virtual ~LayerStreamer() {
+        pthread_mutex_destroy(&theMutex);
+    }
+
+    virtual void layerFinished(SliceJob *job, CarvedSlice *slice) {
+        ostringstream os;
+        SvgDumpOp(&job->context, slice, slice->zLevel).writeSvg(os);
+        string svg = os.str();
+
+        // A client that's hung up has no use for the rest of the job.
+        pthread_mutex_lock(&theMutex);
+        layersDone++;
+        if (!sendLine(fd, "LAYER %.4f %d %d %lu", slice->zLevel, layersDone, (int)job->zs.size(), (unsigned long)svg.size()) ||
+            !writeAll(fd, svg.data(), svg.size())) {
+            job->cancel();
+        }
+        pthread_mutex_unlock(&theMutex);
+    }
+
+    virtual void jobFinished(SliceJob *job) {
+    }
+};
+
+
+
+SliceServer::SliceServer(const SliceJob &jobDefaults, OpQueue *opQ)
+    : defaults(jobDefaults), queue(opQ), meshes(), socketPath(), listenFd(-1), stopping(false),
+      connectionFds(), connectionCount(0)
+{
+    pthread_mutex_init(&theMutex, 0);
+    pthread_cond_init(&theCond, 0);
+}
+
+
+
+SliceServer::~SliceServer()
+{
+    pthread_cond_destroy(&theCond);
+    pthread_mutex_destroy(&theMutex);
+}
+
+
+
+// Connects to ourselves, just so the accept() loop wakes up and
+//  notices that it's been asked to stop.
+void SliceServer::wakeListener()
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path)-1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0) {
+        connect(fd, (struct sockaddr*)&addr, sizeof(addr));
+        close(fd);
+    }
+}
+
+
+
+// Whether a client has sent more, or hung up, and so has no more use
+//  for the job it's waiting on.
+static bool clientHasMovedOn(int fd)
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    return poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLIN | POLLHUP | POLLERR));
+}
+
+
+
+// Handles one request line, reading any data that comes with it.
+//  Returns false if the connection should be closed.
+bool SliceServer::handleRequest(FILE *in, int fd, const string &line)
+{
+    istringstream words(line);
+    string command;
+    words >> command;
+    string rest;
+    getline(words, rest);
+
+    if (command == "SHUTDOWN") {
+        // Answered first, as stopping hangs up on every client.
+        sendLine(fd, "DONE 0.000");
+        stopping = true;
+        wakeListener();
+        return false;
+    }
+    if (command == "CANCEL") {
+        // Anything that was running was cancelled when this came in.
+        return sendLine(fd, "DONE 0.000");
+    }
+    if (command != "SLICE" && command != "SLICEDATA") {
+        return sendLine(fd, "ERROR Unknown request '%.64s'", command.c_str());
+    }
+
+    struct timeval start;
+    gettimeofday(&start, NULL);
+
+    string stlData;
+    if (command == "SLICEDATA") {
+        istringstream dataWords(rest);
+        long nbytes = -1;
+        dataWords >> nbytes;
+        if (nbytes < 0) {
+            sendLine(fd, "ERROR Expected SLICEDATA NBYTES");
+            return false;
+        }
+        // The data can't be skipped without reading it, so a request
+        //  that's too big ends the connection.
+        if (nbytes > SERVER_MAX_STL_BYTES) {
+            sendLine(fd, "ERROR Model data is over %ld bytes", (long)SERVER_MAX_STL_BYTES);
+            return false;
+        }
+        getline(dataWords, rest);
+        try {
+            stlData.resize(nbytes);
+        } catch (std::bad_alloc &) {
+            sendLine(fd, "ERROR Out of memory for %ld bytes of model data", nbytes);
+            return false;
+        }
+        if (nbytes > 0 && fread(&stlData[0], 1, nbytes, in) < (size_t)nbytes) {
+            return false;
+        }
+    }
+
+    SliceJob job(defaults);
+    string error;
+    if (!job.parseLine(rest, error)) {
+        return sendLine(fd, "ERROR %.256s", error.c_str());
+    }
+    bool loaded;
+    if (command == "SLICEDATA") {
+        if (job.fileName.empty()) {
+            job.fileName = "data";
+        }
+        loaded = meshes.loadData(stlData, job.context.mesh);
+    } else if (job.fileName.empty()) {
+        return sendLine(fd, "ERROR No model file given");
+    } else {
+        loaded = meshes.loadFile(job.fileName, job.context.mesh);
+    }
+    if (!loaded || !job.load()) {
+        return sendLine(fd, "ERROR Couldn't load model from '%.256s'", job.fileName.c_str());
+    }
+
+    LayerStreamer streamer(fd);
+    job.listener = &streamer;
+    if (!sendLine(fd, "STARTED %d", (int)job.zs.size())) {
+        return false;
+    }
+    // A job the client has moved on from, or that's still going when
+    //  the server's asked to stop, is cancelled, so its threads are free
+    //  for whatever comes next.
+    job.addLayerOps(queue);
+    while (!job.waitUntilFinished(SERVER_CANCEL_POLL_MSEC / 1000.0)) {
+        if (!job.isCancelled() && (stopping || clientHasMovedOn(fd))) {
+            job.cancel();
+        }
+    }
+    if (job.isCancelled()) {
+        return sendLine(fd, "CANCELLED %.3f", secondsSince(start));
+    }
+    return sendLine(fd, "DONE %.3f", secondsSince(start));
+}
+
+
+
+void SliceServer::handleConnection(int fd)
+{
+    FILE *in = fdopen(fd, "r");
+    if (!in) {
+        forgetConnectionFd(fd);
+        close(fd);
+        return;
+    }
+    char buf[4096];
+    while (!stopping && fgets(buf, sizeof(buf), in)) {
+        string line(buf);
+        line.erase(line.find_last_not_of("\r\n") + 1);
+        if (line.empty()) {
+            continue;
+        }
+        if (!handleRequest(in, fd, line)) {
+            break;
+        }
+    }
+    forgetConnectionFd(fd);
+    fclose(in);
+}
+
+
+
+// Called before a connection's socket is closed, so it's never hung
+//  up on after its fd has been reused for something else.
+void SliceServer::forgetConnectionFd(int fd)
+{
+    pthread_mutex_lock(&theMutex);
+    connectionFds.erase(fd);
+    pthread_mutex_unlock(&theMutex);
+}
+
+
+
+// Called last thing by a connection's thread.  Once the count reaches
+//  zero, the server may be destroyed under it.
+void SliceServer::connectionFinished()
+{
+    pthread_mutex_lock(&theMutex);
+    connectionCount--;
+    pthread_cond_broadcast(&theCond);
+    pthread_mutex_unlock(&theMutex);
+}
+
+
+
+// Hangs up on every client still connected, which wakes any thread
+//  waiting on one to send more, and makes the jobs they're slicing
+//  cancel, then waits for all their threads to be done with us.  Only
+//  reading is shut off at first, so each client still hears how its
+//  job ended.  One that isn't reading what it's sent could leave its
+//  thread stuck writing, though, so after a grace period, writing is
+//  shut off too.
+void SliceServer::hangUpAndWaitForConnections()
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    long usec = now.tv_usec + SERVER_HANGUP_GRACE_MSEC * 1000L;
+    struct timespec abstime;
+    abstime.tv_sec = now.tv_sec + usec / 1000000;
+    abstime.tv_nsec = (usec % 1000000) * 1000;
+
+    pthread_mutex_lock(&theMutex);
+    std::set<int>::iterator it;
+    for (it = connectionFds.begin(); it != connectionFds.end(); it++) {
+        shutdown(*it, SHUT_RD);
+    }
+    queue->cancelAll();
+    while (connectionCount > 0) {
+        if (pthread_cond_timedwait(&theCond, &theMutex, &abstime) != 0) {
+            break;
+        }
+    }
+    for (it = connectionFds.begin(); it != connectionFds.end(); it++) {
+        shutdown(*it, SHUT_RDWR);
+    }
+    while (connectionCount > 0) {
+        pthread_cond_wait(&theCond, &theMutex);
+    }
+    pthread_mutex_unlock(&theMutex);
+}
+
+
+
+void* SliceServer::connectionThread(void *arg)
+{
+    ConnectionArgs *conn = reinterpret_cast<ConnectionArgs*>(arg);
+    SliceServer *server = conn->server;
+    int fd = conn->fd;
+    delete conn;
+    server->handleConnection(fd);
+    server->connectionFinished();
+    return 0;
+}
+
+
+
+// Listens on the given socket path until asked to shut down.
+//  Returns nonzero if the socket couldn't be set up.
+int SliceServer::serve(const char *path)
+{
+    socketPath = path;
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Socket path '%s' is too long.\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    // Clients that hang up mid-reply shouldn't take the server with them.
+    signal(SIGPIPE, SIG_IGN);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        perror("socket");
+        return -1;
+    }
+    unlink(path);
+    if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 16) < 0) {
+        perror(path);
+        close(listenFd);
+        return -1;
+    }
+
+    // Keep freed layer memory around for the next job.
+    Arena::setSpareChunkLimit(SERVER_SPARE_ARENA_CHUNKS);
+
+    printf("Serving on %s\n", path);
+    fflush(stdout);
+    while (!stopping) {
+        int fd = accept(listenFd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        if (stopping) {
+            close(fd);
+            break;
+        }
+        ConnectionArgs *conn = new ConnectionArgs;
+        conn->server = this;
+        conn->fd = fd;
+        pthread_mutex_lock(&theMutex);
+        connectionFds.insert(fd);
+        connectionCount++;
+        pthread_mutex_unlock(&theMutex);
+        pthread_t thread;
+        if (pthread_create(&thread, 0, connectionThread, conn) != 0) {
+            forgetConnectionFd(fd);
+            close(fd);
+            delete conn;
+            connectionFinished();
+            continue;
+        }
+        pthread_detach(thread);
+    }
+    close(listenFd);
+    unlink(path);
+    hangUpAndWaitForConnections();
+    queue->waitUntilAllOperationsAreFinished();
+    return 0;
+}
+
+
@@ -0,0 +1,76 @@
+//
+//  SliceServer.h
+//  Mandoline
+//
+//  Created by GM on 2/22/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef SLICESERVER_H
+#define SLICESERVER_H
+
+#include <string>
+#include <set>
+#include <stdio.h>
+#include <pthread.h>
+#include "SliceJob.h"
+#include "MeshCache.h"
+
+class OpQueue;
+
+
+// Takes slicing jobs over a Unix domain socket, so that one long-lived
+//  process, with its thread pool, arenas and loaded models, can serve
+//  a stream of requests.  Each connection is served by its own thread,
+//  and may send any number of requests, one after the other:
+//
+//    SLICE FILE [OPTIONS]
+//    SLICEDATA NBYTES [NAME] [OPTIONS]   followed by NBYTES of STL data
+//    CANCEL
+//    SHUTDOWN
+//
+//  OPTIONS are the same per-job options as in a batch manifest, with
+//  the server's command line giving the defaults.  A slice request is
+//  answered with a line for each event, ending with DONE or ERROR:
+//
+//    STARTED LAYERS
+//    LAYER Z DONE_COUNT LAYERS NBYTES    followed by NBYTES of SVG
+//    DONE SECONDS
+//    CANCELLED SECONDS
+//    ERROR MESSAGE
+//
+//  Sending anything while a slice is still going, be it the next
+//  request or CANCEL, or hanging up, cancels it, and it's answered with
+//  CANCELLED rather than DONE.  So is a job that runs past its deadline,
+//  or that's still going at SHUTDOWN.  CANCEL itself is answered with
+//  DONE.
+class SliceServer {
+private:
+    SliceJob defaults;
+    OpQueue *queue;
+    MeshCache meshes;
+    string socketPath;
+    int listenFd;
+    volatile bool stopping;
+    pthread_mutex_t theMutex;
+    pthread_cond_t theCond;
+    std::set<int> connectionFds;
+    int connectionCount;
+
+    void wakeListener();
+    static void* connectionThread(void *arg);
+    void handleConnection(int fd);
+    void forgetConnectionFd(int fd);
+    void connectionFinished();
+    void hangUpAndWaitForConnections();
+    bool handleRequest(FILE *in, int fd, const string &line);
+
+public:
+    SliceServer(const SliceJob &jobDefaults, OpQueue *opQ);
+    ~SliceServer();
+
+    int serve(const char *path);
+};
+
+#endif
+
@@ -0,0 +1,164 @@
+//
+//  SliceWorker.cc
+//  Mandoline
+//
+//  Created by GM on 2/25/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include <sstream>
+#include "SliceWorker.h"
+#include "StreamIO.h"
+#include "OpQueue.h"
+#include "Defaults.h"
+
+
+
+// Sends each layer back to the coordinator, as soon as it's done, in
+//  the exact binary form, so it comes back just as it was sliced.
+class BandStreamer : public SliceJobListener {
+private:
+    int fd;
+    pthread_mutex_t theMutex;
+
+public:
+    BandStreamer(int out) : fd(out) {
+        pthread_mutex_init(&theMutex, 0);
+    }
+    virtual ~BandStreamer() {
+        pthread_mutex_destroy(&theMutex);
+    }
+
+    virtual void layerFinished(SliceJob *job, CarvedSlice *slice) {
+        BinaryWriter out;
+        slice->writeTo(out);
+
+        // A coordinator that's hung up has no use for the rest of the band.
+        pthread_mutex_lock(&theMutex);
+        if (!sendLine(fd, "LAYER %.9g %lu", slice->zLevel, (unsigned long)out.data().size()) ||
+            !writeAll(fd, out.data().data(), out.data().size())) {
+            job->cancel();
+        }
+        pthread_mutex_unlock(&theMutex);
+    }
+
+    virtual void jobFinished(SliceJob *job) {
+    }
+};
+
+
+
+SliceWorker::SliceWorker(const SliceJob &jobDefaults, OpQueue *opQ)
+    : defaults(jobDefaults), queue(opQ), meshes()
+{
+}
+
+
+
+// Handles one request line, reading any data that comes with it.
+//  Returns false if the coordinator can't be talked to any more.
+bool SliceWorker::handleRequest(FILE *in, int outFd, const string &line)
+{
+    istringstream words(line);
+    string command;
+    words >> command;
+    if (command != "BAND" && command != "BANDDATA") {
+        return sendLine(outFd, "ERROR Unknown request '%.64s'", command.c_str());
+    }
+
+    struct timeval start;
+    gettimeofday(&start, NULL);
+
+    long nbytes = 0;
+    if (command == "BANDDATA") {
+        nbytes = -1;
+        words >> nbytes;
+        if (nbytes < 0) {
+            sendLine(outFd, "ERROR Expected BANDDATA NBYTES");
+            return false;
+        }
+    }
+    long first = -1, count = -1;
+    words >> first >> count;
+    string rest;
+    getline(words, rest);
+    string stlData;
+    stlData.resize(nbytes);
+    if (nbytes > 0 && fread(&stlData[0], 1, nbytes, in) < (size_t)nbytes) {
+        return false;
+    }
+    if (first < 0 || count < 0) {
+        return sendLine(outFd, "ERROR Expected %s FIRST COUNT", command.c_str());
+    }
+
+    SliceJob job(defaults);
+    string error;
+    if (!job.parseLine(rest, error)) {
+        return sendLine(outFd, "ERROR %.256s", error.c_str());
+    }
+    bool loaded;
+    if (command == "BANDDATA") {
+        if (job.fileName.empty()) {
+            job.fileName = "data";
+        }
+        loaded = meshes.loadData(stlData, job.context.mesh);
+    } else if (job.fileName.empty()) {
+        return sendLine(outFd, "ERROR No model file given");
+    } else {
+        loaded = meshes.loadFile(job.fileName, job.context.mesh);
+    }
+    if (!loaded || !job.load()) {
+        return sendLine(outFd, "ERROR Couldn't load model from '%.256s'", job.fileName.c_str());
+    }
+    if ((size_t)first > job.zs.size() || (size_t)count > job.zs.size() - first) {
+        return sendLine(outFd, "ERROR Band %ld+%ld is outside the model's %d layers", first, count, (int)job.zs.size());
+    }
+
+    BandStreamer streamer(outFd);
+    job.listener = &streamer;
+    if (!sendLine(outFd, "STARTED %ld", count)) {
+        return false;
+    }
+    job.addLayerOps(queue, first, count);
+    job.waitUntilFinished();
+    return sendLine(outFd, "DONE %.3f", secondsSince(start));
+}
+
+
+
+// Answers requests until the coordinator hangs up.  Returns nonzero
+//  if it went away mid-request.
+int SliceWorker::serve(int inFd, int outFd)
+{
+    // A coordinator that goes away shouldn't leave us dying mid-write.
+    signal(SIGPIPE, SIG_IGN);
+    FILE *in = fdopen(inFd, "r");
+    if (!in) {
+        return -1;
+    }
+    char buf[4096];
+    int result = 0;
+    while (fgets(buf, sizeof(buf), in)) {
+        string line(buf);
+        line.erase(line.find_last_not_of("\r\n") + 1);
+        if (line.empty()) {
+            continue;
+        }
+        if (!handleRequest(in, outFd, line)) {
+            result = -1;
+            break;
+        }
+    }
+    fclose(in);
+    queue->waitUntilAllOperationsAreFinished();
+    return result;
+}
+
+
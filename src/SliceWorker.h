@@ -0,0 +1,54 @@
+//
+//  SliceWorker.h
+//  Mandoline
+//
+//  Created by GM on 2/25/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef SLICEWORKER_H
+#define SLICEWORKER_H
+
+#include <string>
+#include <stdio.h>
+#include "SliceJob.h"
+#include "MeshCache.h"
+
+class OpQueue;
+
+
+// Slices bands of layers for a coordinator, as one of a farm of worker
+//  processes.  Requests come in on one stream, one after the other,
+//  and replies go out on another, so a worker can be run over a pipe,
+//  a socket, or ssh:
+//
+//    BAND FIRST COUNT FILE [OPTIONS]
+//    BANDDATA NBYTES FIRST COUNT [NAME] [OPTIONS]   followed by NBYTES of STL data
+//
+//  A band is COUNT layers, starting with the FIRST, of the model as
+//  laid out with the given options.  FILE is a model the worker can
+//  read for itself, as on a shared disk.  Otherwise, the model comes
+//  with the request.  Either way, it's kept loaded for later bands.
+//  Each request is answered with a line for each event, ending with
+//  DONE or ERROR:
+//
+//    STARTED LAYERS
+//    LAYER Z NBYTES    followed by NBYTES of the slice, as from CarvedSlice::writeTo()
+//    DONE SECONDS
+//    ERROR MESSAGE
+class SliceWorker {
+private:
+    SliceJob defaults;
+    OpQueue *queue;
+    MeshCache meshes;
+
+    bool handleRequest(FILE *in, int outFd, const string &line);
+
+public:
+    SliceWorker(const SliceJob &jobDefaults, OpQueue *opQ);
+
+    int serve(int inFd, int outFd);
+};
+
+#endif
+
@@ -20,6 +20,7 @@ SlicingContext::SlicingContext()
     shrinkageRatio       = DEFAULT_SHRINKAGE_RATIO;
     infillDensity        = DEFAULT_INFILL_DENSITY;
     perimeterShells      = DEFAULT_PERIMETER_SHELLS;
+    simplifyResolution   = DEFAULT_SIMPLIFY_RESOLUTION;
     
     calculateSvgOffsets();
 }
@@ -27,12 +28,19 @@ SlicingContext::SlicingContext()
 
 
 void SlicingContext::calculateSvgOffsets()
+{
+    calculateSvgOffsets(mesh.minX, mesh.minY, mesh.maxX, mesh.maxY);
+}
+
+
+
+void SlicingContext::calculateSvgOffsets(double minX, double minY, double maxX, double maxY)
 {
     // Calculate offsets for SVG dumps
-    svgWidth  = 40 + mesh.maxX - mesh.minX;
-    svgHeight = 40 + mesh.maxY - mesh.minY;
-    svgXOff   = 20 - mesh.minX;
-    svgYOff   = 20 - mesh.minY;
+    svgWidth  = 40 + maxX - minX;
+    svgHeight = 40 + maxY - minY;
+    svgXOff   = 20 - minX;
+    svgYOff   = 20 - minY;
 }
 
 
@@ -53,13 +61,23 @@ float SlicingContext::standardFeedRate()
 
 
 
-float SlicingContext::standardExtrusionWidth()
+float SlicingContext::standardExtrusionWidth() const
 {
     return layerThickness * widthOverHeightRatio;
 }
 
 
 
+// A repeated layer's outline is the one below's, with the collinear
+//  points along its walls where the layer below cut them.  Only once
+//  simplifying drops those does it come out just as carving it would.
+bool SlicingContext::canReuseLayers() const
+{
+    return simplifyResolution > 0.0f;
+}
+
+
+
 float SlicingContext::ratioForWidth(float extrusionWidth)
 {
     return extrusionWidth / layerThickness;
@@ -75,12 +93,31 @@ float SlicingContext::feedRateForWidth(float extrusionWidth)
 
 
 
+// Finds the Z of every layer to slice, bottom to top.  If onlyAtZ
+//  is positive, just that one layer is sliced.
+void SlicingContext::calculateLayerZs(float onlyAtZ, vector<double> &zs)
+{
+    float z = layerThickness/2.0f;
+    float topZ = mesh.maxZ;
+    if (onlyAtZ > 0.0f) {
+        z = onlyAtZ;
+        topZ = onlyAtZ + layerThickness / 2.0f;
+    }
+    while (z < topZ) {
+        zs.push_back(z);
+        z += layerThickness;
+    }
+}
+
+
+
 CarvedSlice* SlicingContext::allocSlice(float Z)
 {
     CarvedSlice *slice = NULL;
     // TODO: pthread mutex lock
     slices[Z] = CarvedSlice();
     slice = &slices[Z];
+    slice->zLevel = Z;
     // TODO: pthread mutex unlock
     return slice;
 }
@@ -11,6 +11,7 @@
 
 
 #include <map>
+#include <vector>
 #include "BGL/BGL.h"
 #include "CarvedSlice.h"
 
@@ -28,6 +29,7 @@ public:
     float shrinkageRatio;
     float infillDensity;
     int   perimeterShells;
+    float simplifyResolution;
 
     float svgWidth;
     float svgHeight;
@@ -37,16 +39,23 @@ public:
     
     Mesh3d mesh;
     map<float,CarvedSlice> slices;
+    // Where each copy of the model goes on the build plate.  Empty
+    //  means just the one copy, right where the model is.
+    vector<Affine> instances;
     
     SlicingContext();
 
     void loadDefaultsFromFile(const char *fileName);
     void calculateSvgOffsets();
+    void calculateSvgOffsets(double minX, double minY, double maxX, double maxY);
     float standardFeedRate();
-    float standardExtrusionWidth();
+    float standardExtrusionWidth() const;
+    bool canReuseLayers() const;
     float ratioForWidth(float extrusionWidth);
     float feedRateForWidth(float extrusionWidth);
 
+    void calculateLayerZs(float onlyAtZ, vector<double> &zs);
+
     CarvedSlice* allocSlice(float Z);
     CarvedSlice* getSliceAtZ(float Z);
 };
@@ -0,0 +1,133 @@
+//
+//  StageCache.cc
+//  Mandoline
+//
+//  Created by GM on 2/23/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "StageCache.h"
+#include "CarveOp.h"
+#include "SimplifyOp.h"
+#include "InsetOp.h"
+#include "InfillOp.h"
+
+
+// Every cached layer file starts with this, then the slice as written
+//  by CarvedSlice::writeTo().  Geometry is in the machine's own byte
+//  order, so files from other machines are ignored.
+struct StageFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t byteOrder;
+};
+
+static const char STAGE_FILE_MAGIC[8] = { 'M', 'A', 'N', 'D', 'L', 'Y', 'R', '\0' };
+static const uint32_t STAGE_FILE_VERSION = 1;
+static const uint64_t STAGE_FILE_BYTE_ORDER = 0x0102030405060708ULL;
+
+
+
+// Works out the key for every cached stage.  Later stages build on
+//  the keys of the ones before them.
+StageCache::StageCache(const string &cacheDir, const SlicingContext &ctx)
+    : dir(cacheDir)
+{
+    memset(keys, 0, sizeof(keys));
+    keys[CARVED]     = CarveOp::dependencyKey(ctx, ctx.mesh.fingerprint());
+    keys[SIMPLIFIED] = SimplifyOp::dependencyKey(ctx, keys[CARVED]);
+    keys[INSET]      = InsetOp::dependencyKey(ctx, keys[SIMPLIFIED]);
+    keys[INFILLED]   = InfillOp::dependencyKey(ctx, keys[INSET]);
+}
+
+
+
+string StageCache::pathFor(CarveSliceStatus state, float Z) const
+{
+    char name[64];
+    snprintf(name, sizeof(name), "/%016llx-%010.4f.mlayer", (unsigned long long)keys[state], Z);
+    return dir + name;
+}
+
+
+
+// Fills in the slice from the latest stage cached for the layer at Z.
+//  Returns the stage it was left at, which is INIT if nothing cached
+//  was found, and the slice was left alone.
+CarveSliceStatus StageCache::load(float Z, CarvedSlice &slice) const
+{
+    static const CarveSliceStatus cached[] = { INFILLED, INSET, SIMPLIFIED, CARVED };
+    for (size_t i = 0; i < sizeof(cached) / sizeof(cached[0]); i++) {
+        string path = pathFor(cached[i], Z);
+        FILE *f = fopen(path.c_str(), "rb");
+        if (!f) {
+            continue;
+        }
+        string data;
+        char buf[65536];
+        size_t cnt;
+        while ((cnt = fread(buf, 1, sizeof(buf), f)) > 0) {
+            data.append(buf, cnt);
+        }
+        fclose(f);
+
+        const StageFileHeader *hdr = (const StageFileHeader*)data.data();
+        if (data.size() < sizeof(StageFileHeader) ||
+            memcmp(hdr->magic, STAGE_FILE_MAGIC, sizeof(hdr->magic)) ||
+            hdr->version != STAGE_FILE_VERSION ||
+            hdr->byteOrder != STAGE_FILE_BYTE_ORDER) {
+            continue;
+        }
+        BinaryReader in(data.data() + sizeof(StageFileHeader), data.size() - sizeof(StageFileHeader));
+        if (slice.readFrom(in) && in.atEnd() && slice.state == cached[i]) {
+            return slice.state;
+        }
+    }
+    return INIT;
+}
+
+
+
+// Saves the slice as the output of the stage it's now at.  Failing to
+//  save is only a lost shortcut, so it's quietly ignored.
+void StageCache::save(float Z, const CarvedSlice &slice) const
+{
+    if (slice.state < CARVED || slice.state > INFILLED) {
+        return;
+    }
+    StageFileHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, STAGE_FILE_MAGIC, sizeof(hdr.magic));
+    hdr.version = STAGE_FILE_VERSION;
+    hdr.byteOrder = STAGE_FILE_BYTE_ORDER;
+    BinaryWriter out;
+    slice.writeTo(out);
+
+    // Write then rename, so no reader ever sees half a file.
+    string path = pathFor(slice.state, Z);
+    string tmpPath = path + ".XXXXXX";
+    int fd = mkstemp(&tmpPath[0]);
+    if (fd < 0) {
+        return;
+    }
+    fchmod(fd, 0644);
+    FILE *f = fdopen(fd, "wb");
+    if (!f) {
+        close(fd);
+        unlink(tmpPath.c_str());
+        return;
+    }
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+              fwrite(out.data().data(), 1, out.data().size(), f) == out.data().size();
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+    }
+}
+
+
@@ -0,0 +1,43 @@
+//
+//  StageCache.h
+//  Mandoline
+//
+//  Created by GM on 2/23/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef STAGECACHE_H
+#define STAGECACHE_H
+
+#include <string>
+#include "CarvedSlice.h"
+#include "SlicingContext.h"
+
+using namespace std;
+
+
+// Keeps each layer's geometry on disk, as it was after each stage, so
+//  that reslicing with only some settings changed can pick up from
+//  the last stage whose output those changes leave alone.
+//
+// Each stage's output is keyed by a hash of the mesh and the settings
+//  that stage and every stage before it depend on, as given by the
+//  stages' dependencyKey()s, along with the layer's Z.  So changing the
+//  infill density, say, still finds the cached carved and inset layers.
+class StageCache {
+private:
+    string dir;
+    // Indexed by the CarveSliceStatus each stage leaves a layer in.
+    uint64_t keys[OUTPUT+1];
+
+    string pathFor(CarveSliceStatus state, float Z) const;
+
+public:
+    StageCache(const string &cacheDir, const SlicingContext &ctx);
+
+    CarveSliceStatus load(float Z, CarvedSlice &slice) const;
+    void save(float Z, const CarvedSlice &slice) const;
+};
+
+#endif
+
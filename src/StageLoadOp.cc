@@ -0,0 +1,32 @@
+//
+//  StageLoadOp.cc
+//  Mandoline
+//
+//  Created by GM on 2/23/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include "StageLoadOp.h"
+#include "StageCache.h"
+#include "CarvedSlice.h"
+
+
+
+StageLoadOp::~StageLoadOp()
+{
+}
+
+
+
+void StageLoadOp::main()
+{
+    if ( isCancelled() ) return;
+    if ( NULL == cache ) return;
+    if ( NULL == slice ) return;
+
+    cache->load(zLayer, *slice);
+
+    if ( isCancelled() ) return;
+}
+
+
@@ -0,0 +1,33 @@
+//
+//  StageLoadOp.h
+//  Mandoline
+//
+//  Created by GM on 2/23/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef STAGELOADOP_H
+#define STAGELOADOP_H
+
+#include "CarvedSlice.h"
+#include "StageCache.h"
+#include "Operation.h"
+
+// Picks a layer up from the latest stage cached for it, if any.
+//  The slice's state says which stages are left to do.
+class StageLoadOp : public Operation {
+public:
+    float zLayer;
+    const StageCache* cache;
+    CarvedSlice* slice;
+
+    StageLoadOp(const StageCache* sc, CarvedSlice* slc, float Z)
+        : Operation(), zLayer(Z), cache(sc), slice(slc)
+    {
+    }
+    virtual ~StageLoadOp();
+    virtual void main();
+};
+
+#endif
+
@@ -0,0 +1,34 @@
+//
+//  StageSaveOp.cc
+//  Mandoline
+//
+//  Created by GM on 2/23/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include "StageSaveOp.h"
+#include "StageCache.h"
+#include "CarvedSlice.h"
+
+
+
+StageSaveOp::~StageSaveOp()
+{
+    delete stageOp;
+}
+
+
+
+void StageSaveOp::main()
+{
+    if ( isCancelled() ) return;
+    if ( NULL == stageOp ) return;
+
+    stageOp->main();
+    if ( isCancelled() || stageOp->isCancelled() ) return;
+    if ( NULL == cache || NULL == slice ) return;
+
+    cache->save(zLayer, *slice);
+}
+
+
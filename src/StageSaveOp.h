@@ -0,0 +1,34 @@
+//
+//  StageSaveOp.h
+//  Mandoline
+//
+//  Created by GM on 2/23/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef STAGESAVEOP_H
+#define STAGESAVEOP_H
+
+#include "CarvedSlice.h"
+#include "StageCache.h"
+#include "Operation.h"
+
+// Runs one stage's op on a layer, then saves what it made to the
+//  stage cache.  Owns the op it runs.
+class StageSaveOp : public Operation {
+public:
+    float zLayer;
+    Operation* stageOp;
+    const StageCache* cache;
+    CarvedSlice* slice;
+
+    StageSaveOp(Operation* op, const StageCache* sc, CarvedSlice* slc, float Z)
+        : Operation(), zLayer(Z), stageOp(op), cache(sc), slice(slc)
+    {
+    }
+    virtual ~StageSaveOp();
+    virtual void main();
+};
+
+#endif
+
@@ -0,0 +1,56 @@
+//
+//  StreamIO.cc
+//  Mandoline
+//
+//  Created by GM on 2/25/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include "StreamIO.h"
+
+
+
+bool writeAll(int fd, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t cnt = write(fd, data, len);
+        if (cnt < 0 && errno == EINTR) {
+            continue;
+        }
+        if (cnt <= 0) {
+            return false;
+        }
+        data += cnt;
+        len -= cnt;
+    }
+    return true;
+}
+
+
+
+bool sendLine(int fd, const char *fmt, ...)
+{
+    char buf[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf)-1, fmt, args);
+    va_end(args);
+    strcat(buf, "\n");
+    return writeAll(fd, buf, strlen(buf));
+}
+
+
+
+double secondsSince(const struct timeval &start)
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (now.tv_sec - start.tv_sec) + (now.tv_usec - start.tv_usec) / 1.0e6;
+}
+
+
@@ -0,0 +1,23 @@
+//
+//  StreamIO.h
+//  Mandoline
+//
+//  Created by GM on 2/25/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef STREAMIO_H
+#define STREAMIO_H
+
+#include <stddef.h>
+#include <sys/time.h>
+
+// Helpers for the line-based protocols spoken over sockets and pipes,
+//  by the slicing server and by workers.
+
+bool writeAll(int fd, const char *data, size_t len);
+bool sendLine(int fd, const char *fmt, ...);
+double secondsSince(const struct timeval &start);
+
+#endif
+
@@ -23,11 +23,10 @@ SvgDumpOp::~SvgDumpOp()
 
 void SvgDumpOp::main()
 {
-    if ( isCancelled ) return;
+    if ( isCancelled() ) return;
     if ( NULL == context ) return;
-    if ( NULL == slice ) return;
+    if ( copies.empty() ) return;
 
-    float extrusionWidth = context->standardExtrusionWidth();
     char dumpFileName[512];
     snprintf(dumpFileName, sizeof(dumpFileName), "%.128s-%06.2f.svg", context->dumpPrefix.c_str(), zLayer);
 
@@ -36,10 +35,24 @@ void SvgDumpOp::main()
     if (!fout.good()) {
         return;
     }
-    slice->svgPathWithSizeAndOffset(fout, context->svgWidth, context->svgHeight, context->svgXOff, context->svgYOff, extrusionWidth);
+    writeSvg(fout);
     fout.close();
 
-    if ( isCancelled ) return;
+    if ( isCancelled() ) return;
+}
+
+
+
+// Writes the layer as a whole SVG document to any stream.
+void SvgDumpOp::writeSvg(ostream &os)
+{
+    float extrusionWidth = context->standardExtrusionWidth();
+    CarvedSlice::svgHeader(os, context->svgWidth, context->svgHeight);
+    list<pair<CarvedSlice*, Affine> >::const_iterator it;
+    for (it = copies.begin(); it != copies.end(); it++) {
+        it->first->svgPathsWithPlacementAndOffset(os, it->second, context->svgXOff, context->svgYOff, extrusionWidth);
+    }
+    CarvedSlice::svgFooter(os);
 }
 
 
@@ -9,6 +9,8 @@
 #ifndef SVGDUMPOP_H
 #define SVGDUMPOP_H
 
+#include <list>
+#include <utility>
 #include "CarvedSlice.h"
 #include "SlicingContext.h"
 #include "Operation.h"
@@ -17,14 +19,25 @@ class SvgDumpOp : public Operation {
 public:
     float zLayer;
     SlicingContext* context;
-    CarvedSlice* slice;
+    // Each copy of a model on the plate at this layer, and where it goes.
+    list<pair<CarvedSlice*, Affine> > copies;
 
+    SvgDumpOp(SlicingContext* ctx, float Z)
+        : Operation(), zLayer(Z), context(ctx), copies()
+    {
+    }
     SvgDumpOp(SlicingContext* ctx, CarvedSlice* slc, float Z)
-        : Operation(), zLayer(Z), context(ctx), slice(slc)
+        : Operation(), zLayer(Z), context(ctx), copies()
     {
+        addCopy(slc, Affine());
     }
     virtual ~SvgDumpOp();
     virtual void main();
+    void writeSvg(ostream &os);
+
+    void addCopy(CarvedSlice* slc, const Affine& placement) {
+        copies.push_back(make_pair(slc, placement));
+    }
 };
 
 #endif
@@ -0,0 +1,294 @@
+//
+//  WorkerPool.cc
+//  Mandoline
+//
+//  Created by GM on 2/25/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sstream>
+#include "WorkerPool.h"
+#include "StreamIO.h"
+#include "Defaults.h"
+
+
+struct WorkerThreadArgs {
+    WorkerPool *pool;
+    void *worker;
+};
+
+
+
+WorkerPool::WorkerPool()
+    : workers(), shipMesh(false), context(NULL), request(), stlData(), bandsLeft(), firstError()
+{
+    pthread_mutex_init(&theMutex, 0);
+}
+
+
+
+// Hanging up on the workers tells them to finish.
+WorkerPool::~WorkerPool()
+{
+    for (size_t i = 0; i < workers.size(); i++) {
+        if (workers[i].alive) {
+            close(workers[i].toFd);
+        }
+        fclose(workers[i].from);
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        waitpid(workers[i].pid, NULL, 0);
+    }
+    pthread_mutex_destroy(&theMutex);
+}
+
+
+
+// Starts count workers.  With no command, each is this program, run
+//  with selfArgs.  Otherwise each is the shell command, which gets the
+//  worker's number in $MANDOLINE_WORKER.  Returns false if any couldn't
+//  be started.
+bool WorkerPool::start(int count, const vector<string> &selfArgs, const string &command)
+{
+    shipMesh = !command.empty();
+    // Workers that die shouldn't take us with them when we write to them.
+    signal(SIGPIPE, SIG_IGN);
+
+    for (int i = 0; i < count; i++) {
+        int toWorker[2], fromWorker[2];
+        if (pipe(toWorker) < 0) {
+            return false;
+        }
+        if (pipe(fromWorker) < 0) {
+            close(toWorker[0]);
+            close(toWorker[1]);
+            return false;
+        }
+        // Our ends mustn't leak into later workers, or they'd never see
+        //  us hang up.
+        fcntl(toWorker[1], F_SETFD, FD_CLOEXEC);
+        fcntl(fromWorker[0], F_SETFD, FD_CLOEXEC);
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            dup2(toWorker[0], STDIN_FILENO);
+            dup2(fromWorker[1], STDOUT_FILENO);
+            close(toWorker[0]);
+            close(fromWorker[1]);
+            if (command.empty()) {
+                vector<char*> argv;
+                for (size_t j = 0; j < selfArgs.size(); j++) {
+                    argv.push_back(const_cast<char*>(selfArgs[j].c_str()));
+                }
+                argv.push_back(NULL);
+                execvp(argv[0], &argv[0]);
+            } else {
+                char num[16];
+                snprintf(num, sizeof(num), "%d", i);
+                setenv("MANDOLINE_WORKER", num, 1);
+                execl("/bin/sh", "sh", "-c", command.c_str(), (char*)NULL);
+            }
+            perror("Worker");
+            _exit(127);
+        }
+        close(toWorker[0]);
+        close(fromWorker[1]);
+        if (pid < 0) {
+            close(toWorker[1]);
+            close(fromWorker[0]);
+            return false;
+        }
+        FILE *from = fdopen(fromWorker[0], "r");
+        if (!from) {
+            close(toWorker[1]);
+            close(fromWorker[0]);
+            kill(pid, SIGKILL);
+            waitpid(pid, NULL, 0);
+            return false;
+        }
+        Worker worker;
+        worker.pid = pid;
+        worker.toFd = toWorker[1];
+        worker.from = from;
+        worker.alive = true;
+        workers.push_back(worker);
+    }
+    return true;
+}
+
+
+
+// Sends one band to a worker, and reads its layers into the context
+//  as they come back.  Returns false, with a reason, if the band
+//  wasn't all sliced.
+bool WorkerPool::sliceBand(Worker &worker, size_t first, size_t count, string &error)
+{
+    char head[64];
+    if (shipMesh) {
+        snprintf(head, sizeof(head), "BANDDATA %lu %lu %lu ", (unsigned long)stlData.size(), (unsigned long)first, (unsigned long)count);
+    } else {
+        snprintf(head, sizeof(head), "BAND %lu %lu ", (unsigned long)first, (unsigned long)count);
+    }
+    string line = head + request + "\n";
+    if (!writeAll(worker.toFd, line.data(), line.size()) ||
+        (shipMesh && !writeAll(worker.toFd, stlData.data(), stlData.size()))) {
+        error = "Worker hung up";
+        return false;
+    }
+
+    size_t layersDone = 0;
+    char buf[1024];
+    string data;
+    while (fgets(buf, sizeof(buf), worker.from)) {
+        istringstream words(buf);
+        string event;
+        words >> event;
+        if (event == "STARTED") {
+            continue;
+        } else if (event == "LAYER") {
+            float z = 0.0f;
+            unsigned long nbytes = 0;
+            words >> z >> nbytes;
+            data.resize(nbytes);
+            if (nbytes > 0 && fread(&data[0], 1, nbytes, worker.from) < nbytes) {
+                break;
+            }
+            // Every slice was made up front, so finding one doesn't
+            //  change the map under the other threads.
+            map<float,CarvedSlice>::iterator it = context->slices.find(z);
+            if (it == context->slices.end()) {
+                error = "Worker sent an unknown layer";
+                return false;
+            }
+            BinaryReader in(data.data(), data.size());
+            if (!(*it).second.readFrom(in) || !in.atEnd()) {
+                error = "Worker sent a damaged layer";
+                return false;
+            }
+            layersDone++;
+        } else if (event == "DONE") {
+            if (layersDone != count) {
+                error = "Worker sent too few layers";
+                return false;
+            }
+            return true;
+        } else {
+            string rest;
+            getline(words, rest);
+            error = "Worker failed:" + rest;
+            return false;
+        }
+    }
+    error = "Worker hung up";
+    return false;
+}
+
+
+
+// Hands bands to one worker until there are none left, or it fails.
+//  A worker that fails may be part way through a reply, so it's hung
+//  up on, and not used again.
+void WorkerPool::runWorker(Worker &worker)
+{
+    while (true) {
+        pthread_mutex_lock(&theMutex);
+        if (bandsLeft.empty()) {
+            pthread_mutex_unlock(&theMutex);
+            return;
+        }
+        pair<size_t,size_t> band = bandsLeft.front();
+        bandsLeft.pop_front();
+        pthread_mutex_unlock(&theMutex);
+
+        string error;
+        if (!sliceBand(worker, band.first, band.second, error)) {
+            pthread_mutex_lock(&theMutex);
+            bandsLeft.push_back(band);
+            if (firstError.empty()) {
+                firstError = error;
+            }
+            pthread_mutex_unlock(&theMutex);
+            worker.alive = false;
+            close(worker.toFd);
+            return;
+        }
+    }
+}
+
+
+
+void* WorkerPool::workerThread(void *arg)
+{
+    WorkerThreadArgs *args = reinterpret_cast<WorkerThreadArgs*>(arg);
+    args->pool->runWorker(*reinterpret_cast<Worker*>(args->worker));
+    return 0;
+}
+
+
+
+// Slices every layer of the job's model at the given Zs, on the
+//  workers, into the context.  Returns false if any band couldn't be
+//  sliced by any worker.
+bool WorkerPool::slice(SlicingContext &ctx, const SliceJob &job, const vector<double> &zs)
+{
+    context = &ctx;
+    request = job.optionLine();
+    firstError.clear();
+    stlData.clear();
+    if (shipMesh) {
+        FILE *f = fopen(job.fileName.c_str(), "rb");
+        if (!f) {
+            fprintf(stderr, "Error: Couldn't read model from '%s' to send to workers.\n", job.fileName.c_str());
+            return false;
+        }
+        char buf[65536];
+        size_t cnt;
+        while ((cnt = fread(buf, 1, sizeof(buf), f)) > 0) {
+            stlData.append(buf, cnt);
+        }
+        fclose(f);
+        request = "model.stl" + request.substr(job.fileName.size());
+    }
+
+    for (size_t k = 0; k < zs.size(); k++) {
+        ctx.allocSlice(zs[k]);
+    }
+    size_t bandCount = workers.size() * WORKER_BANDS_PER_WORKER;
+    size_t bandSize = (zs.size() + bandCount - 1) / bandCount;
+    bandsLeft.clear();
+    for (size_t first = 0; first < zs.size(); first += bandSize) {
+        bandsLeft.push_back(make_pair(first, std::min(bandSize, zs.size() - first)));
+    }
+
+    vector<pthread_t> threads(workers.size());
+    vector<WorkerThreadArgs> args(workers.size());
+    size_t started = 0;
+    for (size_t i = 0; i < workers.size(); i++) {
+        args[i].pool = this;
+        args[i].worker = &workers[i];
+        if (workers[i].alive && pthread_create(&threads[started], 0, workerThread, &args[i]) == 0) {
+            started++;
+        }
+    }
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (!bandsLeft.empty()) {
+        if (firstError.empty()) {
+            firstError = "No workers";
+        }
+        fprintf(stderr, "Error: %d bands weren't sliced.  %s.\n", (int)bandsLeft.size(), firstError.c_str());
+        return false;
+    }
+    return true;
+}
+
+
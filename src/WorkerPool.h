@@ -0,0 +1,71 @@
+//
+//  WorkerPool.h
+//  Mandoline
+//
+//  Created by GM on 2/25/11.
+//  Copyright 2011 Belfry DevWorks. All rights reserved.
+//
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <stdio.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include "SlicingContext.h"
+#include "SliceJob.h"
+
+using namespace std;
+
+
+// Farms a model's layers out to worker processes, each running a
+//  SliceWorker on the other end of a pair of pipes.  The layers are
+//  split into contiguous Z-bands, several per worker, and each worker
+//  is handed the next band as soon as it's done with its last, so a
+//  slow worker only holds up the bands it has.  If a worker goes away,
+//  its band goes back on the list for the others.
+//
+// Workers are either more copies of this program, which read the model
+//  from the same file, or are started by a shell command, such as one
+//  that runs a worker over ssh.  Those get the model sent to them.
+class WorkerPool {
+private:
+    struct Worker {
+        pid_t pid;
+        int toFd;
+        FILE *from;
+        bool alive;
+    };
+    vector<Worker> workers;
+    bool shipMesh;
+
+    // What's being sliced, shared by the threads talking to workers.
+    pthread_mutex_t theMutex;
+    SlicingContext *context;
+    string request;
+    string stlData;
+    list< pair<size_t,size_t> > bandsLeft;
+    string firstError;
+
+    static void* workerThread(void *arg);
+    void runWorker(Worker &worker);
+    bool sliceBand(Worker &worker, size_t first, size_t count, string &error);
+
+    // Not copyable, as it owns the workers.
+    WorkerPool(const WorkerPool &);
+    WorkerPool& operator=(const WorkerPool &);
+
+public:
+    WorkerPool();
+    ~WorkerPool();
+
+    bool start(int count, const vector<string> &selfArgs, const string &command);
+    size_t size() const { return workers.size(); }
+    bool slice(SlicingContext &ctx, const SliceJob &job, const vector<double> &zs);
+};
+
+#endif
+